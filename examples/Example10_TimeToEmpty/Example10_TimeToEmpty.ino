@@ -0,0 +1,91 @@
+/*!
+ * @file Example10_TimeToEmpty.ino
+ * 
+ * @mainpage SparkFun smôl Power Board Arduino Library
+ * 
+ * @section intro_sec Examples
+ * 
+ * This example shows how to estimate how long the battery will last.
+ * Each minute, the battery voltage is converted to the remaining capacity using a discharge curve.
+ * A straight line is fitted to the last 32 samples. Its slope gives the discharge rate.
+ * The confidence shows how well the samples fit the line (0-100).
+ * 
+ * For the smôl Power Board LiPo, change smolPowerAAA to smolPowerLiPo:
+ * the MAX17048 state of charge and change rate are used instead of the discharge curve.
+ * 
+ * Want to support open source hardware? Buy a board from SparkFun!
+ * SparkX smôl Power Board LiPo (SPX-18622): https://www.sparkfun.com/products/18622
+ * SparkX smôl Power Board AAA (SPX-18621): https://www.sparkfun.com/products/18621
+ * SparkX smôl ESP32 (SPX-18619): https://www.sparkfun.com/products/18619
+ * 
+ * @section author Author
+ * 
+ * This library was written by:
+ * Paul Clark
+ * SparkFun Electronics
+ * July 23rd 2021
+ * 
+ * @section license License
+ * 
+ * MIT: please see LICENSE.md for the full license information
+ * 
+ */
+
+#include <Wire.h>
+
+#include <SparkFun_MAX1704x_Fuel_Gauge_Arduino_Library.h> // Click here to get the library: http://librarymanager/All#SparkFun_MAX1704x_Fuel_Gauge_Arduino_Library
+#include <SparkFun_smol_Power_Board.h> //Click here to get the library:  http://librarymanager/All#SparkFun_smol_Power_Board
+#include <SparkFun_smol_Power_Board_Runtime.h>
+
+smolPowerAAA myPowerBoard;
+
+sfeSmolPowerRuntime<32> runtime; // Fit the last 32 samples
+
+unsigned long lastSample = 0;
+
+void setup()
+{
+  Serial.begin(115200);
+  while (!Serial)
+    ; // Wait for the user to open the Serial console
+  Serial.println(F("smôl Power Board example"));
+  Serial.println();
+
+  Wire.begin();
+
+  if (myPowerBoard.begin() == false) // Begin communication with the power board using the default I2C address (0x50) and the Wire port
+  {
+    Serial.println(F("Could not communicate with the power board. Please check the I2C connections. Freezing..."));
+    while (1)
+      ;
+  }
+}
+
+void loop()
+{
+  if ((lastSample != 0) && (millis() - lastSample < 60000))
+    return; // Sample once per minute
+
+  lastSample = millis();
+  if (runtime.sample(myPowerBoard) == false)
+    return;
+
+  sfe_power_board_runtime_t estimate;
+  if (runtime.getEstimate(estimate) == false)
+  {
+    Serial.println(F("Collecting samples..."));
+    return;
+  }
+
+  Serial.print(F("Capacity (0.01%): "));
+  Serial.print(estimate.capacity);
+  Serial.print(F("  Rate (0.01%/hr): "));
+  Serial.print(estimate.rateCentiPercentPerHour);
+  Serial.print(F("  Time to empty (minutes): "));
+  if (estimate.secondsRemaining == SFE_SMOL_POWER_RUNTIME_UNKNOWN)
+    Serial.print(F("unknown"));
+  else
+    Serial.print(estimate.secondsRemaining / 60);
+  Serial.print(F("  Confidence: "));
+  Serial.println(estimate.confidence);
+}
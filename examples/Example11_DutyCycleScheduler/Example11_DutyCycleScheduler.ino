@@ -0,0 +1,97 @@
+/*!
+ * @file Example11_DutyCycleScheduler.ino
+ * 
+ * @mainpage SparkFun smôl Power Board Arduino Library
+ * 
+ * @section intro_sec Examples
+ * 
+ * This example shows how to let the library choose the power-down duration.
+ * The scheduler aims to make the battery last for the target lifetime: it stretches the sleep
+ * as the battery sags and shortens it when there is headroom.
+ * 
+ * powerDownNow removes the power from the host. The scheduler state is saved in EEPROM
+ * before each power-down and restored after waking. This example needs a board with EEPROM (or EEPROM emulation).
+ * 
+ * Want to support open source hardware? Buy a board from SparkFun!
+ * SparkX smôl Power Board LiPo (SPX-18622): https://www.sparkfun.com/products/18622
+ * SparkX smôl Power Board AAA (SPX-18621): https://www.sparkfun.com/products/18621
+ * SparkX smôl ESP32 (SPX-18619): https://www.sparkfun.com/products/18619
+ * 
+ * @section author Author
+ * 
+ * This library was written by:
+ * Paul Clark
+ * SparkFun Electronics
+ * July 23rd 2021
+ * 
+ * @section license License
+ * 
+ * MIT: please see LICENSE.md for the full license information
+ * 
+ */
+
+#include <Wire.h>
+#include <EEPROM.h>
+
+#include <SparkFun_MAX1704x_Fuel_Gauge_Arduino_Library.h> // Click here to get the library: http://librarymanager/All#SparkFun_MAX1704x_Fuel_Gauge_Arduino_Library
+#include <SparkFun_smol_Power_Board.h> //Click here to get the library:  http://librarymanager/All#SparkFun_smol_Power_Board
+#include <SparkFun_smol_Power_Board_Scheduler.h>
+
+smolPowerLiPo myPowerBoard;
+
+sfeSmolPowerScheduler scheduler;
+
+void setup()
+{
+  Serial.begin(115200);
+  Serial.println(F("smôl Power Board example"));
+  Serial.println();
+
+  Wire.begin();
+
+  if (myPowerBoard.begin() == false) // Begin communication with the power board using the default I2C address (0x50) and the Wire port
+  {
+    Serial.println(F("Could not communicate with the power board. Please check the I2C connections. Freezing..."));
+    while (1)
+      ;
+  }
+
+  scheduler.setSleepLimits(10000, 3600000); // Report at least once per hour, but no more than every 10 seconds
+  scheduler.setTargetLifetime(30UL * 24 * 60 * 60); // Make the battery last 30 days
+
+#if defined(ARDUINO_ARCH_ESP32)
+  EEPROM.begin(sizeof(sfe_power_board_schedule_state_t));
+#endif
+
+  sfe_power_board_schedule_state_t state;
+  EEPROM.get(0, state);
+  if (state.sleepMS != 0xFFFFFFFF) // Erased EEPROM reads as 0xFF: start a new schedule
+    scheduler.setState(state);
+}
+
+void loop()
+{
+  // Do the work: take a reading and report it
+  uint16_t capacity = myPowerBoard.getSOCCentiPercent();
+  Serial.print(F("State of charge (0.01%): "));
+  Serial.println(capacity);
+
+  // Choose the next sleep interval, save the scheduler state, then power down
+  unsigned long sleepMS = scheduler.nextSleepMS(millis(), capacity); // The host has been awake since it powered up
+
+  sfe_power_board_schedule_state_t state;
+  scheduler.getState(state);
+  EEPROM.put(0, state);
+#if defined(ARDUINO_ARCH_ESP32)
+  EEPROM.commit();
+#endif
+
+  Serial.print(F("Sleeping for (ms): "));
+  Serial.println(sleepMS);
+  Serial.flush();
+
+  myPowerBoard.powerDownFor(sleepMS);
+
+  delay(1000);
+  Serial.println(F("The power down failed. Trying again..."));
+}
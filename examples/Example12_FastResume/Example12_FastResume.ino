@@ -0,0 +1,101 @@
+/*!
+ * @file Example12_FastResume.ino
+ * 
+ * @mainpage SparkFun smôl Power Board Arduino Library
+ * 
+ * @section intro_sec Examples
+ * 
+ * This example shows how to shorten the time from waking to the first useful work.
+ * powerDownNow removes the power from the host, so it cold-boots after each power-down.
+ * Instead of the full begin handshake, resume restores the board's identity and configuration
+ * from a state saved in EEPROM, and checks the board by reading its address and reset reason.
+ * This example needs a board with EEPROM (or EEPROM emulation).
+ * 
+ * Want to support open source hardware? Buy a board from SparkFun!
+ * SparkX smôl Power Board LiPo (SPX-18622): https://www.sparkfun.com/products/18622
+ * SparkX smôl Power Board AAA (SPX-18621): https://www.sparkfun.com/products/18621
+ * SparkX smôl ESP32 (SPX-18619): https://www.sparkfun.com/products/18619
+ * 
+ * @section author Author
+ * 
+ * This library was written by:
+ * Paul Clark
+ * SparkFun Electronics
+ * July 23rd 2021
+ * 
+ * @section license License
+ * 
+ * MIT: please see LICENSE.md for the full license information
+ * 
+ */
+
+#include <Wire.h>
+#include <EEPROM.h>
+
+#include <SparkFun_MAX1704x_Fuel_Gauge_Arduino_Library.h> // Click here to get the library: http://librarymanager/All#SparkFun_MAX1704x_Fuel_Gauge_Arduino_Library
+#include <SparkFun_smol_Power_Board.h> //Click here to get the library:  http://librarymanager/All#SparkFun_smol_Power_Board
+
+smolPowerAAA myPowerBoard;
+
+void setup()
+{
+  unsigned long startMillis = millis();
+
+  Serial.begin(115200);
+  Serial.println(F("smôl Power Board example"));
+  Serial.println();
+
+  Wire.begin();
+
+#if defined(ARDUINO_ARCH_ESP32)
+  EEPROM.begin(sizeof(sfe_power_board_resume_t));
+#endif
+
+  sfe_power_board_resume_t state;
+  EEPROM.get(0, state);
+
+  byte resetReason;
+  if (myPowerBoard.resume(state, Wire, &resetReason)) // Fails if the state is invalid (e.g. the first time) or the board does not respond
+  {
+    Serial.print(F("Resumed in (ms): "));
+    Serial.println(millis() - startMillis);
+  }
+  else if (myPowerBoard.begin() == false) // Fall back to begin: the default I2C address (0x50) and the Wire port
+  {
+    Serial.println(F("Could not communicate with the power board. Please check the I2C connections. Freezing..."));
+    while (1)
+      ;
+  }
+  else
+  {
+    Serial.print(F("Began in (ms): "));
+    Serial.println(millis() - startMillis);
+  }
+}
+
+void loop()
+{
+  // Do the work: take a reading and report it
+  Serial.print(F("Battery voltage (mV): "));
+  Serial.println(myPowerBoard.getBatteryMillivolts());
+
+  // Configure the power-down, save the resume state, then power down.
+  // The state is saved after the configuration has changed, so it is up to date after waking
+  if (myPowerBoard.configurePowerDown(10000)) // Power down for 10 seconds
+  {
+    sfe_power_board_resume_t state;
+    myPowerBoard.saveResumeState(state);
+    EEPROM.put(0, state);
+#if defined(ARDUINO_ARCH_ESP32)
+    EEPROM.commit();
+#endif
+
+    Serial.println(F("Powering down..."));
+    Serial.flush();
+
+    myPowerBoard.powerDownNow();
+  }
+
+  delay(1000);
+  Serial.println(F("The power down failed. Trying again..."));
+}
@@ -0,0 +1,91 @@
+/*!
+ * @file Example13_BatteryEvents.ino
+ * 
+ * @mainpage SparkFun smôl Power Board Arduino Library
+ * 
+ * @section intro_sec Examples
+ * 
+ * This example shows how to react to low battery, over-temperature and ATtiny43U resets
+ * using the event engine. Each rule has hysteresis and a debounce count, so the callbacks
+ * are only called when the state really changes - not each time the reading wobbles
+ * around the threshold.
+ * 
+ * Want to support open source hardware? Buy a board from SparkFun!
+ * SparkX smôl Power Board LiPo (SPX-18622): https://www.sparkfun.com/products/18622
+ * SparkX smôl Power Board AAA (SPX-18621): https://www.sparkfun.com/products/18621
+ * SparkX smôl ESP32 (SPX-18619): https://www.sparkfun.com/products/18619
+ * 
+ * @section author Author
+ * 
+ * This library was written by:
+ * Paul Clark
+ * SparkFun Electronics
+ * July 23rd 2021
+ * 
+ * @section license License
+ * 
+ * MIT: please see LICENSE.md for the full license information
+ * 
+ */
+
+#include <Wire.h>
+
+#include <SparkFun_MAX1704x_Fuel_Gauge_Arduino_Library.h> // Click here to get the library: http://librarymanager/All#SparkFun_MAX1704x_Fuel_Gauge_Arduino_Library
+#include <SparkFun_smol_Power_Board.h> //Click here to get the library:  http://librarymanager/All#SparkFun_smol_Power_Board
+#include <SparkFun_smol_Power_Board_Events.h>
+
+smolPowerAAA myPowerBoard;
+
+sfeSmolPowerEvents<> events;
+
+void lowBattery(const sfe_power_board_event_t &event)
+{
+  Serial.print(event.active ? F("Battery low: ") : F("Battery OK again: "));
+  Serial.print(event.value);
+  Serial.println(F("mV"));
+}
+
+void overTemperature(const sfe_power_board_event_t &event)
+{
+  Serial.print(event.active ? F("Too hot: ") : F("Cooled down: "));
+  Serial.print(((float)event.value) / 100.0f, 2);
+  Serial.println(F("C"));
+}
+
+void powerBoardReset(const sfe_power_board_event_t &event)
+{
+  if (event.rule == SFE_SMOL_POWER_RESET_REASON_BORF)
+    Serial.println(F("The ATtiny43U was reset by a brown-out"));
+  else if (event.rule == SFE_SMOL_POWER_RESET_REASON_WDRF)
+    Serial.println(F("The ATtiny43U was reset by its watchdog"));
+  else if (event.rule == SFE_SMOL_POWER_EEPROM_CORRUPT_ON_RESET)
+    Serial.println(F("The ATtiny43U eeprom was corrupt and has been reset to the default settings"));
+}
+
+void setup()
+{
+  Serial.begin(115200);
+  Serial.println(F("smôl Power Board example"));
+  Serial.println();
+
+  Wire.begin();
+
+  if (myPowerBoard.begin() == false) // Begin communication with the power board using the default I2C address (0x50) and the Wire port
+  {
+    Serial.println(F("Could not communicate with the power board. Please check the I2C connections. Freezing..."));
+    while (1)
+      ;
+  }
+
+  events.onLowBattery(1100, 50, 3, lowBattery); // Low below 1.1V, OK again above 1.15V. 3 readings in a row are needed either way
+  events.onOverTemperature(4500, 500, 2, overTemperature); // Too hot above 45C, cooled down below 40C
+  events.onReset(powerBoardReset); // Brown-out, watchdog and eeprom corrupt resets. Each is reported once
+}
+
+void loop()
+{
+  events.sample(myPowerBoard); // One telemetry read for all of the rules
+  events.service(); // Call the callbacks for any changes. No bus traffic
+
+  delay(1000);
+}
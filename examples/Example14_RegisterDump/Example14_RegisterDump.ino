@@ -0,0 +1,87 @@
+/*!
+ * @file Example14_RegisterDump.ino
+ * 
+ * @mainpage SparkFun smôl Power Board Arduino Library
+ * 
+ * @section intro_sec Examples
+ * 
+ * This example shows how to capture every ATtiny43U register in one call, and pack them
+ * into a 17-byte CRC-protected record which can be sent over a low-bandwidth radio link.
+ * The receiver can unpack the record with deserializeRegisterDump.
+ * 
+ * Want to support open source hardware? Buy a board from SparkFun!
+ * SparkX smôl Power Board LiPo (SPX-18622): https://www.sparkfun.com/products/18622
+ * SparkX smôl Power Board AAA (SPX-18621): https://www.sparkfun.com/products/18621
+ * SparkX smôl ESP32 (SPX-18619): https://www.sparkfun.com/products/18619
+ * 
+ * @section author Author
+ * 
+ * This library was written by:
+ * Paul Clark
+ * SparkFun Electronics
+ * July 23rd 2021
+ * 
+ * @section license License
+ * 
+ * MIT: please see LICENSE.md for the full license information
+ * 
+ */
+
+#include <Wire.h>
+
+#include <SparkFun_MAX1704x_Fuel_Gauge_Arduino_Library.h> // Click here to get the library: http://librarymanager/All#SparkFun_MAX1704x_Fuel_Gauge_Arduino_Library
+#include <SparkFun_smol_Power_Board.h> //Click here to get the library:  http://librarymanager/All#SparkFun_smol_Power_Board
+
+smolPowerAAA myPowerBoard;
+
+void setup()
+{
+  Serial.begin(115200);
+  Serial.println(F("smôl Power Board example"));
+  Serial.println();
+
+  Wire.begin();
+
+  if (myPowerBoard.begin() == false) // Begin communication with the power board using the default I2C address (0x50) and the Wire port
+  {
+    Serial.println(F("Could not communicate with the power board. Please check the I2C connections. Freezing..."));
+    while (1)
+      ;
+  }
+}
+
+void loop()
+{
+  sfe_power_board_register_dump_t dump;
+  if (myPowerBoard.dumpRegisters(dump) == false) // Read all of the registers. dump.valid shows which could be read
+  {
+    Serial.print(F("Some registers could not be read. Valid registers: 0x"));
+    Serial.println(dump.valid, HEX);
+  }
+
+  byte record[SFE_SMOL_POWER_DUMP_RECORD_SIZE];
+  byte recordSize = myPowerBoard.serializeRegisterDump(dump, record, sizeof(record)); // Pack the dump into the record
+
+  Serial.print(F("Record: "));
+  for (byte i = 0; i < recordSize; i++) // This is what would be sent over the radio
+  {
+    if (record[i] < 0x10)
+      Serial.print(F("0"));
+    Serial.print(record[i], HEX);
+    Serial.print(F(" "));
+  }
+  Serial.println();
+
+  sfe_power_board_register_dump_t received;
+  if (myPowerBoard.deserializeRegisterDump(record, recordSize, received)) // Check the version and CRC, then unpack
+  {
+    Serial.print(F("Reset reason: 0x"));
+    Serial.print(received.resetReason, HEX);
+    Serial.print(F("  Raw VBAT: "));
+    Serial.print(received.rawVBAT);
+    Serial.print(F("  Firmware version: 0x"));
+    Serial.println(received.firmwareVersion, HEX);
+  }
+
+  delay(5000);
+}
@@ -0,0 +1,80 @@
+/*!
+ * @file Example15_BackgroundSampler.ino
+ * 
+ * @mainpage SparkFun smôl Power Board Arduino Library
+ * 
+ * @section intro_sec Examples
+ * 
+ * This example shows how to sample the power board in the background and share the latest
+ * values with any number of readers. Only the sampler uses the I2C bus. Reading the latest
+ * values is instant and never touches the bus, however often it is done.
+ * 
+ * Want to support open source hardware? Buy a board from SparkFun!
+ * SparkX smôl Power Board LiPo (SPX-18622): https://www.sparkfun.com/products/18622
+ * SparkX smôl Power Board AAA (SPX-18621): https://www.sparkfun.com/products/18621
+ * SparkX smôl ESP32 (SPX-18619): https://www.sparkfun.com/products/18619
+ * 
+ * @section author Author
+ * 
+ * This library was written by:
+ * Paul Clark
+ * SparkFun Electronics
+ * July 23rd 2021
+ * 
+ * @section license License
+ * 
+ * MIT: please see LICENSE.md for the full license information
+ * 
+ */
+
+#include <Wire.h>
+
+#include <SparkFun_MAX1704x_Fuel_Gauge_Arduino_Library.h> // Click here to get the library: http://librarymanager/All#SparkFun_MAX1704x_Fuel_Gauge_Arduino_Library
+#include <SparkFun_smol_Power_Board.h> //Click here to get the library:  http://librarymanager/All#SparkFun_smol_Power_Board
+#include <SparkFun_smol_Power_Board_Sampler.h>
+
+smolPowerAAA myPowerBoard;
+
+sfeSmolPowerSampler<smolPowerAAA> sampler;
+
+unsigned long lastPrint = 0;
+
+void setup()
+{
+  Serial.begin(115200);
+  Serial.println(F("smôl Power Board example"));
+  Serial.println();
+
+  Wire.begin();
+
+  if (myPowerBoard.begin() == false) // Begin communication with the power board using the default I2C address (0x50) and the Wire port
+  {
+    Serial.println(F("Could not communicate with the power board. Please check the I2C connections. Freezing..."));
+    while (1)
+      ;
+  }
+
+  sampler.begin(myPowerBoard, 2000); // Sample the board every 2 seconds
+}
+
+void loop()
+{
+  sampler.tick(); // Take a sample when one is due. (On ESP32 you can call sampler.startTask() in setup instead)
+
+  if (millis() - lastPrint >= 250) // Read the latest values much more often than they are sampled. No bus traffic
+  {
+    lastPrint = millis();
+
+    sfe_power_board_sample_t latest;
+    if (sampler.getLatest(latest))
+    {
+      Serial.print(F("Battery: "));
+      Serial.print(latest.batteryMillivolts);
+      Serial.print(F("mV  Temperature: "));
+      Serial.print(((float)latest.temperatureCentiC) / 100.0f, 2);
+      Serial.print(F("C  Age: "));
+      Serial.print(millis() - latest.millis);
+      Serial.println(F("ms"));
+    }
+  }
+}
@@ -0,0 +1,85 @@
+/*!
+ * @file Example16_BatchStatistics.ino
+ * 
+ * @mainpage SparkFun smôl Power Board Arduino Library
+ * 
+ * @section intro_sec Examples
+ * 
+ * This example shows how to characterise the noise on the battery voltage and temperature readings.
+ * sampleBattery and sampleTemperature take many readings in one call and return the
+ * count, minimum, maximum, mean, variance and standard deviation.
+ * With the VCC reference, VCC is measured once per batch (or every vccInterval readings).
+ * 
+ * Want to support open source hardware? Buy a board from SparkFun!
+ * SparkX smôl Power Board LiPo (SPX-18622): https://www.sparkfun.com/products/18622
+ * SparkX smôl Power Board AAA (SPX-18621): https://www.sparkfun.com/products/18621
+ * SparkX smôl ESP32 (SPX-18619): https://www.sparkfun.com/products/18619
+ * 
+ * @section author Author
+ * 
+ * This library was written by:
+ * Paul Clark
+ * SparkFun Electronics
+ * July 23rd 2021
+ * 
+ * @section license License
+ * 
+ * MIT: please see LICENSE.md for the full license information
+ * 
+ */
+
+#include <Wire.h>
+
+#include <SparkFun_MAX1704x_Fuel_Gauge_Arduino_Library.h> // Click here to get the library: http://librarymanager/All#SparkFun_MAX1704x_Fuel_Gauge_Arduino_Library
+#include <SparkFun_smol_Power_Board.h> //Click here to get the library:  http://librarymanager/All#SparkFun_smol_Power_Board
+
+smolPowerAAA myPowerBoard;
+
+void printStatistics(const char *name, const sfe_power_board_sample_stats_t &stats)
+{
+  Serial.print(name);
+  Serial.print(F(": count "));
+  Serial.print(stats.count);
+  Serial.print(F("  min "));
+  Serial.print(stats.minimum);
+  Serial.print(F("  max "));
+  Serial.print(stats.maximum);
+  Serial.print(F("  mean "));
+  Serial.print(stats.mean);
+  Serial.print(F("  variance "));
+  Serial.print(stats.variance);
+  Serial.print(F("  std dev "));
+  Serial.println(stats.standardDeviation);
+}
+
+void setup()
+{
+  Serial.begin(115200);
+  Serial.println(F("smôl Power Board example"));
+  Serial.println();
+
+  Wire.begin();
+
+  if (myPowerBoard.begin() == false) // Begin communication with the power board using the default I2C address (0x50) and the Wire port
+  {
+    Serial.println(F("Could not communicate with the power board. Please check the I2C connections. Freezing..."));
+    while (1)
+      ;
+  }
+}
+
+void loop()
+{
+  sfe_power_board_sample_stats_t stats;
+
+  if (myPowerBoard.sampleBattery(64, stats) == false) // Read the battery voltage 64 times
+    Serial.println(F("The battery voltage could not be read!"));
+  printStatistics("Battery (mV)", stats);
+
+  if (myPowerBoard.sampleTemperature(64, stats) == false) // Read the temperature 64 times
+    Serial.println(F("The temperature could not be read!"));
+  printStatistics("Temperature (centi-C)", stats);
+
+  Serial.println();
+  delay(5000);
+}
@@ -0,0 +1,93 @@
+/*!
+ * @file Example6_NonBlockingRead.ino
+ * 
+ * @mainpage SparkFun smôl Power Board Arduino Library
+ * 
+ * @section intro_sec Examples
+ * 
+ * This example shows how to read the battery voltage and temperature without blocking.
+ * The ATtiny43U takes ~11ms to perform each ADC conversion. The split-phase API lets
+ * your code do other things while the conversion is in progress.
+ * 
+ * Want to support open source hardware? Buy a board from SparkFun!
+ * SparkX smôl Power Board LiPo (SPX-18622): https://www.sparkfun.com/products/18622
+ * SparkX smôl Power Board AAA (SPX-18621): https://www.sparkfun.com/products/18621
+ * SparkX smôl ESP32 (SPX-18619): https://www.sparkfun.com/products/18619
+ * 
+ * @section author Author
+ * 
+ * This library was written by:
+ * Paul Clark
+ * SparkFun Electronics
+ * July 23rd 2021
+ * 
+ * @section license License
+ * 
+ * MIT: please see LICENSE.md for the full license information
+ * 
+ */
+
+#include <Wire.h>
+
+#include <SparkFun_MAX1704x_Fuel_Gauge_Arduino_Library.h> // Click here to get the library: http://librarymanager/All#SparkFun_MAX1704x_Fuel_Gauge_Arduino_Library
+#include <SparkFun_smol_Power_Board.h> //Click here to get the library:  http://librarymanager/All#SparkFun_smol_Power_Board
+
+smolPowerAAA myPowerBoard; // Uncomment this line if you are using the smôl Power Board AAA
+//smolPowerLiPo myPowerBoard; // Uncomment this line if you are using the smôl Power Board LiPo
+
+bool readingBattery = true; // Alternate between battery voltage and temperature
+unsigned long loopCount = 0; // Count how many times loop runs while we wait for the results
+
+void setup()
+{
+  Serial.begin(115200);
+  while (!Serial)
+    ; // Wait for the user to open the Serial console
+  Serial.println(F("smôl Power Board example"));
+  Serial.println();
+
+  Wire.begin();
+
+  if (myPowerBoard.begin() == false) // Begin communication with the power board using the default I2C address (0x50) and the Wire port
+  {
+    Serial.println(F("Could not communicate with the power board. Please check the I2C connections. Freezing..."));
+    while (1)
+      ;
+  }
+
+  myPowerBoard.startBatteryVoltage(); // Start the first measurement
+}
+
+void loop()
+{
+  loopCount++; // Do other useful work here...
+
+  if (myPowerBoard.poll()) // poll never blocks. It returns true when the result is ready
+  {
+    float result = myPowerBoard.collect(); // Collect the result
+
+    if (readingBattery)
+    {
+      Serial.print(F("The battery voltage reads as: "));
+      Serial.print(result);
+    }
+    else
+    {
+      Serial.print(F("The temperature in Degrees C is: "));
+      Serial.print(result, 0);
+    }
+    Serial.print(F("  (loop ran "));
+    Serial.print(loopCount);
+    Serial.println(F(" times while we waited)"));
+
+    loopCount = 0;
+    readingBattery = !readingBattery;
+
+    delay(1000);
+
+    if (readingBattery) // Start the next measurement
+      myPowerBoard.startBatteryVoltage();
+    else
+      myPowerBoard.startTemperature();
+  }
+}
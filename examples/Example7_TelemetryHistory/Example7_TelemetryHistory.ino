@@ -0,0 +1,80 @@
+/*!
+ * @file Example7_TelemetryHistory.ino
+ * 
+ * @mainpage SparkFun smôl Power Board Arduino Library
+ * 
+ * @section intro_sec Examples
+ * 
+ * This example shows how to keep a rolling history of the temperature and battery voltage.
+ * The history holds the raw ADC readings, delta-encoded, so each sample needs only 4 bytes of RAM.
+ * The minimum, maximum and mean battery voltage over the last 10 samples is printed.
+ * 
+ * Want to support open source hardware? Buy a board from SparkFun!
+ * SparkX smôl Power Board LiPo (SPX-18622): https://www.sparkfun.com/products/18622
+ * SparkX smôl Power Board AAA (SPX-18621): https://www.sparkfun.com/products/18621
+ * SparkX smôl ESP32 (SPX-18619): https://www.sparkfun.com/products/18619
+ * 
+ * @section author Author
+ * 
+ * This library was written by:
+ * Paul Clark
+ * SparkFun Electronics
+ * July 23rd 2021
+ * 
+ * @section license License
+ * 
+ * MIT: please see LICENSE.md for the full license information
+ * 
+ */
+
+#include <Wire.h>
+
+#include <SparkFun_MAX1704x_Fuel_Gauge_Arduino_Library.h> // Click here to get the library: http://librarymanager/All#SparkFun_MAX1704x_Fuel_Gauge_Arduino_Library
+#include <SparkFun_smol_Power_Board.h> //Click here to get the library:  http://librarymanager/All#SparkFun_smol_Power_Board
+#include <SparkFun_smol_Power_Board_History.h>
+
+smolPowerAAA myPowerBoard; // This example uses the ATtiny43U's VBAT reading, so it is for the smôl Power Board AAA
+
+sfeSmolPowerHistory<100> myHistory; // Hold the last 100 samples: 400 bytes of RAM
+
+void setup()
+{
+  Serial.begin(115200);
+  while (!Serial)
+    ; // Wait for the user to open the Serial console
+  Serial.println(F("smôl Power Board example"));
+  Serial.println();
+
+  Wire.begin();
+
+  if (myPowerBoard.begin() == false) // Begin communication with the power board using the default I2C address (0x50) and the Wire port
+  {
+    Serial.println(F("Could not communicate with the power board. Please check the I2C connections. Freezing..."));
+    while (1)
+      ;
+  }
+
+  myPowerBoard.setADCVoltageReference(SFE_SMOL_POWER_USE_ADC_REF_1V1); // Use the 1.1V reference so every VBAT reading has the same scale
+}
+
+void loop()
+{
+  if (myHistory.sample(myPowerBoard)) // Read TEMPERATURE and VBAT and add them to the history
+  {
+    sfe_power_board_history_stats_t stats;
+    myHistory.getStatistics(SFE_SMOL_POWER_HISTORY_VBAT, 10, stats); // Aggregate the last 10 VBAT readings
+
+    Serial.print(F("Samples: "));
+    Serial.print(myHistory.available());
+    Serial.print(F("  VBAT (raw) min: "));
+    Serial.print(stats.minimum);
+    Serial.print(F("  max: "));
+    Serial.print(stats.maximum);
+    Serial.print(F("  mean: "));
+    Serial.print(stats.mean);
+    Serial.print(F("  mean (mV): "));
+    Serial.println(((uint32_t)stats.mean * 2200 + 511) / 1023); // Convert to mV: the 1.1V reference and divide-by-2 give a full scale of 2.2V
+  }
+
+  delay(1000);
+}
@@ -0,0 +1,89 @@
+/*!
+ * @file Example8_FilteredBatteryVoltage.ino
+ * 
+ * @mainpage SparkFun smôl Power Board Arduino Library
+ * 
+ * @section intro_sec Examples
+ * 
+ * This example shows how to filter the battery voltage. Using VCC as the ADC reference is noisy.
+ * A running median rejects spikes and an exponential moving average smooths the noise.
+ * The measurements run in the background using the split-phase API. The filtered voltage
+ * can be read at any time, as often as you like, without any extra I2C traffic.
+ * Hysteresis stops the "battery low" decision from chattering near the threshold.
+ * 
+ * Want to support open source hardware? Buy a board from SparkFun!
+ * SparkX smôl Power Board LiPo (SPX-18622): https://www.sparkfun.com/products/18622
+ * SparkX smôl Power Board AAA (SPX-18621): https://www.sparkfun.com/products/18621
+ * SparkX smôl ESP32 (SPX-18619): https://www.sparkfun.com/products/18619
+ * 
+ * @section author Author
+ * 
+ * This library was written by:
+ * Paul Clark
+ * SparkFun Electronics
+ * July 23rd 2021
+ * 
+ * @section license License
+ * 
+ * MIT: please see LICENSE.md for the full license information
+ * 
+ */
+
+#include <Wire.h>
+
+#include <SparkFun_MAX1704x_Fuel_Gauge_Arduino_Library.h> // Click here to get the library: http://librarymanager/All#SparkFun_MAX1704x_Fuel_Gauge_Arduino_Library
+#include <SparkFun_smol_Power_Board.h> //Click here to get the library:  http://librarymanager/All#SparkFun_smol_Power_Board
+#include <SparkFun_smol_Power_Board_Filters.h>
+
+smolPowerAAA myPowerBoard; // This example uses the ATtiny43U's VBAT reading, so it is for the smôl Power Board AAA
+
+sfeSmolPowerFilter<5> batteryFilter(3); // Median of 5, then an EMA with a time constant of ~8 samples
+sfeSmolPowerHysteresis batteryOK(2100, 2200); // Battery is OK above 2.2V, low below 2.1V
+
+unsigned long lastPrint = 0;
+
+void setup()
+{
+  Serial.begin(115200);
+  while (!Serial)
+    ; // Wait for the user to open the Serial console
+  Serial.println(F("smôl Power Board example"));
+  Serial.println();
+
+  Wire.begin();
+
+  if (myPowerBoard.begin() == false) // Begin communication with the power board using the default I2C address (0x50) and the Wire port
+  {
+    Serial.println(F("Could not communicate with the power board. Please check the I2C connections. Freezing..."));
+    while (1)
+      ;
+  }
+
+  myPowerBoard.setADCVoltageReference(SFE_SMOL_POWER_USE_ADC_REF_VCC); // Use VCC as the reference. Noisy, but allows a full scale of 2 * VCC
+
+  myPowerBoard.startBatteryVoltage(); // Start the first measurement
+}
+
+void loop()
+{
+  // Background sampling: feed the filter each time a measurement completes
+  if (myPowerBoard.poll())
+  {
+    if (myPowerBoard.getMeasurementState() == SFE_SMOL_POWER_MEASUREMENT_COMPLETE)
+      batteryOK.update(batteryFilter.update((uint16_t)myPowerBoard.collectFixedPoint())); // Filter the voltage in mV
+    else
+      myPowerBoard.collectFixedPoint(); // Discard the failed measurement
+    myPowerBoard.startBatteryVoltage(); // Start the next measurement
+  }
+
+  // Readers: the filtered value is available at any time, without any I2C traffic
+  if (millis() - lastPrint >= 1000)
+  {
+    lastPrint = millis();
+    Serial.print(F("Median (mV): "));
+    Serial.print(batteryFilter.getMedian());
+    Serial.print(F("  Filtered (mV): "));
+    Serial.print(batteryFilter.get());
+    Serial.println(batteryOK.get() ? F("  Battery OK") : F("  Battery LOW"));
+  }
+}
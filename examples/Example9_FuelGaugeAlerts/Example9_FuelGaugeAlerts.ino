@@ -0,0 +1,94 @@
+/*!
+ * @file Example9_FuelGaugeAlerts.ino
+ * 
+ * @mainpage SparkFun smôl Power Board Arduino Library
+ * 
+ * @section intro_sec Examples
+ * 
+ * This example shows how to use the MAX17048 fuel gauge alerts on the smôl Power Board LiPo.
+ * The gauge is configured once, then the code does nothing until the gauge pulls its ALRT pin low.
+ * There is no periodic I2C traffic: serviceAlerts returns immediately unless an alert is pending.
+ * 
+ * ALRT is open-drain and active low. Connect it to an interrupt-capable pin.
+ * 
+ * Want to support open source hardware? Buy a board from SparkFun!
+ * SparkX smôl Power Board LiPo (SPX-18622): https://www.sparkfun.com/products/18622
+ * SparkX smôl Power Board AAA (SPX-18621): https://www.sparkfun.com/products/18621
+ * SparkX smôl ESP32 (SPX-18619): https://www.sparkfun.com/products/18619
+ * 
+ * @section author Author
+ * 
+ * This library was written by:
+ * Paul Clark
+ * SparkFun Electronics
+ * July 23rd 2021
+ * 
+ * @section license License
+ * 
+ * MIT: please see LICENSE.md for the full license information
+ * 
+ */
+
+#include <Wire.h>
+
+#include <SparkFun_MAX1704x_Fuel_Gauge_Arduino_Library.h> // Click here to get the library: http://librarymanager/All#SparkFun_MAX1704x_Fuel_Gauge_Arduino_Library
+#include <SparkFun_smol_Power_Board.h> //Click here to get the library:  http://librarymanager/All#SparkFun_smol_Power_Board
+
+smolPowerLiPo myPowerBoard;
+
+const int alertPin = 2; // Change this to the interrupt-capable pin connected to the MAX17048 ALRT pin
+
+void setup()
+{
+  Serial.begin(115200);
+  while (!Serial)
+    ; // Wait for the user to open the Serial console
+  Serial.println(F("smôl Power Board example"));
+  Serial.println();
+
+  Wire.begin();
+
+  if (myPowerBoard.begin() == false) // Begin communication with the power board using the default I2C address (0x50) and the Wire port
+  {
+    Serial.println(F("Could not communicate with the power board. Please check the I2C connections. Freezing..."));
+    while (1)
+      ;
+  }
+
+  myPowerBoard.setEmptyAlertThreshold(10); // Alert when the state of charge falls below 10%
+  myPowerBoard.setVoltageAlertThresholds(3300, 4300); // Alert when the battery voltage is outside 3.3V to 4.3V
+  myPowerBoard.enableSOCChangeAlert(); // Alert each time the state of charge changes by 1%
+  myPowerBoard.clearAlerts(); // Start with no alerts
+
+  if (myPowerBoard.attachAlertInterrupt(alertPin) == false)
+  {
+    Serial.println(F("alertPin does not support interrupts. Freezing..."));
+    while (1)
+      ;
+  }
+}
+
+void loop()
+{
+  byte alerts = myPowerBoard.serviceAlerts(); // No I2C traffic unless ALRT has fallen
+  if (alerts == 0)
+    return;
+
+  Serial.print(F("Alert! SOC (0.01%): "));
+  Serial.print(myPowerBoard.getSOCCentiPercent());
+  Serial.print(F("  Change rate (0.01%/hr): "));
+  Serial.print(myPowerBoard.getChangeRateCentiPercentPerHour());
+  Serial.print(F("  Battery (mV): "));
+  Serial.println(myPowerBoard.getBatteryMillivolts());
+
+  if (alerts & SFE_SMOL_POWER_ALERT_RESET)
+    Serial.println(F("The fuel gauge has reset"));
+  if (alerts & SFE_SMOL_POWER_ALERT_VOLTAGE_HIGH)
+    Serial.println(F("Battery voltage is high"));
+  if (alerts & SFE_SMOL_POWER_ALERT_VOLTAGE_LOW)
+    Serial.println(F("Battery voltage is low"));
+  if (alerts & SFE_SMOL_POWER_ALERT_SOC_LOW)
+    Serial.println(F("Battery is almost empty"));
+  if (alerts & SFE_SMOL_POWER_ALERT_SOC_CHANGE)
+    Serial.println(F("State of charge has changed by 1%"));
+}
@@ -0,0 +1,282 @@
+/*!
+ * @file SparkFun_smol_Power_Board_Benchmark.cpp
+ *
+ * SparkFun smôl Power Board Arduino Library - benchmark
+ *
+ * Runs the public smolPowerAAA methods against the mock transport (a simulated ATtiny43U)
+ * and prints one CSV row per method, averaged per call:
+ *
+ *   group,name,calls,transactions,bytes_written,bytes_read,nacks,short_reads,retries,delay_ms,simulated_ms,cpu_ns
+ *
+ * transactions .. retries come from the bus statistics. delay_ms is the time spent waiting for the ATtiny43U.
+ * simulated_ms is how long the call would block on the target (the simulated clock). cpu_ns is the host CPU time.
+ * The CRC8 and conversion rows have no bus traffic: they only report cpu_ns.
+ * Compare the output before and after a change to find regressions.
+ *
+ * The errors rows inject a NACK or a short read, and every call must recover with a retry. If any call fails,
+ * the row is reported on stderr and the exit status is 1, so a broken retry can't pass as a fast one.
+ *
+ * This is a host program, not a sketch. The Arduino IDE ignores the extras folder. Build and run with:
+ *
+ *   g++ -std=gnu++11 -O2 -I../../src -DSFE_SMOL_POWER_TRANSPORT_MOCK -DSFE_SMOL_POWER_SIMULATED_CLOCK
+ *       -DSFE_SMOL_POWER_ENABLE_BUS_STATISTICS SparkFun_smol_Power_Board_Benchmark.cpp ../../src/\*.cpp -o benchmark
+ *   ./benchmark > benchmark.csv
+ *
+ * Add -DSFE_SMOL_POWER_DISABLE_FLOAT to benchmark the integer-only build.
+ * smolPowerLiPo needs the MAX1704x library and TwoWire, so it cannot be run against the mock.
+ *
+ * Please see LICENSE.md for the license information
+ *
+ */
+
+#if !defined(SFE_SMOL_POWER_TRANSPORT_MOCK) || !defined(SFE_SMOL_POWER_SIMULATED_CLOCK) || !defined(SFE_SMOL_POWER_ENABLE_BUS_STATISTICS)
+#error "Please define SFE_SMOL_POWER_TRANSPORT_MOCK, SFE_SMOL_POWER_SIMULATED_CLOCK and SFE_SMOL_POWER_ENABLE_BUS_STATISTICS"
+#endif
+
+#include <stdio.h>
+#include <time.h>
+
+#include "SparkFun_smol_Power_Board.h"
+
+#define BENCHMARK_CALLS       200     // The number of calls per method
+#define BENCHMARK_CPU_CALLS   1000000 // The number of calls per CRC8 / conversion benchmark
+#define BENCHMARK_CONVERSION  9       // The simulated ADC conversion time (ms) per register
+
+/** Exposes the conversion functions, so they can be benchmarked without the bus */
+class benchmarkBoard : public smolPowerAAA
+{
+public:
+#ifndef SFE_SMOL_POWER_DISABLE_FLOAT
+  using sfeSmolPowerBoard::convertTemperature;
+  using sfeSmolPowerBoard::convertVCC;
+  using sfeSmolPowerBoard::convertBatteryVoltage;
+#endif
+  using sfeSmolPowerBoard::convertTemperatureCentiC;
+  using sfeSmolPowerBoard::convertVCCMillivolts;
+  using sfeSmolPowerBoard::convertBatteryMillivolts;
+};
+
+static sfeSmolPowerMockBoard mock;
+static benchmarkBoard board;
+static volatile uint32_t sink; // Stops the compiler removing the calls
+static unsigned long failedRows = 0; // The number of benchExpect rows with failed calls
+
+static unsigned long long cpuNanoseconds()
+{
+  struct timespec now;
+  clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &now);
+  return ((((unsigned long long)now.tv_sec) * 1000000000ULL) + now.tv_nsec);
+}
+
+/** Run call calls times and print the averages */
+template <class Call>
+static void bench(const char *group, const char *name, unsigned long calls, Call call)
+{
+  sfe_power_board_bus_stats_t stats;
+  board.smolPowerBoard_io.resetBusStatistics();
+  unsigned long startMillis = millis();
+  unsigned long long startCPU = cpuNanoseconds();
+
+  for (unsigned long i = 0; i < calls; i++)
+    call();
+
+  unsigned long long cpu = cpuNanoseconds() - startCPU;
+  unsigned long simulated = millis() - startMillis;
+  board.smolPowerBoard_io.getBusStatistics(stats);
+
+  double n = (double)calls;
+  printf("%s,%s,%lu,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.1f\n", group, name, calls,
+         stats.transactions / n, stats.bytesWritten / n, stats.bytesRead / n, stats.nacks / n, stats.shortReads / n,
+         stats.retries / n, stats.delayMS / n, simulated / n, cpu / n);
+}
+
+/** As bench, but each call must return true. Failed calls are reported on stderr and counted in failedRows */
+template <class Call>
+static void benchExpect(const char *group, const char *name, unsigned long calls, Call call)
+{
+  unsigned long failed = 0;
+  bench(group, name, calls, [&]() { if (!call()) failed++; });
+  if (failed > 0)
+  {
+    fprintf(stderr, "%s,%s: %lu of %lu calls failed\n", group, name, failed, calls);
+    failedRows++;
+  }
+}
+
+/** Restore the default settings between benchmarks */
+static void resetBoard()
+{
+  sfe_power_board_retry_policy_t policy = {SFE_SMOL_POWER_DEFAULT_RETRIES, SFE_SMOL_POWER_DEFAULT_RETRY_DELAY, SFE_SMOL_POWER_DEFAULT_DEADLINE};
+  board.setRetryPolicy(policy);
+  board.setAdaptiveADCSettle(false);
+  board.setBurstReads(false);
+  mock.setBurstReads(false);
+  board.setVCCCacheTTL(0);
+  board.invalidateCache();
+  mock.injectErrors(0);
+  mock.injectShortReads(0);
+}
+
+static void benchmarkIdentity()
+{
+  bench("identity", "begin", BENCHMARK_CALLS, []() { sink = board.begin(SFE_SMOL_POWER_DEFAULT_I2C_ADDRESS, mock); });
+  bench("identity", "isConnected", BENCHMARK_CALLS, []() { sink = board.isConnected(); });
+  bench("identity", "getI2CAddress", BENCHMARK_CALLS, []() { sink = board.getI2CAddress(); });
+  bench("identity", "setI2CAddress", BENCHMARK_CALLS, []() { sink = board.setI2CAddress(SFE_SMOL_POWER_DEFAULT_I2C_ADDRESS); });
+  bench("identity", "getResetReason", BENCHMARK_CALLS, []() { sink = board.getResetReason(); });
+  bench("identity", "getFirmwareVersion", BENCHMARK_CALLS, []() { sink = board.getFirmwareVersion(); });
+
+  sfe_power_board_resume_t state;
+  board.saveResumeState(state);
+  bench("identity", "saveResumeState", BENCHMARK_CALLS, [&]() { sink = board.saveResumeState(state); });
+  bench("identity", "resume", BENCHMARK_CALLS, [&]() { sink = board.resume(state, mock); });
+  resetBoard();
+}
+
+static void benchmarkMeasurements()
+{
+#ifndef SFE_SMOL_POWER_DISABLE_FLOAT
+  bench("measure", "getTemperature", BENCHMARK_CALLS, []() { sink = (uint32_t)board.getTemperature(); });
+  bench("measure", "measureVCC", BENCHMARK_CALLS, []() { sink = (uint32_t)board.measureVCC(); });
+  bench("measure", "getBatteryVoltage", BENCHMARK_CALLS, []() { sink = (uint32_t)board.getBatteryVoltage(); });
+#endif
+  bench("measure", "getTemperatureCentiC", BENCHMARK_CALLS, []() { sink = board.getTemperatureCentiC(); });
+  bench("measure", "measureVCCMillivolts", BENCHMARK_CALLS, []() { sink = board.measureVCCMillivolts(); });
+  bench("measure", "getBatteryMillivolts", BENCHMARK_CALLS, []() { sink = board.getBatteryMillivolts(); });
+  bench("measure", "getRawTemperature", BENCHMARK_CALLS, []() { uint16_t raw; sink = board.getRawTemperature(&raw); });
+  bench("measure", "getRawVBAT", BENCHMARK_CALLS, []() { uint16_t raw; sink = board.getRawVBAT(&raw); });
+  bench("measure", "getRaw1V1", BENCHMARK_CALLS, []() { uint16_t raw; sink = board.getRaw1V1(&raw); });
+  bench("measure", "getTelemetry", BENCHMARK_CALLS, []() { sfe_power_board_telemetry_t telemetry; sink = board.getTelemetry(telemetry); });
+  mock.setBurstReads(true); // Firmware with burst reads
+  board.setBurstReads(true);
+  bench("measure", "getTelemetry (burst reads)", BENCHMARK_CALLS, []() { sfe_power_board_telemetry_t telemetry; sink = board.getTelemetry(telemetry); });
+  resetBoard();
+  bench("measure", "sampleTemperature x16", BENCHMARK_CALLS, []() { sfe_power_board_sample_stats_t stats; sink = board.sampleTemperature(16, stats); });
+  bench("measure", "sampleBattery x16", BENCHMARK_CALLS, []() { sfe_power_board_sample_stats_t stats; sink = board.sampleBattery(16, stats); });
+
+  // The VCC reference needs a VCC measurement to scale VBAT. The cache reuses it
+  board.setADCVoltageReference(SFE_SMOL_POWER_USE_ADC_REF_VCC);
+  bench("measure", "getBatteryMillivolts (VCC reference)", BENCHMARK_CALLS, []() { sink = board.getBatteryMillivolts(); });
+  bench("measure", "sampleBattery x16 (VCC reference)", BENCHMARK_CALLS, []() { sfe_power_board_sample_stats_t stats; sink = board.sampleBattery(16, stats); });
+  board.setVCCCacheTTL(60000);
+  bench("measure", "getBatteryMillivolts (VCC reference + cache)", BENCHMARK_CALLS, []() { sink = board.getBatteryMillivolts(); });
+  board.setADCVoltageReference(SFE_SMOL_POWER_USE_ADC_REF_1V1);
+  resetBoard();
+
+  board.setAdaptiveADCSettle(true);
+  bench("measure", "getTemperatureCentiC (adaptive settle)", BENCHMARK_CALLS, []() { sink = board.getTemperatureCentiC(); });
+  bench("measure", "getBatteryMillivolts (adaptive settle)", BENCHMARK_CALLS, []() { sink = board.getBatteryMillivolts(); });
+  resetBoard();
+
+  bench("measure", "split-phase temperature", BENCHMARK_CALLS, []() {
+    board.startTemperature();
+    while (!board.poll())
+      delay(1);
+    sink = board.collectFixedPoint();
+  });
+
+  // poll never blocks: with the adaptive settle time, a conversion which is not yet complete is polled again by a later call
+  mock.setConversionTime(8);
+  board.setAdaptiveADCSettle(true);
+  bench("measure", "split-phase temperature (adaptive settle; 8ms conversion)", BENCHMARK_CALLS, []() {
+    board.startTemperature();
+    while (!board.poll())
+      delay(1);
+    sink = board.collectFixedPoint();
+  });
+  mock.setConversionTime(0);
+  resetBoard();
+}
+
+static void benchmarkConfiguration()
+{
+  bench("config", "getADCVoltageReference", BENCHMARK_CALLS, []() { sink = board.getADCVoltageReference(); });
+  bench("config", "setADCVoltageReference", BENCHMARK_CALLS, []() { sink = board.setADCVoltageReference(SFE_SMOL_POWER_USE_ADC_REF_1V1); });
+  bench("config", "getWatchdogTimerPrescaler", BENCHMARK_CALLS, []() { sink = board.getWatchdogTimerPrescaler(); });
+  bench("config", "setWatchdogTimerPrescaler", BENCHMARK_CALLS, []() { sink = board.setWatchdogTimerPrescaler(SFE_SMOL_POWER_WDT_TIMEOUT_8s); });
+  bench("config", "getPowerDownDurationWDTInts", BENCHMARK_CALLS, []() { uint16_t duration; sink = board.getPowerDownDurationWDTInts(&duration); });
+  bench("config", "setPowerdownDurationWDTInts", BENCHMARK_CALLS, []() { sink = board.setPowerdownDurationWDTInts(1); });
+  bench("config", "getCachedADCVoltageReference", BENCHMARK_CALLS, []() { sink = board.getCachedADCVoltageReference(); });
+  bench("config", "getCachedWatchdogTimerPrescaler", BENCHMARK_CALLS, []() { sink = board.getCachedWatchdogTimerPrescaler(); });
+  bench("config", "getCachedPowerDownDurationWDTInts", BENCHMARK_CALLS, []() { uint16_t duration; sink = board.getCachedPowerDownDurationWDTInts(&duration); });
+
+  sfe_power_board_config_t config;
+  board.readConfig(config);
+  bench("config", "readConfig", BENCHMARK_CALLS, [&]() { sink = board.readConfig(config); });
+  bench("config", "applyConfig (unchanged)", BENCHMARK_CALLS, [&]() { sink = board.applyConfig(config); });
+  bench("config", "dumpRegisters", BENCHMARK_CALLS, []() { sfe_power_board_register_dump_t dump; sink = board.dumpRegisters(dump); });
+  mock.setBurstReads(true); // Firmware with burst reads
+  board.setBurstReads(true);
+  bench("config", "dumpRegisters (burst reads)", BENCHMARK_CALLS, []() { sfe_power_board_register_dump_t dump; sink = board.dumpRegisters(dump); });
+  resetBoard();
+  resetBoard();
+}
+
+static void benchmarkPowerDown()
+{
+  bench("powerdown", "planPowerDown", BENCHMARK_CALLS, []() { sfe_power_board_powerdown_plan_t plan; sink = sfeSmolPowerBoard::planPowerDown(3600000, plan); });
+  bench("powerdown", "powerDownNow", BENCHMARK_CALLS, []() { sink = board.powerDownNow(); });
+  bench("powerdown", "configurePowerDown (unchanged)", BENCHMARK_CALLS, []() { sink = board.configurePowerDown(60000); });
+  bench("powerdown", "powerDownFor (unchanged)", BENCHMARK_CALLS, []() { sink = board.powerDownFor(60000); });
+  unsigned long duration = 0;
+  bench("powerdown", "powerDownFor (alternating)", BENCHMARK_CALLS, [&]() { duration = (duration == 60000) ? 5000 : 60000; sink = board.powerDownFor(duration); });
+  resetBoard();
+}
+
+static void benchmarkErrors()
+{
+  sfe_power_board_retry_policy_t policy = {2, 1, 0};
+  board.setRetryPolicy(policy);
+  benchExpect("errors", "isConnected (1 NACK; 2 retries)", BENCHMARK_CALLS, []() { mock.injectErrors(1); return (board.isConnected()); });
+  benchExpect("errors", "getRawTemperature (1 short read; 2 retries)", BENCHMARK_CALLS, []() { uint16_t raw; mock.injectShortReads(1); return (board.getRawTemperature(&raw)); });
+  benchExpect("errors", "getTemperatureCentiC (1 short read; 2 retries)", BENCHMARK_CALLS, []() { mock.injectShortReads(1); return (board.getTemperatureCentiC() != SFE_SMOL_POWER_TEMPERATURE_CENTI_C_ERROR); });
+  benchExpect("errors", "measureVCCMillivolts (1 short read; 2 retries)", BENCHMARK_CALLS, []() { mock.injectShortReads(1); return (board.measureVCCMillivolts() != 0); });
+  benchExpect("errors", "getBatteryMillivolts (1 short read; 2 retries)", BENCHMARK_CALLS, []() { mock.injectShortReads(1); return (board.getBatteryMillivolts() != 0); });
+  resetBoard();
+}
+
+static void benchmarkCPU()
+{
+  byte data[I2C_BUFFER_LENGTH];
+  for (byte i = 0; i < sizeof(data); i++)
+    data[i] = i * 37;
+
+  bench("cpu", "computeCRC8 (1 byte)", BENCHMARK_CPU_CALLS, [&]() { data[0]++; sink = board.computeCRC8(data, 1); });
+  bench("cpu", "computeCRC8 (I2C_BUFFER_LENGTH bytes)", BENCHMARK_CPU_CALLS / 10, [&]() { data[0]++; sink = board.computeCRC8(data, sizeof(data)); });
+  bench("cpu", "sfeSmolPowerCRC8 (I2C_BUFFER_LENGTH bytes)", BENCHMARK_CPU_CALLS / 10, [&]() { data[0]++; sink = sfeSmolPowerCRC8((const byte *)data, (byte)sizeof(data)); });
+
+  sfe_power_board_register_dump_t dump;
+  board.dumpRegisters(dump);
+  byte record[SFE_SMOL_POWER_DUMP_RECORD_SIZE];
+  bench("cpu", "serializeRegisterDump", BENCHMARK_CPU_CALLS, [&]() { dump.rawVBAT++; sink = sfeSmolPowerBoard::serializeRegisterDump(dump, record, sizeof(record)); });
+  bench("cpu", "deserializeRegisterDump", BENCHMARK_CPU_CALLS, [&]() { sink = sfeSmolPowerBoard::deserializeRegisterDump(record, sizeof(record), dump); });
+
+  uint16_t raw = 0;
+#ifndef SFE_SMOL_POWER_DISABLE_FLOAT
+  bench("cpu", "convertTemperature (float)", BENCHMARK_CPU_CALLS, [&]() { raw = (raw + 1) & 0x3FF; sink = (uint32_t)benchmarkBoard::convertTemperature(raw); });
+  bench("cpu", "convertVCC (float)", BENCHMARK_CPU_CALLS, [&]() { raw = (raw & 0x3FF) + 1; sink = (uint32_t)benchmarkBoard::convertVCC(raw); });
+  bench("cpu", "convertBatteryVoltage (float)", BENCHMARK_CPU_CALLS, [&]() { raw = (raw + 1) & 0x3FF; sink = (uint32_t)benchmarkBoard::convertBatteryVoltage(raw, SFE_SMOL_POWER_USE_ADC_REF_VCC, 341); });
+#endif
+  bench("cpu", "convertTemperatureCentiC (integer)", BENCHMARK_CPU_CALLS, [&]() { raw = (raw + 1) & 0x3FF; sink = benchmarkBoard::convertTemperatureCentiC(raw); });
+  bench("cpu", "convertVCCMillivolts (integer)", BENCHMARK_CPU_CALLS, [&]() { raw = (raw & 0x3FF) + 1; sink = benchmarkBoard::convertVCCMillivolts(raw); });
+  bench("cpu", "convertBatteryMillivolts (integer)", BENCHMARK_CPU_CALLS, [&]() { raw = (raw + 1) & 0x3FF; sink = benchmarkBoard::convertBatteryMillivolts(raw, SFE_SMOL_POWER_USE_ADC_REF_VCC, 341); });
+}
+
+int main()
+{
+  mock.setConversionTime(BENCHMARK_CONVERSION);
+  if (!board.begin(SFE_SMOL_POWER_DEFAULT_I2C_ADDRESS, mock))
+  {
+    fprintf(stderr, "Could not communicate with the mock board\n");
+    return (1);
+  }
+
+  printf("group,name,calls,transactions,bytes_written,bytes_read,nacks,short_reads,retries,delay_ms,simulated_ms,cpu_ns\n");
+  benchmarkIdentity();
+  benchmarkMeasurements();
+  benchmarkConfiguration();
+  benchmarkPowerDown();
+  benchmarkErrors();
+  benchmarkCPU();
+  return ((failedRows > 0) ? 1 : 0);
+}
@@ -0,0 +1,223 @@
+/*!
+ * @file SparkFun_smol_Power_Board_BusLock_Tests.cpp
+ *
+ * SparkFun smôl Power Board Arduino Library - host tests
+ *
+ * Stress tests the bus lock (setBusLock) with std::thread, against the mock transport (simulated ATtiny43U boards).
+ * Two tasks each read their own board, sharing one std::mutex as the bus lock, while a third task takes
+ * the mutex and checks that neither board sees a transaction while it is held.
+ * The clock is real, so the ADC waits really do release the bus.
+ *
+ * Build and run from this directory:
+ *   g++ -std=gnu++11 -O2 -pthread -DSFE_SMOL_POWER_TRANSPORT_MOCK -I../../src SparkFun_smol_Power_Board_BusLock_Tests.cpp ../../src/SparkFun*.cpp -o buslock_tests && ./buslock_tests
+ *
+ * The exit status is the number of failed tests.
+ *
+ * Please see LICENSE.md for the license information
+ *
+ */
+
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+
+#include "SparkFun_smol_Power_Board.h"
+
+#include "SparkFun_smol_Power_Board_Test.h"
+
+#ifdef SFE_SMOL_POWER_SIMULATED_CLOCK
+#error "The bus lock tests need the real clock: the ADC waits must take real time"
+#endif
+
+#define STRESS_SECONDS 2
+#define CONVERSION_MS 10
+
+static std::mutex busMutex;
+static thread_local int lockDepth = 0; // How many times this thread holds busMutex. Must only be 0 or 1
+static thread_local std::chrono::steady_clock::time_point lockedAt;
+static std::atomic<long> locks(0);
+static std::atomic<long> nestedLocks(0);   // lock while this thread already holds the bus
+static std::atomic<long> strayUnlocks(0);  // unlock while this thread does not hold the bus
+static std::atomic<long> maxHoldUs(0);
+
+static void lockHook(void *context)
+{
+  (void)context;
+  if (lockDepth != 0)
+  {
+    nestedLocks++;
+    return; // std::mutex would deadlock
+  }
+  busMutex.lock();
+  lockDepth = 1;
+  lockedAt = std::chrono::steady_clock::now();
+  locks++;
+}
+
+static void unlockHook(void *context)
+{
+  (void)context;
+  if (lockDepth != 1)
+  {
+    strayUnlocks++;
+    return;
+  }
+  long us = (long)std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - lockedAt).count();
+  long previous = maxHoldUs;
+  while ((us > previous) && !maxHoldUs.compare_exchange_weak(previous, us))
+    ;
+  lockDepth = 0;
+  busMutex.unlock();
+}
+
+static const sfe_power_board_bus_lock_t busLock = {lockHook, unlockHook, nullptr};
+
+static void resetCounts()
+{
+  locks = 0;
+  nestedLocks = 0;
+  strayUnlocks = 0;
+  maxHoldUs = 0;
+}
+
+//-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
+/** The lock is taken once per transaction, however deeply the calls nest, and is released for the ADC wait */
+static void testLockDepth()
+{
+  sfeSmolPowerMockBoard mock;
+  smolPowerAAA board;
+  board.setBusLock(busLock);
+  CHECK(board.begin(SFE_SMOL_POWER_DEFAULT_I2C_ADDRESS, mock));
+  resetCounts();
+
+  // No ADC wait: one lock
+  CHECK(board.getI2CAddress() == SFE_SMOL_POWER_DEFAULT_I2C_ADDRESS);
+  CHECK(locks == 1);
+
+  // Write the pointer, release for the wait, then take the bus again to read
+  uint16_t raw;
+  resetCounts();
+  CHECK(board.getRawVBAT(&raw));
+  CHECK(locks == 2);
+  CHECK(maxHoldUs < (SFE_SMOL_POWER_ADC_READ_DELAY * 1000L));
+
+  // Several registers, and a nested VCC measurement
+  sfe_power_board_telemetry_t telemetry;
+  sfe_power_board_register_dump_t dump;
+  CHECK(board.getTelemetry(telemetry));
+  CHECK(board.dumpRegisters(dump));
+  CHECK(board.getBatteryMillivolts() != 0);
+  CHECK(nestedLocks == 0);
+  CHECK(strayUnlocks == 0);
+  CHECK(lockDepth == 0);
+
+  // Failed transactions release the bus too
+  sfe_power_board_retry_policy_t policy = {2, 1, 0};
+  board.setRetryPolicy(policy);
+  mock.injectShortReads(1);
+  CHECK(board.getRawVBAT(&raw));
+  mock.injectErrors(5);
+  CHECK(!board.isConnected());
+  CHECK(nestedLocks == 0);
+  CHECK(strayUnlocks == 0);
+  CHECK(lockDepth == 0);
+}
+
+static std::atomic<bool> stop(false);
+static std::atomic<bool> taskABusy(false);
+static std::atomic<long> taskErrors(0);
+static std::atomic<long> taskCalls(0);
+
+static void task(sfeSmolPowerMockBoard *mock, uint16_t rawVBAT, bool flagBusy)
+{
+  smolPowerAAA board;
+  board.setBusLock(busLock);
+  if (!board.begin(mock->getAddress(), *mock))
+  {
+    taskErrors++;
+    return;
+  }
+  while (!stop)
+  {
+    if (flagBusy)
+      taskABusy = true;
+    sfe_power_board_telemetry_t telemetry;
+    sfe_power_board_register_dump_t dump;
+    uint16_t raw = 0;
+    bool ok = board.getTelemetry(telemetry) && (telemetry.rawVBAT == rawVBAT);
+    ok = ok && board.getRawVBAT(&raw) && (raw == rawVBAT);
+    ok = ok && board.dumpRegisters(dump) && (dump.rawVBAT == rawVBAT) && (dump.i2cAddress == mock->getAddress());
+    if (flagBusy)
+      taskABusy = false;
+    if (!ok || (lockDepth != 0))
+      taskErrors++;
+    taskCalls++;
+  }
+}
+
+/** Two tasks share the bus. No transaction is made without the lock, and the bus is free during the ADC waits */
+static void testStress()
+{
+  sfeSmolPowerMockBoard mockA(0x50);
+  sfeSmolPowerMockBoard mockB(0x51);
+  mockA.setConversionTime(CONVERSION_MS);
+  mockB.setConversionTime(CONVERSION_MS);
+  mockA.setRegister(SFE_SMOL_POWER_REGISTER_VBAT, 600);
+  mockB.setRegister(SFE_SMOL_POWER_REGISTER_VBAT, 700);
+  resetCounts();
+  stop = false;
+
+  long checks = 0;
+  long checksDuringA = 0; // The checker held the bus while task A was part-way through its calls
+  long violations = 0;    // A board saw a transaction while the checker held the bus
+  std::thread a(task, &mockA, (uint16_t)600, true);
+  std::thread b(task, &mockB, (uint16_t)700, false);
+  std::thread checker([&]() {
+    while (!stop)
+    {
+      {
+        std::lock_guard<std::mutex> guard(busMutex);
+        unsigned long transactionsA = mockA.getTransactionCount();
+        unsigned long transactionsB = mockB.getTransactionCount();
+        bool duringA = taskABusy;
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+        if ((transactionsA != mockA.getTransactionCount()) || (transactionsB != mockB.getTransactionCount()))
+          violations++;
+        checks++;
+        if (duringA)
+          checksDuringA++;
+      }
+      std::this_thread::sleep_for(std::chrono::microseconds(500));
+    }
+  });
+
+  std::this_thread::sleep_for(std::chrono::seconds(STRESS_SECONDS));
+  stop = true;
+  a.join();
+  b.join();
+  checker.join();
+
+  printf("  %ld calls, %ld checks (%ld during task A), %ld violations, longest hold %ldus\n", (long)taskCalls, checks, checksDuringA, violations, (long)maxHoldUs);
+  CHECK(taskCalls > 0);
+  CHECK(taskErrors == 0);
+  CHECK(checks > 0);
+  CHECK(violations == 0);
+  CHECK(checksDuringA > 0); // The tasks and the checker really did interleave
+  CHECK(nestedLocks == 0);
+  CHECK(strayUnlocks == 0);
+  CHECK(maxHoldUs < (CONVERSION_MS * 1000L)); // The bus is never held across a conversion
+}
+
+//-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
+static const test_t tests[] = {
+  {"lock depth and release during the ADC wait", testLockDepth},
+  {"two tasks sharing the bus", testStress},
+};
+
+int main()
+{
+  return (runTests(tests, sizeof(tests) / sizeof(tests[0])));
+}
@@ -0,0 +1,211 @@
+/*!
+ * @file SparkFun_smol_Power_Board_Scheduler_Tests.cpp
+ *
+ * SparkFun smôl Power Board Arduino Library - host tests
+ *
+ * Runs sfeSmolPowerScheduler against a discharge model and the mock transport (a simulated ATtiny43U).
+ * Each wake cycle costs a fixed amount of capacity, and sleeping costs capacity in proportion to the
+ * sleep interval. The scheduler's state is saved and restored each cycle, as it would be across a
+ * power-down, and each interval is written to the board with powerDownFor.
+ *
+ * Build and run from this directory:
+ *   g++ -std=gnu++11 -O2 -DSFE_SMOL_POWER_TRANSPORT_MOCK -DSFE_SMOL_POWER_SIMULATED_CLOCK -I../../src SparkFun_smol_Power_Board_Scheduler_Tests.cpp ../../src/SparkFun*.cpp -o scheduler_tests && ./scheduler_tests
+ *
+ * The exit status is the number of failed tests.
+ *
+ * Please see LICENSE.md for the license information
+ *
+ */
+
+#include "SparkFun_smol_Power_Board.h"
+#include "SparkFun_smol_Power_Board_Scheduler.h"
+
+#include "SparkFun_smol_Power_Board_Test.h"
+
+#define MIN_SLEEP_MS 1000UL
+#define MAX_SLEEP_MS 3600000UL
+#define SECONDS_PER_DAY 86400.0
+
+/** The discharge model. Capacity is in 0.01%, as the scheduler expects */
+static const double awakeMS = 300.0;               // The time awake each cycle
+static const double wakeCost = 0.02;               // The capacity used each time the node wakes
+static const double sleepCostPerSecond = 0.0001;   // The capacity used each second while asleep
+
+/** The lifetime in days if the node always sleeps for sleepMS */
+static double fixedSleepLifetimeDays(unsigned long sleepMS)
+{
+  double cycles = SFE_SMOL_POWER_CAPACITY_FULL / (wakeCost + (sleepCostPerSecond * sleepMS / 1000.0));
+  return ((cycles * (sleepMS + awakeMS)) / 1000.0 / SECONDS_PER_DAY);
+}
+
+typedef struct
+{
+  double lifetimeDays;                  // How long the battery lasted
+  unsigned long firstSleepMS;           // The interval chosen for the first cycle
+  unsigned long lastSleepMS;            // The interval chosen for the last cycle
+  unsigned long maxSleepBeforeTargetMS; // The longest interval chosen before the target lifetime
+  unsigned long outOfLimits;            // The number of intervals outside the sleep limits
+  unsigned long notAchievable;          // The number of intervals the WDT can't achieve exactly
+  unsigned long powerDownFails;         // The number of failed powerDownFor calls
+  unsigned long cycles;
+} discharge_result_t;
+
+/** Run the scheduler until the battery is empty, or for 4 times the target */
+static discharge_result_t discharge(unsigned long targetSeconds)
+{
+  discharge_result_t result = {};
+  sfeSmolPowerMockBoard mock;
+  smolPowerAAA board;
+  board.begin(SFE_SMOL_POWER_DEFAULT_I2C_ADDRESS, mock);
+
+  sfe_power_board_schedule_state_t state;
+  sfeSmolPowerScheduler scheduler;
+  scheduler.getState(state);
+
+  double capacity = SFE_SMOL_POWER_CAPACITY_FULL;
+  double seconds = 0;
+  double limitSeconds = ((targetSeconds > 0) ? targetSeconds : 365 * SECONDS_PER_DAY) * 4;
+  while ((capacity > 0) && (seconds < limitSeconds))
+  {
+    // The node has woken: the RAM has been lost, so restore the state
+    sfeSmolPowerScheduler wake;
+    wake.setSleepLimits(MIN_SLEEP_MS, MAX_SLEEP_MS);
+    wake.setTargetLifetime(targetSeconds);
+    wake.setState(state);
+
+    unsigned long sleepMS = wake.nextSleepMS((unsigned long)awakeMS, (uint16_t)(capacity + 0.5));
+    wake.getState(state);
+
+    sfe_power_board_powerdown_plan_t plan;
+    if ((sleepMS < MIN_SLEEP_MS) || (sleepMS > MAX_SLEEP_MS))
+      result.outOfLimits++;
+    if (!sfeSmolPowerBoard::planPowerDown(sleepMS, plan) || (plan.durationMS != sleepMS))
+      result.notAchievable++;
+    if (!board.powerDownFor(sleepMS, &plan) || (mock.getPowerDownCount() != result.cycles + 1))
+      result.powerDownFails++;
+
+    if (result.cycles == 0)
+      result.firstSleepMS = sleepMS;
+    if ((seconds < targetSeconds) && (sleepMS > result.maxSleepBeforeTargetMS))
+      result.maxSleepBeforeTargetMS = sleepMS;
+    result.lastSleepMS = sleepMS;
+    result.cycles++;
+    capacity -= wakeCost + (sleepCostPerSecond * sleepMS / 1000.0);
+    seconds += (sleepMS + awakeMS) / 1000.0;
+  }
+  result.lifetimeDays = seconds / SECONDS_PER_DAY;
+
+  // The board holds the last plan
+  sfe_power_board_powerdown_plan_t plan;
+  sfeSmolPowerBoard::planPowerDown(result.lastSleepMS, plan);
+  CHECK(mock.getRegister(SFE_SMOL_POWER_REGISTER_WDT_PRESCALER) == plan.prescaler);
+  CHECK(mock.getRegister(SFE_SMOL_POWER_REGISTER_POWERDOWN_DURATION) == plan.wdtInts);
+  return (result);
+}
+
+static void checkCycles(const discharge_result_t &result)
+{
+  CHECK(result.outOfLimits == 0);
+  CHECK(result.notAchievable == 0);
+  CHECK(result.powerDownFails == 0);
+}
+
+//-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
+/** Targets between the shortest and longest achievable lifetimes are met to within 5% */
+static void testLifetimeTargets()
+{
+  static const unsigned long targetDays[] = {10, 35, 60, 180};
+  for (size_t i = 0; i < sizeof(targetDays) / sizeof(targetDays[0]); i++)
+  {
+    discharge_result_t result = discharge(targetDays[i] * 86400UL);
+    printf("  target %lu days: lasted %.1f days, %lu cycles, last sleep %lums\n", targetDays[i], result.lifetimeDays, result.cycles, result.lastSleepMS);
+    checkCycles(result);
+    CHECK(result.firstSleepMS == MIN_SLEEP_MS); // Start short, so the discharge rate is measured sooner
+    CHECK(result.lifetimeDays >= targetDays[i] * 0.95);
+    CHECK(result.lifetimeDays <= targetDays[i] * 1.05);
+  }
+}
+
+/** A target which can't be met: the scheduler does the best it can at the sleep limits */
+static void testUnreachableTargets()
+{
+  // Too short: sleep for the minimum until the target has passed, then last as long as possible
+  double shortest = fixedSleepLifetimeDays(MIN_SLEEP_MS);
+  discharge_result_t result = discharge((unsigned long)(shortest / 2 * SECONDS_PER_DAY));
+  printf("  target %.1f days: lasted %.1f days (%.1f at the minimum sleep)\n", shortest / 2, result.lifetimeDays, shortest);
+  checkCycles(result);
+  CHECK(result.maxSleepBeforeTargetMS == MIN_SLEEP_MS);
+  CHECK(result.lastSleepMS == MAX_SLEEP_MS);
+  CHECK(result.lifetimeDays >= shortest);
+
+  // Too long: stretch to the maximum
+  double longest = fixedSleepLifetimeDays(MAX_SLEEP_MS);
+  result = discharge((unsigned long)(longest * 2 * SECONDS_PER_DAY));
+  printf("  target %.1f days: lasted %.1f days (%.1f at the maximum sleep)\n", longest * 2, result.lifetimeDays, longest);
+  checkCycles(result);
+  CHECK(result.lastSleepMS == MAX_SLEEP_MS);
+  CHECK(result.lifetimeDays >= longest * 0.95);
+}
+
+/** Reporting-rate mode: the interval stretches from the minimum to the maximum as the battery sags */
+static void testReportingRate()
+{
+  sfeSmolPowerScheduler scheduler;
+  scheduler.setSleepLimits(MIN_SLEEP_MS, MAX_SLEEP_MS);
+  scheduler.setCapacityLimits(1000, 8000);
+  unsigned long previous = 0;
+  bool monotonic = true;
+  for (int capacity = SFE_SMOL_POWER_CAPACITY_FULL; capacity >= 0; capacity -= 100)
+  {
+    unsigned long sleepMS = scheduler.nextSleepMS((unsigned long)awakeMS, (uint16_t)capacity);
+    if (sleepMS < previous)
+      monotonic = false;
+    previous = sleepMS;
+    if (capacity >= 8000)
+      CHECK(sleepMS == MIN_SLEEP_MS);
+    if (capacity <= 1000)
+      CHECK(sleepMS == MAX_SLEEP_MS);
+  }
+  CHECK(monotonic);
+
+  discharge_result_t result = discharge(0);
+  printf("  reporting rate: lasted %.1f days\n", result.lifetimeDays);
+  checkCycles(result);
+  CHECK(result.lastSleepMS == MAX_SLEEP_MS);
+  CHECK(result.lifetimeDays > fixedSleepLifetimeDays(MIN_SLEEP_MS));
+  CHECK(result.lifetimeDays < fixedSleepLifetimeDays(MAX_SLEEP_MS));
+}
+
+/** A rise in capacity (the battery was charged) restarts the rate measurement */
+static void testCharging()
+{
+  sfeSmolPowerScheduler scheduler;
+  scheduler.setTargetLifetime(30 * 86400UL);
+  sfe_power_board_schedule_state_t state;
+
+  scheduler.nextSleepMS(300, 5000);
+  scheduler.nextSleepMS(300, 4990);
+  scheduler.getState(state);
+  CHECK(state.referenceCapacity == 5000);
+  CHECK(state.cycles == 1);
+
+  scheduler.nextSleepMS(300, 9000);
+  scheduler.getState(state);
+  CHECK(state.referenceCapacity == 9000);
+  CHECK(state.cycles == 0);
+}
+
+//-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
+static const test_t tests[] = {
+  {"lifetime targets", testLifetimeTargets},
+  {"unreachable lifetime targets", testUnreachableTargets},
+  {"reporting rate", testReportingRate},
+  {"charging restarts the measurement", testCharging},
+};
+
+int main()
+{
+  return (runTests(tests, sizeof(tests) / sizeof(tests[0])));
+}
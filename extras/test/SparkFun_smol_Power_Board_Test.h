@@ -0,0 +1,54 @@
+/*!
+ * @file SparkFun_smol_Power_Board_Test.h
+ *
+ * SparkFun smôl Power Board Arduino Library - host tests
+ *
+ * The CHECK macro and test runner shared by the host tests. Each test program's exit status is
+ * the number of failed tests.
+ *
+ * Please see LICENSE.md for the license information
+ *
+ */
+
+#ifndef __SFE_SMOL_POWER_TEST__
+#define __SFE_SMOL_POWER_TEST__
+
+#include <stdio.h>
+#include <stddef.h>
+
+static int checksFailed = 0;
+
+#define CHECK(condition)                                                       \
+  do                                                                           \
+  {                                                                            \
+    if (!(condition))                                                          \
+    {                                                                          \
+      printf("  %s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); \
+      checksFailed++;                                                          \
+    }                                                                          \
+  } while (0)
+
+typedef struct
+{
+  const char *name;
+  void (*test)();
+} test_t;
+
+/** Run each test, print PASS or FAIL, and return the number of tests which failed */
+static int runTests(const test_t *tests, size_t count)
+{
+  int failed = 0;
+  for (size_t i = 0; i < count; i++)
+  {
+    int before = checksFailed;
+    tests[i].test();
+    bool passed = (checksFailed == before);
+    printf("%s: %s\n", passed ? "PASS" : "FAIL", tests[i].name);
+    if (!passed)
+      failed++;
+  }
+  printf("%d of %d tests failed\n", failed, (int)count);
+  return (failed);
+}
+
+#endif // /__SFE_SMOL_POWER_TEST__
@@ -0,0 +1,995 @@
+/*!
+ * @file SparkFun_smol_Power_Board_Tests.cpp
+ *
+ * SparkFun smôl Power Board Arduino Library - host tests
+ *
+ * Runs the library with its TwoWire transport against the simulated ATtiny43U (sfeSmolPowerMockBoard)
+ * and a stub MAX17048, on a host. The clock is simulated, so the ADC and eeprom waits cost no real time.
+ *
+ * Build and run from this directory:
+ *   g++ -std=gnu++11 -DARDUINO=10813 -DSFE_SMOL_POWER_MOCK_BOARD -Ihost -I../../src SparkFun_smol_Power_Board_Tests.cpp host/SparkFun*.cpp ../../src/SparkFun*.cpp -o tests && ./tests
+ *
+ * The exit status is the number of failed tests.
+ *
+ * Please see LICENSE.md for the license information
+ *
+ */
+
+#include "SparkFun_smol_Power_Board.h"
+#include "SparkFun_smol_Power_Board_Filters.h"
+#include "SparkFun_smol_Power_Board_Manager.h"
+#include "SparkFun_smol_Power_Board_Runtime.h"
+#include "SparkFun_smol_Power_Board_Events.h"
+#include "SparkFun_smol_Power_Board_History.h"
+
+#include "SparkFun_smol_Power_Board_Test.h"
+
+static const sfe_power_board_retry_policy_t noRetries = {0, 0, 0};
+static const sfe_power_board_retry_policy_t someRetries = {3, 2, 0};
+
+/** Service a split-phase measurement until it is ready, advancing the clock 1ms between polls */
+static bool pollUntilReady(sfeSmolPowerBoard &board, unsigned long timeoutMS = 100)
+{
+  for (unsigned long i = 0; i < timeoutMS; i++)
+  {
+    if (board.poll())
+      return (true);
+    sfeSmolPowerAdvanceClock(1);
+  }
+  return (false);
+}
+
+/** Put a fresh simulated board on the bus and begin */
+template <typename Board>
+static bool attach(sfeSmolPowerMockBoard &mock, Board &board)
+{
+  Wire.detachAll();
+  Wire.attach(mock);
+  return (board.begin(mock.getAddress(), Wire));
+}
+
+//-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
+static void testReadSingleByteShortRead()
+{
+  sfeSmolPowerMockBoard mock;
+  smolPowerAAA board;
+  CHECK(attach(mock, board));
+  board.setRetryPolicy(noRetries);
+
+  byte value = 0xAA;
+  CHECK(board.smolPowerBoard_io.readSingleByte(SFE_SMOL_POWER_REGISTER_I2C_ADDRESS, &value));
+  CHECK(value == SFE_SMOL_POWER_DEFAULT_I2C_ADDRESS);
+
+  // Without retries, a short read fails and the buffer is left unchanged
+  value = 0xAA;
+  mock.injectShortReads(1);
+  CHECK(!board.smolPowerBoard_io.readSingleByte(SFE_SMOL_POWER_REGISTER_I2C_ADDRESS, &value));
+  CHECK(value == 0xAA);
+  CHECK(board.getLastError() == SFE_SMOL_POWER_ERROR_SHORT_READ);
+
+  // A retry recovers, and the error is not recorded
+  board.setRetryPolicy(someRetries);
+  mock.injectShortReads(1);
+  CHECK(board.smolPowerBoard_io.readSingleByte(SFE_SMOL_POWER_REGISTER_I2C_ADDRESS, &value));
+  CHECK(value == SFE_SMOL_POWER_DEFAULT_I2C_ADDRESS);
+  CHECK(board.getLastError() == SFE_SMOL_POWER_ERROR_NONE);
+
+  // More short reads than retries
+  mock.injectShortReads(someRetries.retries + 1);
+  CHECK(!board.smolPowerBoard_io.readSingleByte(SFE_SMOL_POWER_REGISTER_I2C_ADDRESS, &value));
+  CHECK(board.getLastError() == SFE_SMOL_POWER_ERROR_SHORT_READ);
+}
+
+static void testPowerDownDuration()
+{
+  sfeSmolPowerMockBoard mock;
+  smolPowerAAA board;
+  CHECK(attach(mock, board));
+  board.setRetryPolicy(noRetries);
+
+  uint16_t duration = 0;
+  mock.setRegister(SFE_SMOL_POWER_REGISTER_POWERDOWN_DURATION, 1234);
+  CHECK(board.getPowerDownDurationWDTInts(&duration));
+  CHECK(duration == 1234);
+
+  // A short read fails without changing the duration
+  duration = 77;
+  mock.injectShortReads(1);
+  CHECK(!board.getPowerDownDurationWDTInts(&duration));
+  CHECK(duration == 77);
+  CHECK(board.getLastError() == SFE_SMOL_POWER_ERROR_SHORT_READ);
+
+  board.setRetryPolicy(someRetries);
+  mock.injectShortReads(2);
+  CHECK(board.getPowerDownDurationWDTInts(&duration));
+  CHECK(duration == 1234);
+
+  // Round trip. The frame carries a CRC, so the board must accept it
+  CHECK(board.setPowerdownDurationWDTInts(600));
+  CHECK(mock.getRegister(SFE_SMOL_POWER_REGISTER_POWERDOWN_DURATION) == 600);
+  CHECK(board.getPowerDownDurationWDTInts(&duration));
+  CHECK(duration == 600);
+  CHECK(mock.getCRCErrorCount() == 0);
+
+  // The longest power-down is 65535 x 8s. Anything longer fails without touching the board, however close to 2^32
+  sfe_power_board_powerdown_plan_t plan;
+  CHECK(sfeSmolPowerBoard::planPowerDown(0xFFFFUL * 8000, plan));
+  CHECK((plan.prescaler == SFE_SMOL_POWER_WDT_TIMEOUT_8s) && (plan.wdtInts == 0xFFFF) && (plan.errorMS == 0));
+  CHECK(sfeSmolPowerBoard::planPowerDown((0xFFFFUL * 8000) - 3999, plan));
+  CHECK((plan.wdtInts == 0xFFFF) && (plan.errorMS == 3999));
+  CHECK(sfeSmolPowerBoard::planPowerDown(3000, plan));
+  CHECK((plan.prescaler == SFE_SMOL_POWER_WDT_TIMEOUT_1s) && (plan.wdtInts == 3) && (plan.errorMS == 0));
+  CHECK(sfeSmolPowerBoard::planPowerDown(8100, plan, 0));
+  CHECK((plan.prescaler == SFE_SMOL_POWER_WDT_TIMEOUT_32ms) && (plan.durationMS == 8096) && (plan.errorMS == -4));
+  CHECK(sfeSmolPowerBoard::planPowerDown(8190, plan, 0));
+  CHECK((plan.durationMS == 8192) && (plan.errorMS == 2));
+  CHECK(!sfeSmolPowerBoard::planPowerDown((0xFFFFUL * 8000) + 1, plan));
+  CHECK(!sfeSmolPowerBoard::planPowerDown(0xFFFFFFFFUL - 3000, plan));
+  CHECK(!sfeSmolPowerBoard::planPowerDown(0xFFFFFFFFUL, plan));
+  CHECK(!sfeSmolPowerBoard::planPowerDown(0, plan));
+  unsigned long transactions = mock.getTransactionCount();
+  CHECK(!board.powerDownFor(0xFFFFFFFFUL));
+  CHECK(board.getLastError() == SFE_SMOL_POWER_ERROR_INVALID_VALUE);
+  CHECK(mock.getTransactionCount() == transactions);
+  CHECK(mock.getPowerDownCount() == 0);
+}
+
+static void testCRCRejection()
+{
+  sfeSmolPowerMockBoard mock;
+  smolPowerAAA board;
+  CHECK(attach(mock, board));
+
+  byte prescaler = SFE_SMOL_POWER_WDT_TIMEOUT_2s;
+  byte before = mock.getRegister(SFE_SMOL_POWER_REGISTER_WDT_PRESCALER);
+  CHECK(before != prescaler);
+
+  // A bad CRC is acknowledged but ignored
+  byte badCRC[2] = {prescaler, (byte)(sfeSmolPowerCRC8(&prescaler, 1) ^ 0x01)};
+  CHECK(board.smolPowerBoard_io.writeMultipleBytes(SFE_SMOL_POWER_REGISTER_WDT_PRESCALER, badCRC, 2));
+  CHECK(mock.getCRCErrorCount() == 1);
+  CHECK(mock.getRegister(SFE_SMOL_POWER_REGISTER_WDT_PRESCALER) == before);
+  CHECK(board.getWatchdogTimerPrescaler() == (sfe_power_board_WDT_prescale_e)before);
+
+  // So is a frame of the wrong size
+  byte tooLong[3] = {prescaler, sfeSmolPowerCRC8(&prescaler, 1), 0};
+  CHECK(board.smolPowerBoard_io.writeMultipleBytes(SFE_SMOL_POWER_REGISTER_WDT_PRESCALER, tooLong, 3));
+  CHECK(mock.getCRCErrorCount() == 2);
+  CHECK(mock.getRegister(SFE_SMOL_POWER_REGISTER_WDT_PRESCALER) == before);
+
+  // The library's own frame is accepted
+  CHECK(board.setWatchdogTimerPrescaler((sfe_power_board_WDT_prescale_e)prescaler));
+  CHECK(mock.getCRCErrorCount() == 2);
+  CHECK(mock.getRegister(SFE_SMOL_POWER_REGISTER_WDT_PRESCALER) == prescaler);
+}
+
+static void testEEPROMUpdateLatency()
+{
+  sfeSmolPowerMockBoard mock;
+  smolPowerAAA board;
+  CHECK(attach(mock, board));
+  board.setRetryPolicy(noRetries);
+
+  // Faster than the library's eeprom wait: the read-back succeeds first time
+  mock.setEEPROMUpdateTime(4);
+  CHECK(board.setWatchdogTimerPrescaler(SFE_SMOL_POWER_WDT_TIMEOUT_1s));
+  CHECK(board.getLastError() == SFE_SMOL_POWER_ERROR_NONE);
+
+  // Slower: the board NACKs the read-back
+  mock.setEEPROMUpdateTime(10);
+  CHECK(!board.setWatchdogTimerPrescaler(SFE_SMOL_POWER_WDT_TIMEOUT_2s));
+  CHECK(board.getLastError() == SFE_SMOL_POWER_ERROR_NACK_ADDRESS);
+  CHECK(mock.getRegister(SFE_SMOL_POWER_REGISTER_WDT_PRESCALER) == SFE_SMOL_POWER_WDT_TIMEOUT_2s);
+  delay(10);
+
+  // Retries ride out the update
+  board.setRetryPolicy(someRetries);
+  CHECK(board.setWatchdogTimerPrescaler(SFE_SMOL_POWER_WDT_TIMEOUT_4s));
+  CHECK(board.getLastError() == SFE_SMOL_POWER_ERROR_NONE);
+  CHECK(mock.getRegister(SFE_SMOL_POWER_REGISTER_WDT_PRESCALER) == SFE_SMOL_POWER_WDT_TIMEOUT_4s);
+}
+
+static void testADCConversionTime()
+{
+  sfeSmolPowerMockBoard mock;
+  smolPowerAAA board;
+  CHECK(attach(mock, board));
+  board.setRetryPolicy(noRetries);
+
+  uint16_t raw = 0;
+  mock.setConversionTime(12);
+  CHECK(board.getRawTemperature(&raw));
+  CHECK(raw == mock.getRegister(SFE_SMOL_POWER_REGISTER_TEMPERATURE));
+
+  // Longer than SFE_SMOL_POWER_ADC_READ_DELAY
+  mock.setConversionTime(SFE_SMOL_POWER_ADC_READ_DELAY + 5);
+  CHECK(!board.getRawTemperature(&raw));
+  CHECK(board.getLastError() == SFE_SMOL_POWER_ERROR_SHORT_READ);
+
+  // Each retry writes the register address again, which restarts the conversion
+  board.setRetryPolicy(someRetries);
+  CHECK(!board.getRawTemperature(&raw));
+}
+
+/** A VCC measurement of 0 fails the batch, instead of reporting every reading as 0mV */
+static void testSampleBatteryZeroVCC()
+{
+  sfeSmolPowerMockBoard mock;
+  smolPowerAAA board;
+  CHECK(attach(mock, board));
+  board.setRetryPolicy(noRetries);
+  mock.setRegister(SFE_SMOL_POWER_REGISTER_ADC_REFERENCE, SFE_SMOL_POWER_USE_ADC_REF_VCC);
+  mock.setRegister(SFE_SMOL_POWER_REGISTER_VBAT, 500);
+
+  sfe_power_board_sample_stats_t stats;
+  int32_t millivolts = ((500 * SFE_SMOL_POWER_VBAT_MV_NUMERATOR) + (341 / 2)) / 341; // VBAT with a 3.3V VCC reference
+  CHECK(board.sampleBattery(8, stats));
+  CHECK((stats.count == 8) && (stats.minimum == millivolts) && (stats.maximum == millivolts) && (stats.variance == 0));
+
+  mock.setRegister(SFE_SMOL_POWER_REGISTER_1V1, 0);
+  CHECK(!board.sampleBattery(8, stats));
+  CHECK(board.getLastError() == SFE_SMOL_POWER_ERROR_INVALID_VALUE);
+  CHECK(stats.count == 0);
+
+  // Re-measured part-way through the batch
+  mock.setRegister(SFE_SMOL_POWER_REGISTER_1V1, 341);
+  board.setVCCCacheTTL(1000);
+  uint16_t raw1V1;
+  CHECK(board.getRaw1V1(&raw1V1) && (raw1V1 == 341));
+  mock.setRegister(SFE_SMOL_POWER_REGISTER_1V1, 0);
+  CHECK(!board.sampleBattery(8, stats, 4));
+  CHECK(stats.count == 4);
+
+  // A 0 is not cached: the next batch measures VCC again
+  CHECK(board.getRaw1V1(&raw1V1) && (raw1V1 == 0));
+  CHECK(!board.sampleBattery(8, stats));
+  CHECK(stats.count == 0);
+
+  // The 1.1V reference does not need VCC
+  mock.setRegister(SFE_SMOL_POWER_REGISTER_ADC_REFERENCE, SFE_SMOL_POWER_USE_ADC_REF_1V1);
+  board.invalidateCache();
+  CHECK(board.sampleBattery(8, stats));
+  CHECK(stats.count == 8);
+}
+
+/** Check stats against the exact statistics of the readings, scaled by scale */
+static void checkStatistics(const sfe_power_board_sample_stats_t &stats, const int32_t *readings, int count, int32_t scale)
+{
+  int64_t n = count;
+  int64_t sum = 0;
+  int64_t sumDD = 0; // Deviations from the first reading: the sums stay small enough for int64_t
+  int32_t minimum = readings[0];
+  int32_t maximum = readings[0];
+  for (int i = 0; i < count; i++)
+  {
+    int64_t deviation = readings[i] - readings[0];
+    sum += deviation;
+    sumDD += deviation * deviation;
+    minimum = (readings[i] < minimum) ? readings[i] : minimum;
+    maximum = (readings[i] > maximum) ? readings[i] : maximum;
+  }
+  CHECK(stats.count == count);
+  CHECK((stats.minimum == minimum * scale) && (stats.maximum == maximum * scale));
+
+  // The mean is within half a unit: |(mean * n) - sum of the readings| <= n / 2
+  int64_t meanError = (((int64_t)stats.mean - ((int64_t)readings[0] * scale)) * n) - (sum * scale);
+  CHECK(2 * ((meanError < 0) ? -meanError : meanError) <= n);
+
+  // The variance is the nearest integer to ((n * sumDD) - sum^2) * scale^2 / (n * (n - 1))
+  int64_t numerator = ((n * sumDD) - (sum * sum)) * scale * scale;
+  int64_t denominator = n * (n - 1);
+  int64_t varianceError = ((int64_t)stats.variance * denominator) - numerator;
+  CHECK(2 * ((varianceError < 0) ? -varianceError : varianceError) <= denominator);
+  CHECK(((uint64_t)stats.standardDeviation * stats.standardDeviation) <= stats.variance);
+  CHECK(((uint64_t)(stats.standardDeviation + 1) * (stats.standardDeviation + 1)) > stats.variance);
+}
+
+static void testStatisticsVariance()
+{
+  sfeSmolPowerStatistics statistics;
+  sfe_power_board_sample_stats_t stats;
+
+  // The textbook example: mean 5, sample variance 32 / 7
+  static const int32_t textbook[] = {2, 4, 4, 4, 5, 5, 7, 9};
+  for (int i = 0; i < 8; i++)
+    statistics.update(textbook[i]);
+  statistics.get(stats);
+  CHECK((stats.mean == 5) && (stats.variance == 5) && (stats.standardDeviation == 2));
+  checkStatistics(stats, textbook, 8, 1);
+  statistics.get(stats, 100, 0);
+  CHECK((stats.mean == 500) && (stats.variance == 45714) && (stats.standardDeviation == 213));
+
+  // A large offset: no cancellation
+  int32_t offset[8];
+  statistics.reset();
+  for (int i = 0; i < 8; i++)
+  {
+    offset[i] = 1000000000 + textbook[i];
+    statistics.update(offset[i]);
+  }
+  statistics.get(stats);
+  CHECK((stats.mean == 1000000005) && (stats.variance == 5));
+  checkStatistics(stats, offset, 8, 1);
+
+  // Pseudo-random readings, across the full +/-32767 range and with an uneven remainder
+  static int32_t readings[1001];
+  uint32_t seed = 12345;
+  for (int scale = 1; scale <= 100; scale += 99)
+  {
+    int32_t range = (scale == 1) ? 32767 : 300; // Keep the scaled variance within 32 bits
+    for (int count = 2; count <= ((scale == 1) ? 1001 : 200); count = (count * 3) + 1)
+    {
+      statistics.reset();
+      for (int i = 0; i < count; i++)
+      {
+        seed = (seed * 1103515245) + 12345;
+        readings[i] = 3000 + ((i == 0) ? 0 : ((int32_t)((seed >> 8) % ((2 * range) + 1)) - range));
+        statistics.update(readings[i]);
+      }
+      statistics.get(stats, scale, 0);
+      checkStatistics(stats, readings, count, scale);
+    }
+  }
+}
+
+/** The ADC waits overlap: N boards take one conversion window, not N */
+static void testManagerMeasureAll()
+{
+  static const byte boards = SFE_SMOL_POWER_HOST_WIRE_DEVICES;
+  sfeSmolPowerMockBoard mocks[boards] = {sfeSmolPowerMockBoard(0x50), sfeSmolPowerMockBoard(0x51), sfeSmolPowerMockBoard(0x52), sfeSmolPowerMockBoard(0x53)};
+  smolPowerAAA board[boards];
+  sfeSmolPowerBoardManager manager;
+  Wire.detachAll();
+  for (byte i = 0; i < boards; i++)
+  {
+    CHECK(Wire.attach(mocks[i]));
+    mocks[i].setConversionTime(12);
+    mocks[i].setRegister(SFE_SMOL_POWER_REGISTER_TEMPERATURE, 300 + i);
+    CHECK(board[i].begin(mocks[i].getAddress(), Wire));
+    board[i].setRetryPolicy(noRetries);
+    CHECK(manager.addBoard(board[i]));
+  }
+
+  // One board alone takes one conversion window
+  uint16_t raw;
+  unsigned long start = millis();
+  CHECK(board[0].getRawTemperature(&raw));
+  unsigned long window = millis() - start;
+  CHECK((window >= 12) && (window <= SFE_SMOL_POWER_ADC_READ_DELAY));
+
+  start = millis();
+  CHECK(manager.measureAll(SFE_SMOL_POWER_MEASUREMENT_TEMPERATURE));
+  CHECK((millis() - start) == window);
+  for (byte i = 0; i < boards; i++)
+    CHECK(manager.getFixedPointResult(i) == ((300 + i - SFE_SMOL_POWER_TEMPERATURE_RAW_AT_0C) * 100));
+
+  // The deadline runs from the start of measureAll, not from each poll. Each retry restarts the conversion
+  sfe_power_board_retry_policy_t deadline = {3, 2, 20};
+  for (byte i = 0; i < boards; i++)
+    board[i].setRetryPolicy(deadline);
+  mocks[1].injectShortReads(2);
+  start = millis();
+  CHECK(!manager.measureAll(SFE_SMOL_POWER_MEASUREMENT_TEMPERATURE));
+  CHECK((millis() - start) <= 20);
+  CHECK(board[1].getLastError() == SFE_SMOL_POWER_ERROR_TIMEOUT);
+  CHECK(manager.getFixedPointResult(1) == SFE_SMOL_POWER_TEMPERATURE_CENTI_C_ERROR);
+  CHECK(manager.getFixedPointResult(0) == ((300 - SFE_SMOL_POWER_TEMPERATURE_RAW_AT_0C) * 100));
+  Wire.detachAll();
+}
+
+/** applyConfig writes only the fields which differ, changes the address last and reports each failed field */
+static void testApplyConfig()
+{
+  sfeSmolPowerMockBoard mock;
+  smolPowerAAA board;
+  CHECK(attach(mock, board));
+  board.setRetryPolicy(noRetries);
+  mock.setEEPROMUpdateTime(4); // Within the library's eeprom wait
+
+  sfe_power_board_config_t config;
+  CHECK(board.readConfig(config));
+  CHECK(config.i2cAddress == SFE_SMOL_POWER_DEFAULT_I2C_ADDRESS);
+
+  // Nothing has changed: no writes, so no eeprom waits
+  unsigned long start = millis();
+  CHECK(board.applyConfig(config) == 0);
+  CHECK(millis() == start);
+
+  // Only the changed register is written: one eeprom wait
+  config.wdtPrescaler = SFE_SMOL_POWER_WDT_TIMEOUT_1s;
+  start = millis();
+  CHECK(board.applyConfig(config) == 0);
+  CHECK((millis() - start) == SFE_SMOL_POWER_EEPROM_UPDATE_DELAY);
+  CHECK(mock.getRegister(SFE_SMOL_POWER_REGISTER_WDT_PRESCALER) == SFE_SMOL_POWER_WDT_TIMEOUT_1s);
+
+  // Fields which are not selected are not written
+  config.powerDownDuration = 1234;
+  config.adcReference = SFE_SMOL_POWER_USE_ADC_REF_VCC;
+  CHECK(board.applyConfig(config, SFE_SMOL_POWER_CONFIG_POWERDOWN_DURATION) == 0);
+  CHECK(mock.getRegister(SFE_SMOL_POWER_REGISTER_POWERDOWN_DURATION) == 1234);
+  CHECK(mock.getRegister(SFE_SMOL_POWER_REGISTER_ADC_REFERENCE) == SFE_SMOL_POWER_USE_ADC_REF_1V1);
+
+  // The board moves as soon as its address is written, so the address is written last
+  config.i2cAddress = 0x42;
+  config.wdtPrescaler = SFE_SMOL_POWER_WDT_TIMEOUT_2s;
+  config.powerDownDuration = 600;
+  start = millis();
+  CHECK(board.applyConfig(config) == 0);
+  CHECK((millis() - start) == 4 * SFE_SMOL_POWER_EEPROM_UPDATE_DELAY);
+  CHECK(mock.getLastWrittenRegister() == SFE_SMOL_POWER_REGISTER_I2C_ADDRESS);
+  CHECK(mock.getAddress() == 0x42);
+  CHECK(mock.getRegister(SFE_SMOL_POWER_REGISTER_ADC_REFERENCE) == SFE_SMOL_POWER_USE_ADC_REF_VCC);
+  CHECK(mock.getRegister(SFE_SMOL_POWER_REGISTER_WDT_PRESCALER) == SFE_SMOL_POWER_WDT_TIMEOUT_2s);
+  CHECK(mock.getRegister(SFE_SMOL_POWER_REGISTER_POWERDOWN_DURATION) == 600);
+  CHECK(board.getI2CAddress() == 0x42);
+
+  // A failed write is reported for its field only. The fields after it are still applied
+  config.wdtPrescaler = SFE_SMOL_POWER_WDT_TIMEOUT_4s;
+  config.powerDownDuration = 700;
+  mock.injectErrors(1);
+  CHECK(board.applyConfig(config) == SFE_SMOL_POWER_CONFIG_WDT_PRESCALER);
+  CHECK(mock.getRegister(SFE_SMOL_POWER_REGISTER_WDT_PRESCALER) == SFE_SMOL_POWER_WDT_TIMEOUT_2s);
+  CHECK(mock.getRegister(SFE_SMOL_POWER_REGISTER_POWERDOWN_DURATION) == 700);
+  CHECK(board.applyConfig(config) == 0); // Only the prescaler is written again
+  CHECK(mock.getRegister(SFE_SMOL_POWER_REGISTER_WDT_PRESCALER) == SFE_SMOL_POWER_WDT_TIMEOUT_4s);
+
+  // A failed address write leaves the board, and the library, on the old address
+  config.i2cAddress = 0x43;
+  mock.injectErrors(1);
+  CHECK(board.applyConfig(config) == SFE_SMOL_POWER_CONFIG_I2C_ADDRESS);
+  CHECK(mock.getAddress() == 0x42);
+  CHECK(board.getI2CAddress() == 0x42);
+
+  // An eeprom slower than the library's wait NACKs the next write. Retries ride it out
+  mock.setEEPROMUpdateTime(SFE_SMOL_POWER_EEPROM_UPDATE_DELAY + 4);
+  config.i2cAddress = 0x42;
+  config.wdtPrescaler = SFE_SMOL_POWER_WDT_TIMEOUT_8s;
+  config.powerDownDuration = 800;
+  CHECK(board.applyConfig(config) != 0);
+  delay(SFE_SMOL_POWER_EEPROM_UPDATE_DELAY + 4);
+  board.setRetryPolicy(someRetries);
+  CHECK(board.applyConfig(config) == 0);
+  CHECK(mock.getRegister(SFE_SMOL_POWER_REGISTER_WDT_PRESCALER) == SFE_SMOL_POWER_WDT_TIMEOUT_8s);
+  CHECK(mock.getRegister(SFE_SMOL_POWER_REGISTER_POWERDOWN_DURATION) == 800);
+}
+
+static void testNACKInjection()
+{
+  sfeSmolPowerMockBoard mock;
+  smolPowerAAA board;
+  CHECK(attach(mock, board));
+  board.setRetryPolicy(noRetries);
+
+  mock.injectErrors(1);
+  CHECK(!board.isConnected());
+  CHECK(board.getLastError() == SFE_SMOL_POWER_ERROR_NACK_ADDRESS);
+  CHECK(board.isConnected());
+  CHECK(board.getLastError() == SFE_SMOL_POWER_ERROR_NONE);
+
+  mock.injectErrors(1, 3);
+  CHECK(!board.setPowerdownDurationWDTInts(100));
+  CHECK(board.getLastError() == SFE_SMOL_POWER_ERROR_NACK_DATA);
+
+  board.setRetryPolicy(someRetries);
+  mock.injectErrors(2);
+  CHECK(board.isConnected());
+  CHECK(board.getLastError() == SFE_SMOL_POWER_ERROR_NONE);
+}
+
+static void testSplitPhaseRetries()
+{
+  sfeSmolPowerMockBoard mock;
+  smolPowerAAA board;
+  CHECK(attach(mock, board));
+  board.setRetryPolicy(someRetries);
+
+  int32_t centiC = board.getTemperatureCentiC();
+
+  // A failed collect is retried
+  mock.injectShortReads(1);
+  CHECK(board.startTemperature());
+  CHECK(pollUntilReady(board));
+  CHECK(board.collectFixedPoint() == centiC);
+  CHECK(board.getLastError() == SFE_SMOL_POWER_ERROR_NONE);
+
+  // poll never blocks: it makes a single attempt each time it is called
+  CHECK(board.setAdaptiveADCSettle(true));
+  mock.setConversionTime(8);
+  CHECK(board.startTemperature());
+  unsigned long started = millis();
+  bool ready = false;
+  for (int i = 0; (i < 100) && !ready; i++)
+  {
+    unsigned long before = millis();
+    ready = board.poll();
+    CHECK(millis() == before);
+    if (i == 0)
+      mock.injectShortReads(1); // Fail the first attempt after the conversion, so a retry is scheduled
+    sfeSmolPowerAdvanceClock(1);
+  }
+  CHECK(ready);
+  CHECK(millis() - started >= 8);
+  CHECK(board.getMeasurementState() == SFE_SMOL_POWER_MEASUREMENT_COMPLETE);
+  CHECK(board.collectFixedPoint() == centiC);
+}
+
+static void testBurstReadFallback()
+{
+  sfeSmolPowerMockBoard mock;
+  smolPowerAAA board;
+  CHECK(attach(mock, board));
+
+  // The board opts in, but the firmware returns only the addressed register
+  sfe_power_board_telemetry_t telemetry;
+  board.setBurstReads(true);
+  CHECK(board.getTelemetry(telemetry));
+  CHECK(telemetry.rawTemperature == mock.getRegister(SFE_SMOL_POWER_REGISTER_TEMPERATURE));
+  CHECK(telemetry.rawVBAT == mock.getRegister(SFE_SMOL_POWER_REGISTER_VBAT));
+  CHECK(board.getLastError() == SFE_SMOL_POWER_ERROR_NONE);
+
+  mock.setBurstReads(true);
+  board.setBurstReads(true);
+  CHECK(board.getTelemetry(telemetry));
+  CHECK(telemetry.rawTemperature == mock.getRegister(SFE_SMOL_POWER_REGISTER_TEMPERATURE));
+  CHECK(telemetry.rawVBAT == mock.getRegister(SFE_SMOL_POWER_REGISTER_VBAT));
+}
+
+static void testResetReasonKeepsShadows()
+{
+  sfeSmolPowerMockBoard mock;
+  smolPowerAAA board;
+  CHECK(attach(mock, board));
+
+  // The first reason read since begin invalidates the shadows. The same reason again does not
+  board.getResetReason();
+  CHECK(board.getCachedWatchdogTimerPrescaler() != SFE_SMOL_POWER_WDT_TIMEOUT_UNDEFINED);
+  board.getResetReason();
+  unsigned long transactions = mock.getTransactionCount();
+  CHECK(board.getCachedWatchdogTimerPrescaler() != SFE_SMOL_POWER_WDT_TIMEOUT_UNDEFINED);
+  CHECK(mock.getTransactionCount() == transactions);
+
+  // A new reset reason means the board may have reset: the shadows are read again
+  mock.setRegister(SFE_SMOL_POWER_REGISTER_RESET_REASON, SFE_SMOL_POWER_RESET_REASON_WDRF);
+  board.getResetReason();
+  transactions = mock.getTransactionCount();
+  CHECK(board.getCachedWatchdogTimerPrescaler() != SFE_SMOL_POWER_WDT_TIMEOUT_UNDEFINED);
+  CHECK(mock.getTransactionCount() > transactions);
+}
+
+static void testLiPoFuelGauge()
+{
+  sfeSmolPowerMockBoard mock;
+  smolPowerLiPo board;
+  CHECK(attach(mock, board));
+  SFE_MAX1704X &gauge = board.getFuelGauge();
+
+  gauge.setVoltage(3.8);
+  gauge.setSOC(75.0);
+  gauge.setChangeRate(-1.5);
+  CHECK(board.getBatteryMillivolts() == 3800);
+  CHECK(board.startBatteryVoltage());
+  CHECK(board.getMeasurementState() == SFE_SMOL_POWER_MEASUREMENT_COMPLETE);
+  CHECK(board.collectFixedPoint() == 3800);
+
+  sfeSmolPowerRuntime<> runtime;
+  CHECK(runtime.sample(board));
+
+  // A gauge which does not respond reads 0: the measurement fails and no sample is taken
+  gauge.setConnected(false);
+  CHECK(board.getBatteryMillivolts() == 0);
+  CHECK(!board.startBatteryVoltage());
+  CHECK(board.getMeasurementState() == SFE_SMOL_POWER_MEASUREMENT_FAILED);
+  CHECK(!runtime.sample(board));
+  sfe_power_board_telemetry_t telemetry;
+  CHECK(!board.getTelemetry(telemetry));
+  CHECK(telemetry.batteryMillivolts == 0);
+  CHECK(board.getLastError() == SFE_SMOL_POWER_ERROR_SHORT_READ);
+
+  gauge.setConnected(true);
+  CHECK(runtime.sample(board));
+  CHECK(board.getTelemetry(telemetry));
+  CHECK(telemetry.batteryMillivolts == 3800);
+}
+
+static bool sameDump(const sfe_power_board_register_dump_t &a, const sfe_power_board_register_dump_t &b)
+{
+  return ((a.valid == b.valid) && (a.i2cAddress == b.i2cAddress) && (a.resetReason == b.resetReason)
+          && (a.rawTemperature == b.rawTemperature) && (a.rawVBAT == b.rawVBAT) && (a.raw1V1 == b.raw1V1)
+          && (a.adcReference == b.adcReference) && (a.wdtPrescaler == b.wdtPrescaler)
+          && (a.powerDownDuration == b.powerDownDuration) && (a.firmwareVersion == b.firmwareVersion));
+}
+
+/** A serialized register dump round-trips, and a corrupted record or one with the wrong version is rejected */
+static void testRegisterDumpRecord()
+{
+  sfeSmolPowerMockBoard mock;
+  smolPowerAAA board;
+  CHECK(attach(mock, board));
+  mock.setRegister(SFE_SMOL_POWER_REGISTER_TEMPERATURE, 0x0123);
+  mock.setRegister(SFE_SMOL_POWER_REGISTER_VBAT, 0x0345);
+  mock.setRegister(SFE_SMOL_POWER_REGISTER_POWERDOWN_DURATION, 0xBEEF);
+
+  sfe_power_board_register_dump_t dump;
+  CHECK(board.dumpRegisters(dump));
+  byte record[SFE_SMOL_POWER_DUMP_RECORD_SIZE];
+  CHECK(sfeSmolPowerBoard::serializeRegisterDump(dump, record, sizeof(record) - 1) == 0);
+  CHECK(sfeSmolPowerBoard::serializeRegisterDump(dump, record, sizeof(record)) == SFE_SMOL_POWER_DUMP_RECORD_SIZE);
+
+  // The documented layout: little endian, whatever the host
+  CHECK(record[0] == SFE_SMOL_POWER_DUMP_RECORD_VERSION);
+  CHECK(record[3] == SFE_SMOL_POWER_DEFAULT_I2C_ADDRESS);
+  CHECK((record[5] == 0x23) && (record[6] == 0x01) && (record[7] == 0x45) && (record[8] == 0x03));
+  CHECK((record[13] == 0xEF) && (record[14] == 0xBE));
+  CHECK(record[16] == sfeSmolPowerCRC8(record, SFE_SMOL_POWER_DUMP_RECORD_SIZE - 1));
+
+  // Round trip
+  sfe_power_board_register_dump_t received;
+  memset(&received, 0, sizeof(received));
+  CHECK(!sfeSmolPowerBoard::deserializeRegisterDump(record, sizeof(record) - 1, received));
+  CHECK(sfeSmolPowerBoard::deserializeRegisterDump(record, sizeof(record), received));
+  CHECK(sameDump(received, dump));
+
+  // Any corrupted byte, including the CRC itself, is rejected. The dump is unchanged
+  for (byte i = 0; i < SFE_SMOL_POWER_DUMP_RECORD_SIZE; i++)
+  {
+    for (byte bit = 0; bit < 8; bit++)
+    {
+      record[i] ^= (1 << bit);
+      sfe_power_board_register_dump_t corrupted = received;
+      CHECK(!sfeSmolPowerBoard::deserializeRegisterDump(record, sizeof(record), corrupted));
+      CHECK(sameDump(corrupted, received));
+      record[i] ^= (1 << bit);
+    }
+  }
+
+  // A record with another version is rejected, even with a correct CRC
+  record[0] = SFE_SMOL_POWER_DUMP_RECORD_VERSION + 1;
+  record[16] = sfeSmolPowerCRC8(record, SFE_SMOL_POWER_DUMP_RECORD_SIZE - 1);
+  CHECK(!sfeSmolPowerBoard::deserializeRegisterDump(record, sizeof(record), received));
+  record[0] = SFE_SMOL_POWER_DUMP_RECORD_VERSION;
+  record[16] = sfeSmolPowerCRC8(record, SFE_SMOL_POWER_DUMP_RECORD_SIZE - 1);
+  CHECK(sfeSmolPowerBoard::deserializeRegisterDump(record, sizeof(record), received));
+}
+
+static int alertCallbacks = 0;
+static void countAlert()
+{
+  alertCallbacks++;
+}
+
+/** The alert interrupt is shared by every smolPowerLiPo, so only its owner can use or release it */
+static void testAlertInterruptOwner()
+{
+  sfeSmolPowerMockBoard mock;
+  smolPowerLiPo a;
+  smolPowerLiPo b;
+  CHECK(attach(mock, a));
+  CHECK(b.begin(mock.getAddress(), Wire));
+  alertCallbacks = 0;
+
+  CHECK(!a.attachAlertInterrupt(-1)); // Not interrupt-capable
+  CHECK(a.attachAlertInterrupt(20, countAlert));
+  CHECK(!b.attachAlertInterrupt(21));
+  CHECK(!b.attachAlertInterrupt(20));
+  b.detachAlertInterrupt(); // Does not release a's interrupt
+
+  a.getFuelGauge().setStatus(MAX1704X_STATUS_VL);
+  sfeSmolPowerHostSetPin(20, LOW);
+  CHECK(alertCallbacks == 1);
+  CHECK(a.isAlertPending());
+  CHECK(!b.isAlertPending());
+  CHECK(b.serviceAlerts() == 0);
+  sfeSmolPowerHostSetPin(20, HIGH); // The gauge releases ALRT when the alert is cleared
+  CHECK(a.serviceAlerts() == SFE_SMOL_POWER_ALERT_VOLTAGE_LOW);
+  CHECK(!a.isAlertPending());
+
+  // The owner can move to another pin. The old pin is detached
+  CHECK(a.attachAlertInterrupt(21, countAlert));
+  sfeSmolPowerHostSetPin(20, LOW);
+  sfeSmolPowerHostSetPin(20, HIGH);
+  CHECK(alertCallbacks == 1);
+  CHECK(!a.isAlertPending());
+
+  a.detachAlertInterrupt();
+  CHECK(b.attachAlertInterrupt(21));
+  CHECK(!a.attachAlertInterrupt(21));
+  b.detachAlertInterrupt();
+
+  // Destroying the owner releases the interrupt
+  {
+    smolPowerLiPo c;
+    CHECK(c.attachAlertInterrupt(22));
+    CHECK(!a.attachAlertInterrupt(20));
+  }
+  CHECK(a.attachAlertInterrupt(20));
+  a.detachAlertInterrupt();
+}
+
+static int eventsFired = 0;
+static sfe_power_board_event_t lastEvent;
+static byte resetFlagsFired = 0;
+
+static void recordEvent(const sfe_power_board_event_t &event)
+{
+  eventsFired++;
+  lastEvent = event;
+}
+
+static void recordReset(const sfe_power_board_event_t &event)
+{
+  resetFlagsFired |= event.rule;
+}
+
+/** Update one source and service the engine. Returns the number of events fired */
+template <typename Events>
+static byte feed(Events &events, sfe_power_board_event_source_e source, int32_t value)
+{
+  events.update(source, value);
+  return (events.service());
+}
+
+static void testEventHysteresis()
+{
+  sfeSmolPowerEvents<> events;
+  eventsFired = 0;
+  byte low = events.onLowBattery(1200, 100, 1, recordEvent);
+  byte hot = events.onOverTemperature(4000, 500, 1, recordEvent);
+  CHECK(low != SFE_SMOL_POWER_EVENT_NO_RULE);
+  CHECK(hot != SFE_SMOL_POWER_EVENT_NO_RULE);
+
+  CHECK(feed(events, SFE_SMOL_POWER_EVENT_SOURCE_BATTERY, 1250) == 0);
+  CHECK(feed(events, SFE_SMOL_POWER_EVENT_SOURCE_BATTERY, 1200) == 1); // At the threshold
+  CHECK(events.isActive(low));
+  CHECK((lastEvent.rule == low) && lastEvent.active && (lastEvent.value == 1200));
+  CHECK(feed(events, SFE_SMOL_POWER_EVENT_SOURCE_BATTERY, 1150) == 0); // Still active: no repeat
+  CHECK(feed(events, SFE_SMOL_POWER_EVENT_SOURCE_BATTERY, 1300) == 0); // Within the hysteresis
+  CHECK(events.isActive(low));
+  CHECK(feed(events, SFE_SMOL_POWER_EVENT_SOURCE_BATTERY, 1301) == 1);
+  CHECK(!events.isActive(low));
+  CHECK((lastEvent.rule == low) && !lastEvent.active);
+
+  // The other rule only sees its own source
+  CHECK(!events.isActive(hot));
+  CHECK(feed(events, SFE_SMOL_POWER_EVENT_SOURCE_TEMPERATURE, 4000) == 1);
+  CHECK(feed(events, SFE_SMOL_POWER_EVENT_SOURCE_TEMPERATURE, 3600) == 0);
+  CHECK(feed(events, SFE_SMOL_POWER_EVENT_SOURCE_TEMPERATURE, 3499) == 1);
+  CHECK(eventsFired == 4);
+
+  // No new sample, no evaluation
+  CHECK(events.service() == 0);
+}
+
+static void testEventDebounce()
+{
+  sfeSmolPowerEvents<> events;
+  eventsFired = 0;
+  byte low = events.onLowBattery(1200, 0, 3, recordEvent);
+
+  // An interrupted run restarts the count
+  CHECK(feed(events, SFE_SMOL_POWER_EVENT_SOURCE_BATTERY, 1100) == 0);
+  CHECK(feed(events, SFE_SMOL_POWER_EVENT_SOURCE_BATTERY, 1100) == 0);
+  CHECK(feed(events, SFE_SMOL_POWER_EVENT_SOURCE_BATTERY, 1250) == 0);
+  CHECK(feed(events, SFE_SMOL_POWER_EVENT_SOURCE_BATTERY, 1100) == 0);
+  CHECK(feed(events, SFE_SMOL_POWER_EVENT_SOURCE_BATTERY, 1100) == 0);
+  CHECK(!events.isActive(low));
+
+  // service without a new sample does not count
+  CHECK(events.service() == 0);
+  CHECK(!events.isActive(low));
+  CHECK(feed(events, SFE_SMOL_POWER_EVENT_SOURCE_BATTERY, 1100) == 1);
+  CHECK(events.isActive(low));
+
+  // Clearing is debounced too
+  CHECK(feed(events, SFE_SMOL_POWER_EVENT_SOURCE_BATTERY, 1300) == 0);
+  CHECK(feed(events, SFE_SMOL_POWER_EVENT_SOURCE_BATTERY, 1300) == 0);
+  CHECK(feed(events, SFE_SMOL_POWER_EVENT_SOURCE_BATTERY, 1300) == 1);
+  CHECK(!events.isActive(low));
+  CHECK(eventsFired == 2);
+}
+
+static void testEventReset()
+{
+  sfeSmolPowerMockBoard mock;
+  smolPowerAAA board;
+  CHECK(attach(mock, board));
+  mock.setRegister(SFE_SMOL_POWER_REGISTER_RESET_REASON, SFE_SMOL_POWER_RESET_REASON_PORF | SFE_SMOL_POWER_RESET_REASON_WDRF | SFE_SMOL_POWER_RESET_REASON_BORF);
+
+  sfeSmolPowerEvents<> events;
+  events.onReset(recordReset);
+  resetFlagsFired = 0;
+
+  // Each default flag fires once. PORF is not reported by default
+  CHECK(events.sample(board));
+  CHECK(events.service() == 2);
+  CHECK(resetFlagsFired == (SFE_SMOL_POWER_RESET_REASON_WDRF | SFE_SMOL_POWER_RESET_REASON_BORF));
+
+  // One-shot: the reason is not read or reported again
+  // (sample costs the same as getTelemetry)
+  resetFlagsFired = 0;
+  unsigned long transactions = mock.getTransactionCount();
+  CHECK(events.sample(board));
+  unsigned long sampleTransactions = mock.getTransactionCount() - transactions;
+  CHECK(events.service() == 0);
+  CHECK(resetFlagsFired == 0);
+  sfe_power_board_telemetry_t telemetry;
+  transactions = mock.getTransactionCount();
+  CHECK(board.getTelemetry(telemetry));
+  CHECK(sampleTransactions == (mock.getTransactionCount() - transactions));
+
+  // A failed read is ignored, and reported reasons can be chosen
+  events.setResetReason(SFE_SMOL_POWER_COMM_ERROR | SFE_SMOL_POWER_RESET_REASON_WDRF);
+  CHECK(events.service() == 0);
+  events.onReset(recordReset, SFE_SMOL_POWER_RESET_REASON_PORF);
+  events.setResetReason(SFE_SMOL_POWER_RESET_REASON_PORF | SFE_SMOL_POWER_RESET_REASON_WDRF);
+  CHECK(events.service() == 1);
+  CHECK(resetFlagsFired == SFE_SMOL_POWER_RESET_REASON_PORF);
+}
+
+static void testEventFuelGaugeFailure()
+{
+  sfeSmolPowerMockBoard mock;
+  smolPowerLiPo board;
+  CHECK(attach(mock, board));
+  SFE_MAX1704X &gauge = board.getFuelGauge();
+  gauge.setVoltage(3.8);
+  gauge.setSOC(50.0);
+
+  sfeSmolPowerEvents<> events;
+  eventsFired = 0;
+  byte low = events.onLowBattery(3300, 100, 1, recordEvent);
+  byte empty = events.addRule(SFE_SMOL_POWER_EVENT_SOURCE_SOC, SFE_SMOL_POWER_EVENT_BELOW, 500, 100, 1, recordEvent);
+  CHECK(events.sample(board));
+  CHECK(events.service() == 0);
+
+  // A gauge which stops responding reads 0: no false low battery or empty events
+  gauge.setConnected(false);
+  CHECK(!events.sample(board));
+  CHECK(events.service() == 0);
+  CHECK(!events.isActive(low));
+  CHECK(!events.isActive(empty));
+
+  // The gauge stops responding between the battery voltage and state of charge reads
+  gauge.setConnected(true);
+  gauge.disconnectAfterReads(1);
+  CHECK(!events.sample(board));
+  CHECK(events.service() == 0);
+  CHECK(!events.isActive(empty));
+
+  // A real state of charge of 0 is reported
+  gauge.setConnected(true);
+  gauge.setSOC(0.0);
+  CHECK(events.sample(board));
+  CHECK(events.service() == 1);
+  CHECK(events.isActive(empty));
+  CHECK((lastEvent.rule == empty) && (lastEvent.value == 0));
+  CHECK(!events.isActive(low));
+}
+
+/** Check that the history holds exactly samples[first] to samples[last], decoding from the newest */
+template <typename History>
+static void checkHistory(History &history, const sfe_power_board_history_sample_t *samples, int first, int last)
+{
+  CHECK(history.available() == (last - first + 1));
+  typename History::iterator it = history.newest();
+  sfe_power_board_history_sample_t sample;
+  for (int i = last; i >= first; i--)
+  {
+    CHECK(it.next(sample));
+    CHECK((sample.millis == samples[i].millis) && (sample.rawTemperature == samples[i].rawTemperature) && (sample.rawVBAT == samples[i].rawVBAT));
+  }
+  CHECK(!it.next(sample));
+  CHECK(history.getOldest(sample) && (sample.millis == samples[first].millis) && (sample.rawVBAT == samples[first].rawVBAT));
+  CHECK(history.getNewest(sample) && (sample.millis == samples[last].millis) && (sample.rawVBAT == samples[last].rawVBAT));
+}
+
+static void testHistoryWraparound()
+{
+  sfe_power_board_history_sample_t samples[20];
+  sfeSmolPowerHistory<8> history;
+  sfe_power_board_history_stats_t stats;
+  CHECK(!history.getStatistics(SFE_SMOL_POWER_HISTORY_VBAT, 0, stats));
+  for (int i = 0; i < 20; i++)
+  {
+    samples[i].millis = 1000UL * i + (i % 3);
+    samples[i].rawTemperature = 500 + i;
+    samples[i].rawVBAT = 600 - ((i * 7) % 11);
+    history.append(samples[i].millis, samples[i].rawTemperature, samples[i].rawVBAT);
+    checkHistory(history, samples, (i < 8) ? 0 : (i - 7), i);
+  }
+
+  // VBAT over samples 17 to 19 is 591, 595 and 599
+  CHECK(history.getStatistics(SFE_SMOL_POWER_HISTORY_VBAT, 3, stats));
+  CHECK((stats.count == 3) && (stats.minimum == 591) && (stats.maximum == 599) && (stats.mean == 595));
+  uint32_t sum = 0;
+  for (int i = 12; i < 20; i++)
+    sum += samples[i].rawTemperature;
+  CHECK(history.getMean(SFE_SMOL_POWER_HISTORY_TEMPERATURE) == (sum + 4) / 8);
+  CHECK(history.getStatistics(SFE_SMOL_POWER_HISTORY_TEMPERATURE, 0, stats));
+  CHECK((stats.count == 8) && (stats.mean == history.getMean(SFE_SMOL_POWER_HISTORY_TEMPERATURE)));
+
+  history.clear();
+  CHECK(history.available() == 0);
+  CHECK(!history.getNewest(samples[0]));
+}
+
+/** Large jumps and long gaps are escaped (held in three slots) and decode exactly, however the escapes wrap */
+static void testHistoryEscapes()
+{
+  // 700 to 450 is a jump of 250. Samples 120s apart overflow the 16-bit time step at the default 1ms unit
+  static const sfe_power_board_history_sample_t samples[] = {
+    {0, 700, 700}, {120000, 700, 450}, {185000, 701, 449}, {185010, 300, 449}, {0x7FFFFFF0, 301, 1023},
+    {0x80000005, 301, 1022}, {0x80000006, 0, 0}, {0x80000007, 127, 1}, {0x80000008, 127, 1000}, {0x80011170, 128, 1001},
+    {0x80011171, 129, 1002}, {0x80011172, 1, 1002}, {0x80011173, 0, 875}};
+  static const bool escaped[] = {
+    false, true, false, true, true,
+    false, true, false, true, true,
+    false, true, false}; // -128 is the escape code, so a delta of -128 is escaped too
+  const int count = sizeof(samples) / sizeof(samples[0]);
+  sfeSmolPowerHistory<8> history;
+  int oldest = 0;
+  int slots = 0;
+  for (int i = 0; i < count; i++)
+  {
+    history.append(samples[i].millis, samples[i].rawTemperature, samples[i].rawVBAT);
+    slots += ((i > 0) && escaped[i]) ? 3 : 1;
+    for (; slots > 8; oldest++)
+      slots -= ((oldest > 0) && escaped[oldest]) ? 3 : 1;
+    checkHistory(history, samples, oldest, i);
+  }
+  CHECK(oldest == 9);
+
+  // Three slots hold one escaped sample: the samples before it are discarded
+  static const sfe_power_board_history_sample_t small[] = {{0, 100, 100}, {1, 101, 101}, {2, 400, 101}, {3, 401, 102}};
+  sfeSmolPowerHistory<3> smallHistory;
+  smallHistory.append(small[0].millis, small[0].rawTemperature, small[0].rawVBAT);
+  smallHistory.append(small[1].millis, small[1].rawTemperature, small[1].rawVBAT);
+  checkHistory(smallHistory, small, 0, 1);
+  smallHistory.append(small[2].millis, small[2].rawTemperature, small[2].rawVBAT);
+  checkHistory(smallHistory, small, 2, 2);
+  smallHistory.append(small[3].millis, small[3].rawTemperature, small[3].rawVBAT);
+  checkHistory(smallHistory, small, 2, 3);
+
+  // A 1s time unit: the timestamps are rounded to the nearest second, without drift
+  sfeSmolPowerHistory<8, 1000> seconds;
+  seconds.append(400, 1, 1);
+  seconds.append(1900, 1, 1);
+  seconds.append(100000000, 1, 1);
+  sfe_power_board_history_sample_t sample;
+  sfeSmolPowerHistory<8, 1000>::iterator it = seconds.newest();
+  CHECK(it.next(sample) && (sample.millis == 100000400));
+  CHECK(it.next(sample) && (sample.millis == 2400));
+  CHECK(it.next(sample) && (sample.millis == 400));
+}
+
+//-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
+static const test_t tests[] = {
+  {"readSingleByte short reads", testReadSingleByteShortRead},
+  {"getPowerDownDurationWDTInts", testPowerDownDuration},
+  {"CRC rejection", testCRCRejection},
+  {"eeprom update latency", testEEPROMUpdateLatency},
+  {"applyConfig", testApplyConfig},
+  {"ADC conversion time", testADCConversionTime},
+  {"sampleBattery fails if VCC reads 0", testSampleBatteryZeroVCC},
+  {"statistics variance", testStatisticsVariance},
+  {"manager measureAll overlaps the ADC waits", testManagerMeasureAll},
+  {"NACK injection", testNACKInjection},
+  {"split-phase retries and poll", testSplitPhaseRetries},
+  {"burst read fallback", testBurstReadFallback},
+  {"reset reason keeps the shadows", testResetReasonKeepsShadows},
+  {"register dump record", testRegisterDumpRecord},
+  {"LiPo fuel gauge", testLiPoFuelGauge},
+  {"alert interrupt owner", testAlertInterruptOwner},
+  {"event hysteresis", testEventHysteresis},
+  {"event debounce", testEventDebounce},
+  {"reset events", testEventReset},
+  {"events ignore failed fuel gauge reads", testEventFuelGaugeFailure},
+  {"history wraparound and decoding", testHistoryWraparound},
+  {"history escapes", testHistoryEscapes},
+};
+
+int main()
+{
+  return (runTests(tests, sizeof(tests) / sizeof(tests[0])));
+}
@@ -0,0 +1,43 @@
+/*!
+ * @file Arduino.h
+ *
+ * SparkFun smôl Power Board Arduino Library - host test harness
+ *
+ * A minimal stand-in for the Arduino core, so the library can be built with the TwoWire transport on a host.
+ * Only what the library uses is provided. millis is a simulated clock: delay advances it instantly,
+ * so the ADC and eeprom waits cost no real time and every run is deterministic.
+ *
+ * Please see LICENSE.md for the license information
+ *
+ */
+
+#ifndef __SFE_SMOL_POWER_HOST_ARDUINO__
+#define __SFE_SMOL_POWER_HOST_ARDUINO__
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <math.h>
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+unsigned long millis();
+void delay(unsigned long ms);
+void sfeSmolPowerAdvanceClock(unsigned long ms); // Advance the simulated clock, e.g. while the host is "asleep"
+
+// GPIO and interrupts: enough for the MAX17048 ALRT pin
+#define LOW 0
+#define HIGH 1
+#define INPUT 0
+#define INPUT_PULLUP 2
+#define FALLING 2
+
+void pinMode(uint8_t pin, uint8_t mode);
+int digitalRead(uint8_t pin);
+int digitalPinToInterrupt(int pin);
+void attachInterrupt(uint8_t interrupt, void (*isr)(void), int mode);
+void detachInterrupt(uint8_t interrupt);
+void sfeSmolPowerHostSetPin(uint8_t pin, int level); // Drive an input pin. A falling edge calls the attached ISR
+
+#endif // /__SFE_SMOL_POWER_HOST_ARDUINO__
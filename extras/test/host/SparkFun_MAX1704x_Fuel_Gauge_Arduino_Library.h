@@ -0,0 +1,120 @@
+/*!
+ * @file SparkFun_MAX1704x_Fuel_Gauge_Arduino_Library.h
+ *
+ * SparkFun smôl Power Board Arduino Library - host test harness
+ *
+ * A stub of the SparkFun MAX1704x library, simulating the MAX17048 fuel gauge used by smolPowerLiPo.
+ * The voltage, state of charge, change rate and STATUS register are set by the test.
+ * setConnected(false) simulates a gauge which does not respond: like the real library, reads return 0
+ * and writes return a non-zero status. disconnectAfterReads simulates a gauge which stops responding part-way through.
+ *
+ * Please see LICENSE.md for the license information
+ *
+ */
+
+#ifndef __SFE_SMOL_POWER_HOST_MAX1704X__
+#define __SFE_SMOL_POWER_HOST_MAX1704X__
+
+#include "Arduino.h"
+#include "Wire.h"
+
+typedef enum
+{
+  MAX1704X_MAX17043 = 0,
+  MAX1704X_MAX17044,
+  MAX1704X_MAX17048,
+  MAX1704X_MAX17049
+} sfe_max1704x_devices_e;
+
+#define MAX1704X_STATUS_RI   (1 << 0)
+#define MAX1704X_STATUS_VH   (1 << 1)
+#define MAX1704X_STATUS_VL   (1 << 2)
+#define MAX1704X_STATUS_VR   (1 << 3)
+#define MAX1704X_STATUS_HD   (1 << 4)
+#define MAX1704X_STATUS_SC   (1 << 5)
+
+class SFE_MAX1704X
+{
+public:
+  SFE_MAX1704X(sfe_max1704x_devices_e device = MAX1704X_MAX17043) { (void)device; }
+
+  bool begin(TwoWire &wirePort = Wire) { (void)wirePort; return (_connected); }
+  bool isConnected(void) { return (_connected); }
+
+  float getVoltage() { return (read() ? _voltage : 0.0); }
+  float getSOC() { return (read() ? _soc : 0.0); }
+  float getChangeRate() { return (read() ? _changeRate : 0.0); }
+
+  uint8_t getThreshold() { return (_connected ? _threshold : 0); }
+  uint8_t setThreshold(uint8_t percent = 4) { return (write(_threshold, percent)); }
+
+  uint8_t setVALRTMax(uint8_t threshold = 0xFF) { return (write(_valrtMax, threshold)); }
+  uint8_t setVALRTMin(uint8_t threshold = 0x00) { return (write(_valrtMin, threshold)); }
+  uint8_t enableSOCAlert() { return (write(_socAlert, true)); }
+  uint8_t disableSOCAlert() { return (write(_socAlert, false)); }
+
+  uint8_t getStatus() { return (_connected ? _status : 0); }
+  bool isReset(bool clear = false) { return (checkStatus(MAX1704X_STATUS_RI, clear)); }
+  bool isVoltageHigh(bool clear = false) { return (checkStatus(MAX1704X_STATUS_VH, clear)); }
+  bool isVoltageLow(bool clear = false) { return (checkStatus(MAX1704X_STATUS_VL, clear)); }
+  bool isLow(bool clear = false) { return (checkStatus(MAX1704X_STATUS_HD, clear)); }
+  bool isChange(bool clear = false) { return (checkStatus(MAX1704X_STATUS_SC, clear)); }
+  uint8_t clearAlert() { return (_connected ? 0 : 2); }
+
+  uint8_t sleep() { return (write(_sleeping, true)); }
+  uint8_t wake() { return (write(_sleeping, false)); }
+
+  // The simulation
+  void setConnected(bool connected) { _connected = connected; _readsBeforeDisconnect = -1; }
+  void disconnectAfterReads(int reads) { _readsBeforeDisconnect = reads; } // Stop responding after this many more reads
+  void setVoltage(float volts) { _voltage = volts; }
+  void setSOC(float percent) { _soc = percent; }
+  void setChangeRate(float percentPerHour) { _changeRate = percentPerHour; }
+  void setStatus(uint8_t status) { _status = status; }
+  bool isSleeping() { return (_sleeping); }
+  uint8_t getVALRTMax() { return (_valrtMax); }
+  uint8_t getVALRTMin() { return (_valrtMin); }
+
+private:
+  bool read()
+  {
+    if (_readsBeforeDisconnect == 0)
+      _connected = false;
+    else if (_readsBeforeDisconnect > 0)
+      _readsBeforeDisconnect--;
+    return (_connected);
+  }
+
+  template <typename T>
+  uint8_t write(T &field, T value)
+  {
+    if (!_connected)
+      return (2); // Address NACK
+    field = value;
+    return (0);
+  }
+
+  bool checkStatus(uint8_t bit, bool clear)
+  {
+    if (!_connected)
+      return (false);
+    bool set = (_status & bit) != 0;
+    if (set && clear)
+      _status &= ~bit;
+    return (set);
+  }
+
+  bool _connected = true;
+  float _voltage = 3.7;
+  float _soc = 50.0;
+  float _changeRate = 0.0;
+  uint8_t _status = 0;
+  uint8_t _threshold = 4;
+  uint8_t _valrtMax = 0xFF;
+  uint8_t _valrtMin = 0x00;
+  bool _socAlert = false;
+  bool _sleeping = false;
+  int _readsBeforeDisconnect = -1;
+};
+
+#endif // /__SFE_SMOL_POWER_HOST_MAX1704X__
@@ -0,0 +1,170 @@
+/*!
+ * @file SparkFun_smol_Power_Board_Host.cpp
+ *
+ * SparkFun smôl Power Board Arduino Library - host test harness
+ *
+ * The simulated clock, GPIO and TwoWire bus used by the host tests.
+ *
+ * Please see LICENSE.md for the license information
+ *
+ */
+
+#include "SparkFun_smol_Power_Board.h"
+
+#ifndef SFE_SMOL_POWER_MOCK_BOARD
+#error "Please define SFE_SMOL_POWER_MOCK_BOARD: the host TwoWire routes transactions to sfeSmolPowerMockBoard"
+#endif
+
+//-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
+static unsigned long hostMillis = 0;
+
+unsigned long millis()
+{
+  return (hostMillis);
+}
+
+void delay(unsigned long ms)
+{
+  hostMillis += ms;
+}
+
+void sfeSmolPowerAdvanceClock(unsigned long ms)
+{
+  hostMillis += ms;
+}
+
+//-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
+#define HOST_PINS 64
+
+static int hostPinLevel[HOST_PINS];
+static bool hostPinLevelSet[HOST_PINS];
+static void (*hostISR[HOST_PINS])(void);
+
+void pinMode(uint8_t pin, uint8_t mode)
+{
+  if ((pin < HOST_PINS) && (mode == INPUT_PULLUP) && !hostPinLevelSet[pin])
+    hostPinLevel[pin] = HIGH;
+}
+
+int digitalRead(uint8_t pin)
+{
+  if (pin >= HOST_PINS)
+    return (LOW);
+  return (hostPinLevelSet[pin] ? hostPinLevel[pin] : HIGH);
+}
+
+int digitalPinToInterrupt(int pin)
+{
+  return (((pin >= 0) && (pin < HOST_PINS)) ? pin : -1);
+}
+
+void attachInterrupt(uint8_t interrupt, void (*isr)(void), int mode)
+{
+  (void)mode; // Only FALLING is used
+  if (interrupt < HOST_PINS)
+    hostISR[interrupt] = isr;
+}
+
+void detachInterrupt(uint8_t interrupt)
+{
+  if (interrupt < HOST_PINS)
+    hostISR[interrupt] = nullptr;
+}
+
+void sfeSmolPowerHostSetPin(uint8_t pin, int level)
+{
+  if (pin >= HOST_PINS)
+    return;
+  int previous = digitalRead(pin);
+  hostPinLevel[pin] = level;
+  hostPinLevelSet[pin] = true;
+  if ((previous == HIGH) && (level == LOW) && (hostISR[pin] != nullptr))
+    hostISR[pin]();
+}
+
+//-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
+TwoWire Wire;
+
+void TwoWire::beginTransmission(uint8_t address)
+{
+  _txAddress = address;
+  _txLength = 0;
+}
+
+size_t TwoWire::write(uint8_t data)
+{
+  if (_txLength >= sizeof(_txBuffer))
+    return (0);
+  _txBuffer[_txLength++] = data;
+  return (1);
+}
+
+/** Like the Arduino TwoWire: 0 on success, 2 if the address is not acknowledged */
+uint8_t TwoWire::endTransmission(bool sendStop)
+{
+  (void)sendStop;
+  sfeSmolPowerMockBoard *device = find(_txAddress);
+  if (device == nullptr)
+    return (2);
+  if (_txLength == 0)
+    return (device->probe(_txAddress));
+  return (device->write(_txAddress, _txBuffer[0], &_txBuffer[1], _txLength - 1));
+}
+
+/** Returns the number of bytes received. The simulated board returns fewer than requested while it is busy */
+uint8_t TwoWire::requestFrom(uint8_t address, uint8_t quantity)
+{
+  _rxLength = 0;
+  _rxIndex = 0;
+  sfeSmolPowerMockBoard *device = find(address);
+  if (device == nullptr)
+    return (0);
+  if (quantity > sizeof(_rxBuffer))
+    quantity = sizeof(_rxBuffer);
+  _rxLength = device->read(address, _rxBuffer, quantity);
+  return (_rxLength);
+}
+
+int TwoWire::available()
+{
+  return (_rxLength - _rxIndex);
+}
+
+int TwoWire::read()
+{
+  if (_rxIndex >= _rxLength)
+    return (-1);
+  return (_rxBuffer[_rxIndex++]);
+}
+
+bool TwoWire::attach(sfeSmolPowerMockBoard &board)
+{
+  for (byte i = 0; i < SFE_SMOL_POWER_HOST_WIRE_DEVICES; i++)
+  {
+    if ((_devices[i] == nullptr) || (_devices[i] == &board))
+    {
+      _devices[i] = &board;
+      return (true);
+    }
+  }
+  return (false);
+}
+
+void TwoWire::detachAll()
+{
+  for (byte i = 0; i < SFE_SMOL_POWER_HOST_WIRE_DEVICES; i++)
+    _devices[i] = nullptr;
+}
+
+sfeSmolPowerMockBoard *TwoWire::find(uint8_t address)
+{
+  for (byte i = 0; i < SFE_SMOL_POWER_HOST_WIRE_DEVICES; i++)
+  {
+    if ((_devices[i] != nullptr) && (_devices[i]->getAddress() == address))
+      return (_devices[i]);
+  }
+  return (nullptr);
+}
@@ -0,0 +1,53 @@
+/*!
+ * @file Wire.h
+ *
+ * SparkFun smôl Power Board Arduino Library - host test harness
+ *
+ * A TwoWire stand-in. Transactions are routed to the simulated ATtiny43U boards (sfeSmolPowerMockBoard)
+ * attached to the bus, so the library's TwoWire transport is exercised unchanged.
+ * Build with SFE_SMOL_POWER_MOCK_BOARD defined, so the library includes the simulated board.
+ *
+ * Please see LICENSE.md for the license information
+ *
+ */
+
+#ifndef __SFE_SMOL_POWER_HOST_WIRE__
+#define __SFE_SMOL_POWER_HOST_WIRE__
+
+#include "Arduino.h"
+
+#define SFE_SMOL_POWER_HOST_WIRE_DEVICES 4 ///< The number of simulated boards which can be attached to one bus
+
+class sfeSmolPowerMockBoard;
+
+class TwoWire
+{
+public:
+  void begin() {}
+
+  void beginTransmission(uint8_t address);
+  size_t write(uint8_t data);
+  uint8_t endTransmission(bool sendStop = true);
+  uint8_t requestFrom(uint8_t address, uint8_t quantity);
+  int available();
+  int read();
+
+  // The simulation
+  bool attach(sfeSmolPowerMockBoard &board); // Put a simulated board on the bus. Returns false if the bus is full
+  void detachAll();
+
+private:
+  sfeSmolPowerMockBoard *find(uint8_t address);
+
+  sfeSmolPowerMockBoard *_devices[SFE_SMOL_POWER_HOST_WIRE_DEVICES] = {};
+  uint8_t _txAddress = 0;
+  uint8_t _txBuffer[32];
+  uint8_t _txLength = 0;
+  uint8_t _rxBuffer[32];
+  uint8_t _rxLength = 0;
+  uint8_t _rxIndex = 0;
+};
+
+extern TwoWire Wire;
+
+#endif // /__SFE_SMOL_POWER_HOST_WIRE__
@@ -26,6 +26,11 @@
  */
 
 #include "SparkFun_smol_Power_Board.h"
+#include "SparkFun_smol_Power_Board_Filters.h"
+
+#ifndef IRAM_ATTR
+#define IRAM_ATTR // Only needed on ESP32, to keep the ALRT interrupt service routine in IRAM
+#endif
 
 /**************************************************************************/
 /*!
@@ -34,21 +39,75 @@
             The I2C address of the Power Board.
             Default is SFE_POWER_BOARD_DEFAULT_I2C_ADDRESS 0x50.
             Can be changed with setI2CAddress.
-    @param  wirePort
-            The TwoWire (I2C) port used to communicate with the Power Board.
-            Default is Wire.
+    @param  port
+            The port used to communicate with the Power Board: the TwoWire (I2C) port
+            (default is Wire), the mock board, or the Linux I2C bus, depending on the transport.
     @return True if communication with the Power Board was successful, otherwise false.
 */
 /**************************************************************************/
-bool smolPowerAAA::begin(byte deviceAddress, TwoWire &wirePort)
+bool smolPowerAAA::begin(byte deviceAddress, sfe_power_board_port_t &port)
+{
+  SFE_SMOL_POWER_API_SCOPE(SFE_SMOL_POWER_API_BEGIN);
+  _resetReason = SFE_SMOL_POWER_COMM_ERROR; // Unknown: the first getResetReason invalidates the shadow copies
+  return (smolPowerBoard_io.begin(deviceAddress, port));
+}
+
+/**************************************************************************/
+/*!
+    @brief  Resume communication with the SparkFun smôl Power Board after the host wakes from power-down.
+            Use instead of begin. The identity and configuration are restored from state
+            (see saveResumeState) and the board is checked by reading its address and reset reason.
+    @param  state
+            The state saved by saveResumeState before powering down.
+    @param  port
+            The port used to communicate with the Power Board: the TwoWire (I2C) port
+            (default is Wire), the mock board, or the Linux I2C bus, depending on the transport.
+    @param  resetReason
+            Optional pointer for the reset reason, as returned by getResetReason.
+    @return True if the board responded and the state was restored. False if state is invalid
+            or communication failed: call begin instead.
+*/
+/**************************************************************************/
+bool smolPowerAAA::resume(const sfe_power_board_resume_t &state, sfe_power_board_port_t &port, byte *resetReason)
 {
-  return (smolPowerBoard_io.begin(deviceAddress, wirePort));
+  SFE_SMOL_POWER_API_SCOPE(SFE_SMOL_POWER_API_RESUME);
+  smolPowerBoard_io.setPort(port);
+  return (resumeBoard(state, resetReason));
 }
+#ifdef SFE_SMOL_POWER_TRANSPORT_TWOWIRE
 bool smolPowerLiPo::begin(byte deviceAddress, TwoWire &wirePort)
 {
+  SFE_SMOL_POWER_API_SCOPE(SFE_SMOL_POWER_API_BEGIN);
+  sfeSmolPowerBusLockScope busLockScope(&smolPowerBoard_io); // The fuel gauge shares the bus
+  _resetReason = SFE_SMOL_POWER_COMM_ERROR; // Unknown: the first getResetReason invalidates the shadow copies
   return (smolPowerBoard_io.begin(deviceAddress, wirePort) && powerBoardFuelGauge.begin(wirePort));
 }
 
+/**************************************************************************/
+/*!
+    @brief  Resume communication with the SparkFun smôl Power Board after the host wakes from power-down.
+            Use instead of begin. The identity and configuration are restored from state
+            (see saveResumeState) and the board is checked by reading its address and reset reason.
+            The MAX17048 fuel gauge is begun as usual.
+    @param  state
+            The state saved by saveResumeState before powering down.
+    @param  wirePort
+            The TwoWire (I2C) port used to communicate with the Power Board.
+    @param  resetReason
+            Optional pointer for the reset reason, as returned by getResetReason.
+    @return True if the board responded and the state was restored. False if state is invalid
+            or communication failed: call begin instead.
+*/
+/**************************************************************************/
+bool smolPowerLiPo::resume(const sfe_power_board_resume_t &state, TwoWire &wirePort, byte *resetReason)
+{
+  SFE_SMOL_POWER_API_SCOPE(SFE_SMOL_POWER_API_RESUME);
+  sfeSmolPowerBusLockScope busLockScope(&smolPowerBoard_io);
+  smolPowerBoard_io.setPort(wirePort);
+  return (resumeBoard(state, resetReason) && powerBoardFuelGauge.begin(wirePort));
+}
+#endif
+
 /**************************************************************************/
 /*!
     @brief  Check that the SparkFun smôl Power Board AAA is awake and communicating.
@@ -58,6 +117,7 @@ bool smolPowerLiPo::begin(byte deviceAddress, TwoWire &wirePort)
 /**************************************************************************/
 bool sfeSmolPowerBoard::isConnected()
 {
+  SFE_SMOL_POWER_API_SCOPE(SFE_SMOL_POWER_API_IS_CONNECTED);
   return (smolPowerBoard_io.isConnected());
 }
 
@@ -73,14 +133,18 @@ bool sfeSmolPowerBoard::isConnected()
 /**************************************************************************/
 bool sfeSmolPowerBoard::setI2CAddress(byte address)
 {
+  SFE_SMOL_POWER_API_SCOPE(SFE_SMOL_POWER_API_SET_I2C_ADDRESS);
   /** To change the address, we need to write two bytes to SFE_POWER_BOARD_REGISTER_I2C_ADDRESS.
-      The first is the new address. The second is a one byte CRC of the address. */
-  byte bytesToSend[2];
-  bytesToSend[0] = address;
-  bytesToSend[1] = computeCRC8(bytesToSend, 1);
-  bool result = smolPowerBoard_io.writeMultipleBytes(SFE_SMOL_POWER_REGISTER_I2C_ADDRESS, bytesToSend, 2);
+      The first is the new address. The second is a one byte CRC of the address.
+      writeRegister adds the CRC and waits for the eeprom to be updated. */
+  bool result = writeRegister<sfe_power_board_reg_i2c_address_t>(address);
   if (result)
-    delay(SFE_SMOL_POWER_EEPROM_UPDATE_DELAY); // Wait for the eeprom to be updated
+  {
+    _shadowI2CAddress = address;
+    _shadowValid |= SFE_SMOL_POWER_SHADOW_I2C_ADDRESS;
+  }
+  else
+    _shadowValid &= ~SFE_SMOL_POWER_SHADOW_I2C_ADDRESS;
   return (result);
 }
 
@@ -94,10 +158,16 @@ bool sfeSmolPowerBoard::setI2CAddress(byte address)
 /**************************************************************************/
 byte sfeSmolPowerBoard::getI2CAddress()
 {
+  SFE_SMOL_POWER_API_SCOPE(SFE_SMOL_POWER_API_GET_I2C_ADDRESS);
   byte address;
-  bool result = smolPowerBoard_io.readSingleByte(SFE_SMOL_POWER_REGISTER_I2C_ADDRESS, &address);
+  bool result = readRegister<sfe_power_board_reg_i2c_address_t>(&address);
   if (!result)
     address = 0;
+  else
+  {
+    _shadowI2CAddress = address;
+    _shadowValid |= SFE_SMOL_POWER_SHADOW_I2C_ADDRESS;
+  }
   return (address);
 }
 
@@ -115,299 +185,2213 @@ byte sfeSmolPowerBoard::getI2CAddress()
 /**************************************************************************/
 byte sfeSmolPowerBoard::getResetReason()
 {
+  SFE_SMOL_POWER_API_SCOPE(SFE_SMOL_POWER_API_GET_RESET_REASON);
   /** The reset reason is updated as soon as the ATtiny43U starts.
       The four MCU STatus Register Flags are read.
       If the ATtiny43U found that its eeprom was corrupt when the code started,
       SFE_SMOL_POWER_EEPROM_CORRUPT_ON_RESET will be set indicating that the eeprom
-      settings have been reset to the default values. */
-  byte reason;
-  bool result = smolPowerBoard_io.readSingleByte(SFE_SMOL_POWER_REGISTER_RESET_REASON, &reason);
+      settings have been reset to the default values.
+      If the ATtiny43U has been reset, the shadow copies of its registers can no longer be trusted. */
+  byte reason = 0;
+  bool result = readRegister<sfe_power_board_reg_reset_reason_t>(&reason);
   if (!result)
     reason |= SFE_SMOL_POWER_COMM_ERROR;
+  else
+    updateResetReason(reason);
   return (reason);
 }
 
+/**************************************************************************/
+/*!
+    @brief  Record a reset reason read from the ATtiny43U.
+            The reset flags are latched, so they are set after every normal boot. The shadow copies
+            are only invalidated if the reason has changed since it was last read, or if this is
+            the first read since begin.
+    @param  reason
+            The reset reason.
+*/
+/**************************************************************************/
+void sfeSmolPowerBoard::updateResetReason(byte reason)
+{
+  if ((reason != _resetReason) && (reason & SFE_SMOL_POWER_RESET_REASON_INVALIDATES_SHADOW))
+    invalidateCache();
+  _resetReason = reason;
+}
+
+#ifndef SFE_SMOL_POWER_DISABLE_FLOAT
 /**************************************************************************/
 /*!
     @brief  Read the ATtiny's internal temperature.
             <br>TO DO: Add temperature calibration / correction functionality.
+            <br>This function blocks while the ATtiny43U performs the ADC conversion.
+            Use startTemperature, poll and collect to avoid blocking.
     @return The temperature in Degrees Centigrade / Celcius or -273.15 if an error occured.
 */
 /**************************************************************************/
 float sfeSmolPowerBoard::getTemperature()
 {
+  SFE_SMOL_POWER_API_SCOPE(SFE_SMOL_POWER_API_GET_TEMPERATURE);
+  startTemperature();
+  waitForMeasurement();
+  return (collect());
+}
+#endif
+
+/**************************************************************************/
+/*!
+    @brief  Read the ATtiny's internal temperature using integer arithmetic only.
+            <br>This function blocks while the ATtiny43U performs the ADC conversion.
+            Use startTemperature, poll and collectFixedPoint to avoid blocking.
+    @return The temperature in hundredths of a Degree C (centi-°C)
+            or SFE_SMOL_POWER_TEMPERATURE_CENTI_C_ERROR (-27315) if an error occured.
+*/
+/**************************************************************************/
+int32_t sfeSmolPowerBoard::getTemperatureCentiC()
+{
+  SFE_SMOL_POWER_API_SCOPE(SFE_SMOL_POWER_API_GET_TEMPERATURE);
+  startTemperature();
+  waitForMeasurement();
+  return (collectFixedPoint());
+}
+
+/**************************************************************************/
+/*!
+    @brief  Start a split-phase (non-blocking) temperature measurement.
+            Any measurement already in progress is abandoned.
+            Call poll until it returns true, then call collect to read the temperature.
+    @return True if the measurement was started successfully, otherwise false.
+*/
+/**************************************************************************/
+bool sfeSmolPowerBoard::startTemperature()
+{
+  SFE_SMOL_POWER_API_SCOPE(SFE_SMOL_POWER_API_START_MEASUREMENT);
   /** To read the approximate temperature, we need to read two bytes (uint16_t, little endian)
       from SFE_SMOL_POWER_REGISTER_TEMPERATURE. These will be the raw ADC reading which we
       need to convert to Degrees C. The ATtiny43U will use the 1.1V
       internal reference for the conversion. There is no need to select it here.
-      The sensitivity is approximately 1 LSB/°C with 25°C reading as 300 ADU. */
-  byte theBytes[2];
-  float result = -273.15; // Return -273.15 if readMultipleBytes fails
-  if (smolPowerBoard_io.readMultipleBytes(SFE_SMOL_POWER_REGISTER_TEMPERATURE, theBytes, 2, SFE_SMOL_POWER_ADC_READ_DELAY))
-  {
-    uint16_t rawTemp = (((uint16_t)theBytes[1]) << 8) | theBytes[0]; // Little endian
-    result = 25.0 + ((float)rawTemp) - 300.0; // Convert to °C
-  }
-  return (result);
+      The conversion is done by collect. */
+  _measurement = SFE_SMOL_POWER_MEASUREMENT_TEMPERATURE;
+  if (smolPowerBoard_io.startRead(sfe_power_board_reg_temperature_t::address, sfe_power_board_reg_temperature_t::readDelay))
+    _measurementState = SFE_SMOL_POWER_MEASUREMENT_WAITING;
+  else
+    _measurementState = SFE_SMOL_POWER_MEASUREMENT_FAILED;
+  return (_measurementState == SFE_SMOL_POWER_MEASUREMENT_WAITING);
 }
 
+#ifndef SFE_SMOL_POWER_DISABLE_FLOAT
 /**************************************************************************/
 /*!
     @brief  Read the ATtiny43U's battery voltage (VBAT).
+            <br>This function blocks while the ATtiny43U performs the ADC conversion(s).
+            Use startBatteryVoltage, poll and collect to avoid blocking.
     @return The battery voltage in Volts or -99.0 if an error occurred.
 */
 /**************************************************************************/
 float smolPowerAAA::getBatteryVoltage()
 {
-  /** This function reads two bytes (uint16_t, little endian) from SFE_SMOL_POWER_REGISTER_VBAT.
+  SFE_SMOL_POWER_API_SCOPE(SFE_SMOL_POWER_API_GET_BATTERY_VOLTAGE);
+  startBatteryVoltage();
+  waitForMeasurement();
+  return (collect());
+}
+#endif
+
+/**************************************************************************/
+/*!
+    @brief  Read the ATtiny43U's battery voltage (VBAT) using integer arithmetic only.
+            <br>This function blocks while the ATtiny43U performs the ADC conversion(s).
+            Use startBatteryVoltage, poll and collectFixedPoint to avoid blocking.
+    @return The battery voltage in mV or 0 if an error occurred.
+*/
+/**************************************************************************/
+uint16_t smolPowerAAA::getBatteryMillivolts()
+{
+  SFE_SMOL_POWER_API_SCOPE(SFE_SMOL_POWER_API_GET_BATTERY_VOLTAGE);
+  startBatteryVoltage();
+  waitForMeasurement();
+  return ((uint16_t)collectFixedPoint());
+}
+
+/**************************************************************************/
+/*!
+    @brief  Start a split-phase (non-blocking) battery voltage (VBAT) measurement.
+            Any measurement already in progress is abandoned.
+            Call poll until it returns true, then call collect to read the voltage.
+    @return True if the measurement was started successfully, otherwise false.
+*/
+/**************************************************************************/
+bool smolPowerAAA::startBatteryVoltage()
+{
+  SFE_SMOL_POWER_API_SCOPE(SFE_SMOL_POWER_API_START_MEASUREMENT);
+  /** We need to read two bytes (uint16_t, little endian) from SFE_SMOL_POWER_REGISTER_VBAT.
       This will be the raw 10-bit ADC reading. We need to manually convert this to
       voltage using the selected voltage reference. The ADC has a built-in divide-by-2
-      circuit, so we can measure up to 2*VCC or 2.2V depending on the reference. */
-  float result = -99.0; // Return -99.0V if something bad happened.
-  sfe_power_board_ADC_ref_e ref = getADCVoltageReference(); // Read which voltage reference is being used
-  if (ref == SFE_SMOL_POWER_USE_ADC_REF_UNDEFINED)
-    return (result); // Return now if getBatteryVoltageReference failed
-  byte theBytes[2];
-  if (smolPowerBoard_io.readMultipleBytes(SFE_SMOL_POWER_REGISTER_VBAT, theBytes, 2, SFE_SMOL_POWER_ADC_READ_DELAY))
-  {
-    uint16_t rawVolts = (((uint16_t)theBytes[1]) << 8) | theBytes[0]; // Little endian
-    result = ((float)rawVolts) / 1023.0; // Convert 10-bit ADC result to the fraction of full range
-    if (ref == SFE_SMOL_POWER_USE_ADC_REF_VCC) // Are we using VCC as the reference?
-    {
-      float vcc = measureVCC(); // We need to measure VCC so we can scale the ADC reading correctly
-      if (vcc > 0.0)
-      {
-        result = result * 2.0 * vcc; // Scale rawVolts to VCC
-      }
-      else
-        return (-99.0); // measureVCC failed so return an error
-    }
-    else // We must be using the 1.1V reference
-    {
-      result = result * 2.0 * 1.1; // Scale rawVolts to 1.1V
-    }
-  }
-  return (result);
+      circuit, so we can measure up to 2*VCC or 2.2V depending on the reference.
+      If the reference is VCC, poll will also measure VCC so the reading can be scaled correctly. */
+  _measurement = SFE_SMOL_POWER_MEASUREMENT_BATTERY;
+  _measurementState = SFE_SMOL_POWER_MEASUREMENT_FAILED;
+  _measurementReference = getCachedADCVoltageReference(); // Find out which voltage reference is being used
+  if (_measurementReference == SFE_SMOL_POWER_USE_ADC_REF_UNDEFINED)
+    return (false); // Return now if getCachedADCVoltageReference failed
+  if (smolPowerBoard_io.startRead(sfe_power_board_reg_vbat_t::address, sfe_power_board_reg_vbat_t::readDelay))
+    _measurementState = SFE_SMOL_POWER_MEASUREMENT_WAITING;
+  return (_measurementState == SFE_SMOL_POWER_MEASUREMENT_WAITING);
 }
+
+#ifdef SFE_SMOL_POWER_TRANSPORT_TWOWIRE // The MAX1704x library needs TwoWire
+#ifndef SFE_SMOL_POWER_DISABLE_FLOAT
 float smolPowerLiPo::getBatteryVoltage()
 {
+  sfeSmolPowerBusLockScope busLockScope(&smolPowerBoard_io);
   /** This function reads the battery voltage from the MAX_17048 fuel gauge. */
   return (powerBoardFuelGauge.getVoltage());
 }
+#endif
 
 /**************************************************************************/
 /*!
-    @brief  Measure the ATtiny43U's VCC by reading the 1.1V internal reference via the ADC.
-    @return The battery voltage in Volts or -99.0 if an error occurred.
+    @brief  Read the battery voltage from the MAX_17048 fuel gauge in mV.
+            Note: the MAX1704x library converts the reading using float internally.
+    @return The battery voltage in mV, or 0 if the fuel gauge could not be read.
 */
 /**************************************************************************/
-float sfeSmolPowerBoard::measureVCC()
+uint16_t smolPowerLiPo::getBatteryMillivolts()
 {
-  /** By reading the 1.1V internal reference we can work out what VCC is.
-      We need to read two bytes (uint16_t, little endian) from SFE_SMOL_POWER_REGISTER_VBAT.
-      This will be the raw 10-bit ADC reading. We need to manually convert this to
-      voltage. The ATtiny43U will automatically select VCC as the reference. There is
-      no need to select it here. */
-  float result = -99.0; // Return -99.0V if something bad happened.
-  byte theBytes[2];
-  if (smolPowerBoard_io.readMultipleBytes(SFE_SMOL_POWER_REGISTER_1V1, theBytes, 2, SFE_SMOL_POWER_ADC_READ_DELAY))
+  sfeSmolPowerBusLockScope busLockScope(&smolPowerBoard_io);
+  return ((uint16_t)((powerBoardFuelGauge.getVoltage() * 1000.0) + 0.5));
+}
+
+/**************************************************************************/
+/*!
+    @brief  Read the battery voltage from the MAX_17048 fuel gauge using the split-phase API.
+            The fuel gauge does not need a conversion delay, so the result is ready immediately.
+            This allows the same code to be used for the AAA and LiPo boards.
+    @return True if the result is ready to collect. False if the fuel gauge could not be read:
+            the measurement state is SFE_SMOL_POWER_MEASUREMENT_FAILED.
+*/
+/**************************************************************************/
+bool smolPowerLiPo::startBatteryVoltage()
+{
+  SFE_SMOL_POWER_API_SCOPE(SFE_SMOL_POWER_API_START_MEASUREMENT);
+  _measurement = SFE_SMOL_POWER_MEASUREMENT_FUEL_GAUGE;
+  _rawResult = getBatteryMillivolts(); // The fuel gauge result is held in mV
+  if (_rawResult == 0) // The MAX1704x library returns 0V if the read fails
   {
-    uint16_t rawVolts = (((uint16_t)theBytes[1]) << 8) | theBytes[0]; // Little endian
-    float fractionFullRange = ((float)rawVolts) / 1023.0; // Convert 10-bit ADC result to the fraction of full range
-    // We know that the ADC has measured the 1.1V internal reference using VCC as the full range.
-    // Therefore we can calculate VCC from fractionFullRange.
-    // fractionFullRange = 1.1V / VCC
-    // VCC = 1.1 / fractionFullRange
-    result = 1.1 / fractionFullRange;
+    smolPowerBoard_io.setLastError(SFE_SMOL_POWER_ERROR_SHORT_READ);
+    _measurementState = SFE_SMOL_POWER_MEASUREMENT_FAILED;
+    return (false);
   }
-  return (result);
+  _measurementState = SFE_SMOL_POWER_MEASUREMENT_COMPLETE;
+  return (true);
 }
 
+#ifndef SFE_SMOL_POWER_DISABLE_FLOAT
 /**************************************************************************/
 /*!
-    @brief  Set the ATtiny43U's ADC voltage reference to VCC or the internal 1.1V reference.
-    @param  ref
-            The reference: SFE_SMOL_POWER_USE_ADC_REF_VCC or SFE_SMOL_POWER_USE_ADC_REF_1V1
-    @return True if the reference is set successfuly, false if not.
+    @brief  Read the state of charge from the MAX_17048 fuel gauge.
+    @return The state of charge in %.
 */
 /**************************************************************************/
-bool sfeSmolPowerBoard::setADCVoltageReference(sfe_power_board_ADC_ref_e ref)
+float smolPowerLiPo::getSOC()
 {
-  /** To change the voltage reference, we need to write two bytes to SFE_SMOL_POWER_REGISTER_ADC_REFERENCE
-      The first is the new address. The second is a one byte CRC of the address. */
-  byte bytesToSend[2];
-  bytesToSend[0] = (byte)ref;
-  bytesToSend[1] = computeCRC8(bytesToSend, 1);
-  smolPowerBoard_io.writeMultipleBytes(SFE_SMOL_POWER_REGISTER_ADC_REFERENCE, bytesToSend, 2);
-  return (getADCVoltageReference() == ref); //Check the reference was modified correctly by reading it back again
+  sfeSmolPowerBusLockScope busLockScope(&smolPowerBoard_io);
+  return (powerBoardFuelGauge.getSOC());
 }
 
 /**************************************************************************/
 /*!
-    @brief  Get the ATtiny43U's ADC voltage reference: VCC or the internal 1.1V reference.
-    @return SFE_SMOL_POWER_USE_ADC_REF_VCC or SFE_SMOL_POWER_USE_ADC_REF_1V1 if the reference was read successfuly,
-            SFE_SMOL_POWER_USE_ADC_REF_UNDEFINED if not.
+    @brief  Read the rate of change of the state of charge from the MAX_17048 fuel gauge.
+    @return The change rate in %/hr. Positive while charging, negative while discharging.
 */
 /**************************************************************************/
-sfe_power_board_ADC_ref_e sfeSmolPowerBoard::getADCVoltageReference()
+float smolPowerLiPo::getChangeRate()
 {
-  byte buffer;
-  bool result = smolPowerBoard_io.readSingleByte(SFE_SMOL_POWER_REGISTER_ADC_REFERENCE, &buffer);
-  if (!result)
-    return (SFE_SMOL_POWER_USE_ADC_REF_UNDEFINED);
-  if ((sfe_power_board_ADC_ref_e)buffer == SFE_SMOL_POWER_USE_ADC_REF_VCC)
-    return (SFE_SMOL_POWER_USE_ADC_REF_VCC);
-  else if ((sfe_power_board_ADC_ref_e)buffer == SFE_SMOL_POWER_USE_ADC_REF_1V1)
-    return (SFE_SMOL_POWER_USE_ADC_REF_1V1);
-  else
-    return (SFE_SMOL_POWER_USE_ADC_REF_UNDEFINED);
+  sfeSmolPowerBusLockScope busLockScope(&smolPowerBoard_io);
+  return (powerBoardFuelGauge.getChangeRate());
 }
+#endif
 
 /**************************************************************************/
 /*!
-    @brief  Set the ATtiny43U's Watchdog Timer prescaler to set the WDT interrupt rate.
-    @param  prescaler
-            The prescaler.
-    @return True if the prescaler is set successfuly, false if not.
+    @brief  Read the state of charge from the MAX_17048 fuel gauge in 0.01%.
+            Note: the MAX1704x library converts the reading using float internally.
+    @return The state of charge in 0.01%. E.g. 8750 is 87.5%.
 */
 /**************************************************************************/
-bool sfeSmolPowerBoard::setWatchdogTimerPrescaler(sfe_power_board_WDT_prescale_e prescaler)
+uint16_t smolPowerLiPo::getSOCCentiPercent()
 {
-  /** To change the prescaler, we need to write two bytes to SFE_SMOL_POWER_REGISTER_WDT_PRESCALER
-      The first is the new prescaler. The second is a one byte CRC of the address. */
-  byte bytesToSend[2];
-  bytesToSend[0] = (byte)prescaler;
-  bytesToSend[1] = computeCRC8(bytesToSend, 1);
-  smolPowerBoard_io.writeMultipleBytes(SFE_SMOL_POWER_REGISTER_WDT_PRESCALER, bytesToSend, 2);
-  delay(SFE_SMOL_POWER_EEPROM_UPDATE_DELAY);
-  return (getWatchdogTimerPrescaler() == prescaler); //Check the prescaler was modified correctly by reading it back again
+  sfeSmolPowerBusLockScope busLockScope(&smolPowerBoard_io);
+  float soc = powerBoardFuelGauge.getSOC();
+  if (soc <= 0.0)
+    return (0);
+  if (soc >= 655.35)
+    return (0xFFFF);
+  return ((uint16_t)((soc * 100.0) + 0.5));
 }
 
 /**************************************************************************/
 /*!
-    @brief  Get the ATtiny43U's Watchdog Timer prescaler setting.
-    @return The appropriate SFE_SMOL_POWER_WDT_PRESCALE_ or SFE_SMOL_POWER_WDT_PRESCALE_UNDEFINED if communication failed.
+    @brief  Read the rate of change of the state of charge from the MAX_17048 fuel gauge in 0.01%/hr.
+            Note: the MAX1704x library converts the reading using float internally.
+    @return The change rate in 0.01%/hr. Positive while charging, negative while discharging.
 */
 /**************************************************************************/
-sfe_power_board_WDT_prescale_e sfeSmolPowerBoard::getWatchdogTimerPrescaler()
+int32_t smolPowerLiPo::getChangeRateCentiPercentPerHour()
 {
-  byte buffer;
-  bool result = smolPowerBoard_io.readSingleByte(SFE_SMOL_POWER_REGISTER_WDT_PRESCALER, &buffer);
-  if (!result)
-    return (SFE_SMOL_POWER_WDT_TIMEOUT_UNDEFINED);
-  if ((sfe_power_board_WDT_prescale_e)buffer <= SFE_SMOL_POWER_WDT_TIMEOUT_8s)
-    return ((sfe_power_board_WDT_prescale_e)buffer);
-  else
-    return (SFE_SMOL_POWER_WDT_TIMEOUT_UNDEFINED);
+  sfeSmolPowerBusLockScope busLockScope(&smolPowerBoard_io);
+  float rate = powerBoardFuelGauge.getChangeRate() * 100.0;
+  return ((int32_t)((rate < 0.0) ? (rate - 0.5) : (rate + 0.5)));
 }
 
 /**************************************************************************/
 /*!
-    @brief  Set the Power Board Power-down duration in Watchdog Timer interrupts.
-    @param  duration
-            The power-down duration.
-    @return True if the duration is set successfuly, false if not.
+    @brief  Set the empty alert threshold. SFE_SMOL_POWER_ALERT_SOC_LOW is raised,
+            and the ALRT pin is pulled low, when the state of charge falls below this threshold.
+    @param  percent
+            The threshold in %: 1 to 32.
+    @return True if the threshold was set successfully, otherwise false.
 */
 /**************************************************************************/
-bool sfeSmolPowerBoard::setPowerdownDurationWDTInts(uint16_t duration)
+bool smolPowerLiPo::setEmptyAlertThreshold(byte percent)
 {
-  /** To change the power-down duration, we need to write three bytes to the SFE_SMOL_POWER_REGISTER_POWERDOWN_DURATION register.
-      The first two are the duration in uint16_t little endian format. The third is a one byte CRC of the duration. */
-  byte bytesToSend[3];
-  bytesToSend[0] = (byte)(duration & 0xFF); // Little endian
-  bytesToSend[1] = (byte)(duration >> 8);
-  bytesToSend[2] = computeCRC8(bytesToSend, 2);
-  smolPowerBoard_io.writeMultipleBytes(SFE_SMOL_POWER_REGISTER_POWERDOWN_DURATION, bytesToSend, 3);
-  delay(SFE_SMOL_POWER_EEPROM_UPDATE_DELAY);
-  uint16_t readDuration;
-  bool result = getPowerDownDurationWDTInts(&readDuration); //Check the duration was modified correctly by reading it back again
-  return (result && (readDuration == duration));
+  sfeSmolPowerBusLockScope busLockScope(&smolPowerBoard_io);
+  if ((percent < 1) || (percent > 32))
+    return (false);
+  return (powerBoardFuelGauge.setThreshold(percent) == 0);
 }
 
 /**************************************************************************/
 /*!
-    @brief  Get the Power Board Power-down duration in Watchdog Timer interrupts.
-    @param  duration
-            Pointer for the power-down duration.
-    @return True if the duration was read successfully, false if not.
+    @brief  Get the empty alert threshold.
+    @return The threshold in %.
 */
 /**************************************************************************/
-bool sfeSmolPowerBoard::getPowerDownDurationWDTInts(uint16_t *duration)
+byte smolPowerLiPo::getEmptyAlertThreshold()
 {
-  byte buffer[2];
-  bool result = smolPowerBoard_io.readMultipleBytes(SFE_SMOL_POWER_REGISTER_POWERDOWN_DURATION, buffer, 2);
-  *duration = (((uint16_t)buffer[1]) << 8) | (uint16_t)buffer[0]; // Little endian
-  return (result);
+  sfeSmolPowerBusLockScope busLockScope(&smolPowerBoard_io);
+  return (powerBoardFuelGauge.getThreshold());
 }
 
 /**************************************************************************/
 /*!
-    @brief  Power down the system now. The smôl bus power will be disabled.
-            The ATtiny43U will wake up and turn the power back on after
-            SFE_SMOL_POWER_REGISTER_POWERDOWN_DURATION WDT interrupts.
-    @return True if communication with the ATtiny43U was successful, false if not.
+    @brief  Set the battery voltage alert window. SFE_SMOL_POWER_ALERT_VOLTAGE_LOW is raised
+            below minMillivolts, SFE_SMOL_POWER_ALERT_VOLTAGE_HIGH above maxMillivolts.
+            The MAX17048 has a resolution of 20mV: the window is widened to the nearest 20mV.
+            Use 0 and 5100 to disable the voltage alerts.
+    @param  minMillivolts
+            The low voltage threshold in mV.
+    @param  maxMillivolts
+            The high voltage threshold in mV.
+    @return True if the thresholds were set successfully, otherwise false.
 */
 /**************************************************************************/
-bool sfeSmolPowerBoard::powerDownNow()
+bool smolPowerLiPo::setVoltageAlertThresholds(uint16_t minMillivolts, uint16_t maxMillivolts)
 {
-  /** To power-down, we need to write six bytes to the SFE_SMOL_POWER_REGISTER_POWERDOWN_NOW register.
-      The first five are the ASCII characters SLEEP. The sixth is a one byte CRC of the characters. */
-  byte bytesToSend[6];
-  bytesToSend[0] = 'S';
-  bytesToSend[1] = 'L';
-  bytesToSend[2] = 'E';
-  bytesToSend[3] = 'E';
-  bytesToSend[4] = 'P';
-  bytesToSend[5] = computeCRC8(bytesToSend, 5);
-  return (smolPowerBoard_io.writeMultipleBytes(SFE_SMOL_POWER_REGISTER_POWERDOWN_NOW, bytesToSend, 6));
+  sfeSmolPowerBusLockScope busLockScope(&smolPowerBoard_io);
+  if (minMillivolts > maxMillivolts)
+    return (false);
+  uint16_t minimum = minMillivolts / SFE_SMOL_POWER_VALRT_MV_PER_LSB; // Round down
+  uint16_t maximum = (maxMillivolts + (SFE_SMOL_POWER_VALRT_MV_PER_LSB - 1)) / SFE_SMOL_POWER_VALRT_MV_PER_LSB; // Round up
+  if (maximum > 0xFF)
+    maximum = 0xFF;
+  return ((powerBoardFuelGauge.setVALRTMin((uint8_t)minimum) == 0) && (powerBoardFuelGauge.setVALRTMax((uint8_t)maximum) == 0));
 }
 
 /**************************************************************************/
 /*!
-    @brief  Get the Power Board firmware version.
-    @return The firmware version if read successfully, 0x00 if not.
-            The firmware version is: Major Version (4-bits << 4) | Minor Version (4-bits).
-            E.g. 0x10 is: v1.0, Major Version 1, Minor Version 0.
+    @brief  Enable or disable the state of charge change alert.
+            When enabled, SFE_SMOL_POWER_ALERT_SOC_CHANGE is raised each time the state of charge changes by 1%.
+    @param  enable
+            True to enable the alert, false to disable it.
+    @return True if the alert was configured successfully, otherwise false.
 */
 /**************************************************************************/
-byte sfeSmolPowerBoard::getFirmwareVersion()
+bool smolPowerLiPo::enableSOCChangeAlert(bool enable)
 {
-  byte version;
-  bool result = smolPowerBoard_io.readSingleByte(SFE_SMOL_POWER_REGISTER_FIRMWARE_VERSION, &version);
-  if (!result)
-    version = 0;
-  return (version);
+  sfeSmolPowerBusLockScope busLockScope(&smolPowerBoard_io);
+  if (enable)
+    return (powerBoardFuelGauge.enableSOCAlert() == 0);
+  return (powerBoardFuelGauge.disableSOCAlert() == 0);
 }
 
 /**************************************************************************/
 /*!
-    @brief  Given an array of bytes, this calculates the CRC8 for those bytes.
-            From: http://www.sunshine2k.de/articles/coding/crc/understanding_crc.html
-            Tested with: http://www.sunshine2k.de/coding/javascript/crc/crc_js.html
-            x^8+x^5+x^4+1 = 0x31
-    @param  data
-            The array of bytes
-    @param  len
-            The length of the array of bytes
-    @return The CRC
+    @brief  Read which alerts are set. The alerts stay set until they are cleared with clearAlerts.
+    @return The SFE_SMOL_POWER_ALERT_ flags which are set.
 */
 /**************************************************************************/
-byte sfeSmolPowerBoard::computeCRC8(byte data[], byte len)
+byte smolPowerLiPo::getAlerts()
 {
-  byte crc = 0xFF; //Init with 0xFF
+  sfeSmolPowerBusLockScope busLockScope(&smolPowerBoard_io);
+  return (powerBoardFuelGauge.getStatus() & SFE_SMOL_POWER_ALERT_ALL);
+}
 
-  for (byte x = 0; x < len; x++)
-  {
-    crc ^= data[x]; // XOR-in the next input byte
+/**************************************************************************/
+/*!
+    @brief  Clear the alert flags, then clear the ALRT bit so the gauge releases the ALRT pin.
+    @param  alerts
+            The SFE_SMOL_POWER_ALERT_ flags to clear.
+    @return True if the alerts were cleared successfully, otherwise false.
+*/
+/**************************************************************************/
+bool smolPowerLiPo::clearAlerts(byte alerts)
+{
+  sfeSmolPowerBusLockScope busLockScope(&smolPowerBoard_io);
+  // The MAX1704x library clears each STATUS bit individually
+  if (alerts & SFE_SMOL_POWER_ALERT_RESET)
+    powerBoardFuelGauge.isReset(true);
+  if (alerts & SFE_SMOL_POWER_ALERT_VOLTAGE_HIGH)
+    powerBoardFuelGauge.isVoltageHigh(true);
+  if (alerts & SFE_SMOL_POWER_ALERT_VOLTAGE_LOW)
+    powerBoardFuelGauge.isVoltageLow(true);
+  if (alerts & SFE_SMOL_POWER_ALERT_SOC_LOW)
+    powerBoardFuelGauge.isLow(true);
+  if (alerts & SFE_SMOL_POWER_ALERT_SOC_CHANGE)
+    powerBoardFuelGauge.isChange(true);
+  return (powerBoardFuelGauge.clearAlert() == 0);
+}
 
-    for (byte i = 0; i < 8; i++)
-    {
-      if ((crc & 0x80) != 0)
-        crc = (byte)((crc << 1) ^ 0x31);
-      else
-        crc <<= 1;
-    }
-  }
+/**************************************************************************/
+/*!
+    @brief  Put the MAX17048 into hibernate. The gauge keeps tracking the state of charge
+            but the ADC sample rate is reduced.
+    @return True if the command was successful, otherwise false.
+*/
+/**************************************************************************/
+bool smolPowerLiPo::sleepFuelGauge()
+{
+  sfeSmolPowerBusLockScope busLockScope(&smolPowerBoard_io);
+  return (powerBoardFuelGauge.sleep() == 0);
+}
 
-  return crc; //No output reflection
+/**************************************************************************/
+/*!
+    @brief  Wake the MAX17048 from hibernate.
+    @return True if the command was successful, otherwise false.
+*/
+/**************************************************************************/
+bool smolPowerLiPo::wakeFuelGauge()
+{
+  sfeSmolPowerBusLockScope busLockScope(&smolPowerBoard_io);
+  return (powerBoardFuelGauge.wake() == 0);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Check that the MAX17048 acknowledges its address.
+            The MAX1704x library reads 0 if the gauge does not respond. Use this to tell a failed read from a true 0.
+    @return True if the MAX17048 is connected, otherwise false.
+*/
+/**************************************************************************/
+bool smolPowerLiPo::isFuelGaugeConnected()
+{
+  sfeSmolPowerBusLockScope busLockScope(&smolPowerBoard_io);
+  return (powerBoardFuelGauge.isConnected());
+}
+
+/**************************************************************************/
+/*!
+    @brief  Get the MAX17048 fuel gauge object, for any features which are not wrapped by smolPowerLiPo.
+    @return A reference to the SFE_MAX1704X.
+*/
+/**************************************************************************/
+SFE_MAX1704X &smolPowerLiPo::getFuelGauge()
+{
+  return (powerBoardFuelGauge);
+}
+
+smolPowerLiPo *smolPowerLiPo::_alertOwner = nullptr;
+volatile bool smolPowerLiPo::_alertPending = false;
+void (*smolPowerLiPo::_alertCallback)() = nullptr;
+
+/**************************************************************************/
+/*!
+    @brief  The ALRT interrupt service routine. Records the alert and calls the user's callback.
+            No I2C traffic here: the alert is read later by serviceAlerts.
+*/
+/**************************************************************************/
+void IRAM_ATTR smolPowerLiPo::alertISR()
+{
+  _alertPending = true;
+  if (_alertCallback != nullptr)
+    _alertCallback();
+}
+
+/**************************************************************************/
+/*!
+    @brief  Use the MAX17048 ALRT pin to signal alerts, instead of polling the gauge.
+            ALRT is open-drain and active low. The pin is configured as INPUT_PULLUP
+            and the interrupt is attached to its falling edge.
+            Configure the alerts (setEmptyAlertThreshold, setVoltageAlertThresholds, enableSOCChangeAlert)
+            then call serviceAlerts from loop.
+            Only one smolPowerLiPo can own the alert interrupt at a time. It stays owned until
+            detachAlertInterrupt is called (or the owner is destroyed). The owner can call this again to change the pin.
+    @param  pin
+            The interrupt-capable pin connected to ALRT.
+    @param  callback
+            Optional. Called from the interrupt, e.g. to wake an RTOS task. Must not use I2C.
+    @return True if the interrupt was attached, false if the pin does not support interrupts
+            or another smolPowerLiPo owns the alert interrupt.
+*/
+/**************************************************************************/
+bool smolPowerLiPo::attachAlertInterrupt(int pin, void (*callback)())
+{
+  if ((_alertOwner != nullptr) && (_alertOwner != this))
+    return (false);
+  int interrupt = digitalPinToInterrupt(pin);
+  if (interrupt < 0)
+    return (false);
+
+  detachAlertInterrupt();
+  _alertOwner = this;
+  _alertCallback = callback;
+  _alertPin = pin;
+  pinMode(pin, INPUT_PULLUP);
+  _alertPending = (digitalRead(pin) == LOW); // An alert may already be asserted: there will be no falling edge for it
+  attachInterrupt(interrupt, alertISR, FALLING);
+  return (true);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Stop using the ALRT pin and release the alert interrupt. Does nothing if another
+            smolPowerLiPo owns the alert interrupt.
+*/
+/**************************************************************************/
+void smolPowerLiPo::detachAlertInterrupt()
+{
+  if ((_alertOwner != this) || (_alertPin < 0))
+    return;
+  detachInterrupt(digitalPinToInterrupt(_alertPin));
+  _alertPin = -1;
+  _alertOwner = nullptr;
+  _alertCallback = nullptr;
+  _alertPending = false;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Check if ALRT has fallen since the alerts were last serviced. No I2C traffic.
+    @return True if an alert is pending. Always false if this object does not own the alert interrupt.
+*/
+/**************************************************************************/
+bool smolPowerLiPo::isAlertPending()
+{
+  return ((_alertOwner == this) && _alertPending);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Service the ALRT interrupt. If no alert is pending, this returns immediately without
+            any I2C traffic, so it can be called from loop as often as you like.
+            Otherwise the alerts are read and cleared, releasing the ALRT pin.
+    @return The SFE_SMOL_POWER_ALERT_ flags which were set, or 0 if no alert is pending
+            or this object does not own the alert interrupt.
+*/
+/**************************************************************************/
+byte smolPowerLiPo::serviceAlerts()
+{
+  if (!isAlertPending())
+    return (0);
+  _alertPending = false; // Clear the flag first, so an alert raised while we are servicing is not lost
+  byte alerts = getAlerts();
+  clearAlerts(alerts);
+  if ((_alertPin >= 0) && (digitalRead(_alertPin) == LOW)) // Still asserted? Service it again next time
+    _alertPending = true;
+  return (alerts);
+}
+#endif // SFE_SMOL_POWER_TRANSPORT_TWOWIRE
+
+#ifndef SFE_SMOL_POWER_DISABLE_FLOAT
+/**************************************************************************/
+/*!
+    @brief  Measure the ATtiny43U's VCC by reading the 1.1V internal reference via the ADC.
+            <br>This function blocks while the ATtiny43U performs the ADC conversion.
+            Use startMeasureVCC, poll and collect to avoid blocking.
+    @return The battery voltage in Volts or -99.0 if an error occurred.
+*/
+/**************************************************************************/
+float sfeSmolPowerBoard::measureVCC()
+{
+  SFE_SMOL_POWER_API_SCOPE(SFE_SMOL_POWER_API_MEASURE_VCC);
+  startMeasureVCC();
+  waitForMeasurement();
+  return (collect());
+}
+#endif
+
+/**************************************************************************/
+/*!
+    @brief  Measure the ATtiny43U's VCC using integer arithmetic only.
+            <br>This function blocks while the ATtiny43U performs the ADC conversion.
+            Use startMeasureVCC, poll and collectFixedPoint to avoid blocking.
+    @return VCC in mV or 0 if an error occurred.
+*/
+/**************************************************************************/
+uint16_t sfeSmolPowerBoard::measureVCCMillivolts()
+{
+  SFE_SMOL_POWER_API_SCOPE(SFE_SMOL_POWER_API_MEASURE_VCC);
+  startMeasureVCC();
+  waitForMeasurement();
+  return ((uint16_t)collectFixedPoint());
+}
+
+/**************************************************************************/
+/*!
+    @brief  Start a split-phase (non-blocking) VCC measurement.
+            Any measurement already in progress is abandoned.
+            Call poll until it returns true, then call collect to read VCC.
+    @return True if the measurement was started successfully, otherwise false.
+*/
+/**************************************************************************/
+bool sfeSmolPowerBoard::startMeasureVCC()
+{
+  SFE_SMOL_POWER_API_SCOPE(SFE_SMOL_POWER_API_START_MEASUREMENT);
+  /** By reading the 1.1V internal reference we can work out what VCC is.
+      We need to read two bytes (uint16_t, little endian) from SFE_SMOL_POWER_REGISTER_1V1.
+      This will be the raw 10-bit ADC reading. The ATtiny43U will automatically select
+      VCC as the reference. There is no need to select it here.
+      The conversion is done by collect. */
+  _measurement = SFE_SMOL_POWER_MEASUREMENT_VCC;
+  if (smolPowerBoard_io.startRead(sfe_power_board_reg_1v1_t::address, sfe_power_board_reg_1v1_t::readDelay))
+    _measurementState = SFE_SMOL_POWER_MEASUREMENT_WAITING;
+  else
+    _measurementState = SFE_SMOL_POWER_MEASUREMENT_FAILED;
+  return (_measurementState == SFE_SMOL_POWER_MEASUREMENT_WAITING);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Read the raw 10-bit ADC reading from SFE_SMOL_POWER_REGISTER_TEMPERATURE.
+            The sensitivity is approximately 1 LSB/°C with 25°C reading as 300 ADU.
+    @param  raw
+            Pointer for the raw reading. Unchanged if the read fails.
+    @return True if the reading was read successfully, false if not.
+*/
+/**************************************************************************/
+bool sfeSmolPowerBoard::getRawTemperature(uint16_t *raw)
+{
+  SFE_SMOL_POWER_API_SCOPE(SFE_SMOL_POWER_API_GET_TEMPERATURE);
+  return (readRegister<sfe_power_board_reg_temperature_t>(raw));
+}
+
+/**************************************************************************/
+/*!
+    @brief  Read the raw 10-bit ADC reading from SFE_SMOL_POWER_REGISTER_VBAT.
+            The reading is half of VBAT, using the selected ADC reference.
+    @param  raw
+            Pointer for the raw reading. Unchanged if the read fails.
+    @return True if the reading was read successfully, false if not.
+*/
+/**************************************************************************/
+bool sfeSmolPowerBoard::getRawVBAT(uint16_t *raw)
+{
+  SFE_SMOL_POWER_API_SCOPE(SFE_SMOL_POWER_API_GET_BATTERY_VOLTAGE);
+  return (readRegister<sfe_power_board_reg_vbat_t>(raw));
+}
+
+/**************************************************************************/
+/*!
+    @brief  Read the raw 10-bit ADC reading from SFE_SMOL_POWER_REGISTER_1V1.
+            The reading is the 1.1V internal reference, using VCC as the ADC reference.
+            The cached VCC is updated.
+    @param  raw
+            Pointer for the raw reading. Unchanged if the read fails.
+    @return True if the reading was read successfully, false if not.
+*/
+/**************************************************************************/
+bool sfeSmolPowerBoard::getRaw1V1(uint16_t *raw)
+{
+  SFE_SMOL_POWER_API_SCOPE(SFE_SMOL_POWER_API_MEASURE_VCC);
+  bool result = readRegister<sfe_power_board_reg_1v1_t>(raw);
+  if (result)
+    updateCachedRaw1V1(*raw);
+  return (result);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Service the split-phase (non-blocking) measurement.
+            Call this regularly from your loop. It never blocks: each call makes at most one
+            attempt to collect the raw reading, once the ATtiny43U has had time to complete the ADC conversion.
+            If the reading is not ready yet (adaptive settle time) or the read failed and will be retried,
+            this returns false and the next attempt is made by a later call.
+            If the battery voltage is being measured using the VCC reference, the VCC measurement is started automatically.
+    @return True when the result is ready to collect (or the measurement failed), otherwise false.
+*/
+/**************************************************************************/
+bool sfeSmolPowerBoard::poll()
+{
+  SFE_SMOL_POWER_API_SCOPE(SFE_SMOL_POWER_API_POLL);
+  if ((_measurementState != SFE_SMOL_POWER_MEASUREMENT_WAITING) && (_measurementState != SFE_SMOL_POWER_MEASUREMENT_WAITING_VCC))
+    return (isReady());
+
+  byte theBytes[2];
+  sfe_power_board_read_status_e status = smolPowerBoard_io.pollRead(theBytes, 2); // A single attempt. Never blocks
+  if (status == SFE_SMOL_POWER_READ_PENDING)
+    return (false); // Keep waiting
+  if (status == SFE_SMOL_POWER_READ_FAILED)
+  {
+    _measurementState = SFE_SMOL_POWER_MEASUREMENT_FAILED;
+    return (true);
+  }
+
+  uint16_t rawADC = sfe_power_board_reg_vbat_t::decode(theBytes); // Little endian. TEMPERATURE, VBAT and 1V1 are all uint16_t
+
+  if (_measurementState == SFE_SMOL_POWER_MEASUREMENT_WAITING_VCC) // Battery voltage: we have measured VCC
+  {
+    _raw1V1 = rawADC;
+    updateCachedRaw1V1(rawADC);
+  }
+  else
+  {
+    _rawResult = rawADC;
+    if (_measurement == SFE_SMOL_POWER_MEASUREMENT_VCC)
+      updateCachedRaw1V1(rawADC);
+    else if ((_measurement == SFE_SMOL_POWER_MEASUREMENT_BATTERY) && (_measurementReference == SFE_SMOL_POWER_USE_ADC_REF_VCC)) // Are we using VCC as the reference?
+    {
+      if (!getCachedRaw1V1(&_raw1V1)) // Can we reuse a recent VCC measurement?
+      {
+        // We need to measure VCC so we can scale the ADC reading correctly
+        if (smolPowerBoard_io.startRead(sfe_power_board_reg_1v1_t::address, sfe_power_board_reg_1v1_t::readDelay))
+        {
+          _measurementState = SFE_SMOL_POWER_MEASUREMENT_WAITING_VCC;
+          return (false);
+        }
+        _measurementState = SFE_SMOL_POWER_MEASUREMENT_FAILED;
+        return (true);
+      }
+    }
+  }
+
+  _measurementState = SFE_SMOL_POWER_MEASUREMENT_COMPLETE;
+  return (true);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Check if the split-phase measurement result is ready to collect.
+            This function does not service the measurement. Call poll for that.
+    @return True if the result is ready to collect (or the measurement failed), otherwise false.
+*/
+/**************************************************************************/
+bool sfeSmolPowerBoard::isReady()
+{
+  return ((_measurementState == SFE_SMOL_POWER_MEASUREMENT_COMPLETE) || (_measurementState == SFE_SMOL_POWER_MEASUREMENT_FAILED));
+}
+
+#ifndef SFE_SMOL_POWER_DISABLE_FLOAT
+/**************************************************************************/
+/*!
+    @brief  Collect the result of the split-phase measurement and end the measurement.
+    @return The temperature in Degrees Centigrade / Celcius, or the voltage in Volts.
+            Returns -273.15 (temperature) or -99.0 (voltage) if the measurement failed
+            or is not yet complete.
+*/
+/**************************************************************************/
+float sfeSmolPowerBoard::collect()
+{
+  float result = (_measurement == SFE_SMOL_POWER_MEASUREMENT_TEMPERATURE) ? -273.15 : -99.0;
+  if (!isReady())
+    return (result); // Measurement is not complete
+  if (_measurementState == SFE_SMOL_POWER_MEASUREMENT_COMPLETE)
+  {
+    if (_measurement == SFE_SMOL_POWER_MEASUREMENT_TEMPERATURE)
+      result = convertTemperature(_rawResult);
+    else if (_measurement == SFE_SMOL_POWER_MEASUREMENT_VCC)
+      result = convertVCC(_rawResult);
+    else if (_measurement == SFE_SMOL_POWER_MEASUREMENT_BATTERY)
+      result = convertBatteryVoltage(_rawResult, _measurementReference, _raw1V1);
+    else // SFE_SMOL_POWER_MEASUREMENT_FUEL_GAUGE
+      result = ((float)_rawResult) / 1000.0; // Convert mV to V
+  }
+  _measurementState = SFE_SMOL_POWER_MEASUREMENT_IDLE;
+  return (result);
+}
+#endif
+
+/**************************************************************************/
+/*!
+    @brief  Collect the result of the split-phase measurement, using integer arithmetic only,
+            and end the measurement.
+    @return The temperature in hundredths of a Degree C (centi-°C), or the voltage in mV.
+            Returns SFE_SMOL_POWER_TEMPERATURE_CENTI_C_ERROR (temperature) or 0 (voltage)
+            if the measurement failed or is not yet complete.
+*/
+/**************************************************************************/
+int32_t sfeSmolPowerBoard::collectFixedPoint()
+{
+  int32_t result = (_measurement == SFE_SMOL_POWER_MEASUREMENT_TEMPERATURE) ? SFE_SMOL_POWER_TEMPERATURE_CENTI_C_ERROR : 0;
+  if (!isReady())
+    return (result); // Measurement is not complete
+  if (_measurementState == SFE_SMOL_POWER_MEASUREMENT_COMPLETE)
+  {
+    if (_measurement == SFE_SMOL_POWER_MEASUREMENT_TEMPERATURE)
+      result = convertTemperatureCentiC(_rawResult);
+    else if (_measurement == SFE_SMOL_POWER_MEASUREMENT_VCC)
+      result = convertVCCMillivolts(_rawResult);
+    else if (_measurement == SFE_SMOL_POWER_MEASUREMENT_BATTERY)
+      result = convertBatteryMillivolts(_rawResult, _measurementReference, _raw1V1);
+    else // SFE_SMOL_POWER_MEASUREMENT_FUEL_GAUGE
+      result = _rawResult; // Already in mV
+  }
+  _measurementState = SFE_SMOL_POWER_MEASUREMENT_IDLE;
+  return (result);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Get the state of the split-phase measurement.
+            Call this before collect to tell if the measurement failed.
+    @return The measurement state: SFE_SMOL_POWER_MEASUREMENT_IDLE etc.
+*/
+/**************************************************************************/
+sfe_power_board_measurement_state_e sfeSmolPowerBoard::getMeasurementState()
+{
+  return (_measurementState);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Block until the split-phase measurement is complete.
+            This is used by the blocking functions: getTemperature, measureVCC, getBatteryVoltage etc.
+    @return True if the measurement completed successfully, false if it failed.
+*/
+/**************************************************************************/
+bool sfeSmolPowerBoard::waitForMeasurement()
+{
+  while (!poll())
+    smolPowerBoard_io.delayMS(smolPowerBoard_io.getReadWaitRemaining()); // Give the ATtiny43U time to collect the requested data
+  return (_measurementState == SFE_SMOL_POWER_MEASUREMENT_COMPLETE);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Set the ATtiny43U's ADC voltage reference to VCC or the internal 1.1V reference.
+    @param  ref
+            The reference: SFE_SMOL_POWER_USE_ADC_REF_VCC or SFE_SMOL_POWER_USE_ADC_REF_1V1
+    @return True if the reference is set successfuly, false if not.
+*/
+/**************************************************************************/
+bool sfeSmolPowerBoard::setADCVoltageReference(sfe_power_board_ADC_ref_e ref)
+{
+  SFE_SMOL_POWER_API_SCOPE(SFE_SMOL_POWER_API_SET_ADC_REFERENCE);
+  /** To change the voltage reference, we need to write two bytes to SFE_SMOL_POWER_REGISTER_ADC_REFERENCE
+      The first is the new reference. The second is a one byte CRC of the reference.
+      writeRegister adds the CRC and waits for the eeprom to be updated. */
+  writeRegister<sfe_power_board_reg_adc_reference_t>((byte)ref);
+  return (verifyWrite(getADCVoltageReference() == ref)); //Check the reference was modified correctly by reading it back again
+}
+
+/**************************************************************************/
+/*!
+    @brief  Get the ATtiny43U's ADC voltage reference: VCC or the internal 1.1V reference.
+    @return SFE_SMOL_POWER_USE_ADC_REF_VCC or SFE_SMOL_POWER_USE_ADC_REF_1V1 if the reference was read successfuly,
+            SFE_SMOL_POWER_USE_ADC_REF_UNDEFINED if not.
+*/
+/**************************************************************************/
+sfe_power_board_ADC_ref_e sfeSmolPowerBoard::getADCVoltageReference()
+{
+  SFE_SMOL_POWER_API_SCOPE(SFE_SMOL_POWER_API_GET_ADC_REFERENCE);
+  byte buffer;
+  bool result = readRegister<sfe_power_board_reg_adc_reference_t>(&buffer);
+  _shadowValid &= ~SFE_SMOL_POWER_SHADOW_ADC_REFERENCE;
+  if (!result)
+    return (SFE_SMOL_POWER_USE_ADC_REF_UNDEFINED);
+  if (((sfe_power_board_ADC_ref_e)buffer == SFE_SMOL_POWER_USE_ADC_REF_VCC) || ((sfe_power_board_ADC_ref_e)buffer == SFE_SMOL_POWER_USE_ADC_REF_1V1))
+  {
+    _shadowADCReference = (sfe_power_board_ADC_ref_e)buffer;
+    _shadowValid |= SFE_SMOL_POWER_SHADOW_ADC_REFERENCE;
+    return (_shadowADCReference);
+  }
+  smolPowerBoard_io.setLastError(SFE_SMOL_POWER_ERROR_INVALID_VALUE);
+  return (SFE_SMOL_POWER_USE_ADC_REF_UNDEFINED);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Set the ATtiny43U's Watchdog Timer prescaler to set the WDT interrupt rate.
+    @param  prescaler
+            The prescaler.
+    @return True if the prescaler is set successfuly, false if not.
+*/
+/**************************************************************************/
+bool sfeSmolPowerBoard::setWatchdogTimerPrescaler(sfe_power_board_WDT_prescale_e prescaler)
+{
+  SFE_SMOL_POWER_API_SCOPE(SFE_SMOL_POWER_API_SET_WDT_PRESCALER);
+  /** To change the prescaler, we need to write two bytes to SFE_SMOL_POWER_REGISTER_WDT_PRESCALER
+      The first is the new prescaler. The second is a one byte CRC of the prescaler.
+      writeRegister adds the CRC and waits for the eeprom to be updated. */
+  writeRegister<sfe_power_board_reg_wdt_prescaler_t>((byte)prescaler);
+  return (verifyWrite(getWatchdogTimerPrescaler() == prescaler)); //Check the prescaler was modified correctly by reading it back again
+}
+
+/**************************************************************************/
+/*!
+    @brief  Get the ATtiny43U's Watchdog Timer prescaler setting.
+    @return The appropriate SFE_SMOL_POWER_WDT_PRESCALE_ or SFE_SMOL_POWER_WDT_PRESCALE_UNDEFINED if communication failed.
+*/
+/**************************************************************************/
+sfe_power_board_WDT_prescale_e sfeSmolPowerBoard::getWatchdogTimerPrescaler()
+{
+  SFE_SMOL_POWER_API_SCOPE(SFE_SMOL_POWER_API_GET_WDT_PRESCALER);
+  byte buffer;
+  bool result = readRegister<sfe_power_board_reg_wdt_prescaler_t>(&buffer);
+  _shadowValid &= ~SFE_SMOL_POWER_SHADOW_WDT_PRESCALER;
+  if (!result)
+    return (SFE_SMOL_POWER_WDT_TIMEOUT_UNDEFINED);
+  if ((sfe_power_board_WDT_prescale_e)buffer <= SFE_SMOL_POWER_WDT_TIMEOUT_8s)
+  {
+    _shadowWDTPrescaler = (sfe_power_board_WDT_prescale_e)buffer;
+    _shadowValid |= SFE_SMOL_POWER_SHADOW_WDT_PRESCALER;
+    return (_shadowWDTPrescaler);
+  }
+  smolPowerBoard_io.setLastError(SFE_SMOL_POWER_ERROR_INVALID_VALUE);
+  return (SFE_SMOL_POWER_WDT_TIMEOUT_UNDEFINED);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Set the Power Board Power-down duration in Watchdog Timer interrupts.
+    @param  duration
+            The power-down duration.
+    @return True if the duration is set successfuly, false if not.
+*/
+/**************************************************************************/
+bool sfeSmolPowerBoard::setPowerdownDurationWDTInts(uint16_t duration)
+{
+  SFE_SMOL_POWER_API_SCOPE(SFE_SMOL_POWER_API_SET_POWERDOWN_DURATION);
+  /** To change the power-down duration, we need to write three bytes to the SFE_SMOL_POWER_REGISTER_POWERDOWN_DURATION register.
+      The first two are the duration in uint16_t little endian format. The third is a one byte CRC of the duration.
+      writeRegister adds the CRC and waits for the eeprom to be updated. */
+  writeRegister<sfe_power_board_reg_powerdown_duration_t>(duration);
+  uint16_t readDuration;
+  bool result = getPowerDownDurationWDTInts(&readDuration); //Check the duration was modified correctly by reading it back again
+  return (result && verifyWrite(readDuration == duration));
+}
+
+/**************************************************************************/
+/*!
+    @brief  Get the Power Board Power-down duration in Watchdog Timer interrupts.
+    @param  duration
+            Pointer for the power-down duration. Unchanged if the read fails.
+    @return True if the duration was read successfully, false if not.
+*/
+/**************************************************************************/
+bool sfeSmolPowerBoard::getPowerDownDurationWDTInts(uint16_t *duration)
+{
+  SFE_SMOL_POWER_API_SCOPE(SFE_SMOL_POWER_API_GET_POWERDOWN_DURATION);
+  bool result = readRegister<sfe_power_board_reg_powerdown_duration_t>(duration);
+  _shadowValid &= ~SFE_SMOL_POWER_SHADOW_POWERDOWN_DURATION;
+  if (result)
+  {
+    _shadowPowerDownDuration = *duration;
+    _shadowValid |= SFE_SMOL_POWER_SHADOW_POWERDOWN_DURATION;
+  }
+  return (result);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Power down the system now. The smôl bus power will be disabled.
+            The ATtiny43U will wake up and turn the power back on after
+            SFE_SMOL_POWER_REGISTER_POWERDOWN_DURATION WDT interrupts.
+    @return True if communication with the ATtiny43U was successful, false if not.
+*/
+/**************************************************************************/
+bool sfeSmolPowerBoard::powerDownNow()
+{
+  SFE_SMOL_POWER_API_SCOPE(SFE_SMOL_POWER_API_POWER_DOWN_NOW);
+  /** To power-down, we need to write six bytes to the SFE_SMOL_POWER_REGISTER_POWERDOWN_NOW register.
+      The first five are the ASCII characters SLEEP. The sixth is a one byte CRC of the characters.
+      The frame is constant, so it is built at compile time. */
+  return (smolPowerBoard_io.writeMultipleBytes(sfe_power_board_reg_powerdown_now_t::address, sfe_power_board_sleep_frame_t::frame, sfe_power_board_reg_powerdown_now_t::frameSize));
+}
+
+/**************************************************************************/
+/*!
+    @brief  Read all of the ATtiny43U's configuration registers.
+            The shadow copies are updated.
+    @param  config
+            The sfe_power_board_config_t which will hold the configuration.
+    @return True if every register was read successfully, otherwise false.
+*/
+/**************************************************************************/
+bool sfeSmolPowerBoard::readConfig(sfe_power_board_config_t &config)
+{
+  SFE_SMOL_POWER_API_SCOPE(SFE_SMOL_POWER_API_READ_CONFIG);
+  config.i2cAddress = getI2CAddress();
+  config.adcReference = getADCVoltageReference();
+  config.wdtPrescaler = getWatchdogTimerPrescaler();
+  config.powerDownDuration = 0;
+  bool result = getPowerDownDurationWDTInts(&config.powerDownDuration);
+  return (result && (config.i2cAddress != 0)
+          && (config.adcReference != SFE_SMOL_POWER_USE_ADC_REF_UNDEFINED)
+          && (config.wdtPrescaler != SFE_SMOL_POWER_WDT_TIMEOUT_UNDEFINED));
+}
+
+/**************************************************************************/
+/*!
+    @brief  Apply a configuration to the ATtiny43U.
+            The configuration is compared with the shadow copies of the registers
+            (the registers are only read if the copies are invalid). Only the registers
+            which have changed are written, saving the eeprom update delay for the others.
+            The I2C address is written last and communication continues on the new address.
+            Finally, all of the selected registers are read back and verified in a single pass.
+    @param  config
+            The configuration to apply.
+    @param  fields
+            The fields to apply: the logical OR of SFE_SMOL_POWER_CONFIG_I2C_ADDRESS etc.
+            Default is SFE_SMOL_POWER_CONFIG_ALL.
+    @return The fields which could not be applied (the logical OR of SFE_SMOL_POWER_CONFIG_I2C_ADDRESS etc.)
+            or zero if the configuration was applied successfully.
+*/
+/**************************************************************************/
+byte sfeSmolPowerBoard::applyConfig(const sfe_power_board_config_t &config, byte fields)
+{
+  SFE_SMOL_POWER_API_SCOPE(SFE_SMOL_POWER_API_APPLY_CONFIG);
+  byte failed = 0;
+
+  // Write only the registers which have changed. Verification is done at the end
+  if ((fields & SFE_SMOL_POWER_CONFIG_ADC_REFERENCE) && (getCachedADCVoltageReference() != config.adcReference))
+  {
+    if (!writeRegister<sfe_power_board_reg_adc_reference_t>((byte)config.adcReference))
+      failed |= SFE_SMOL_POWER_CONFIG_ADC_REFERENCE;
+  }
+
+  if ((fields & SFE_SMOL_POWER_CONFIG_WDT_PRESCALER) && (getCachedWatchdogTimerPrescaler() != config.wdtPrescaler))
+  {
+    if (!writeRegister<sfe_power_board_reg_wdt_prescaler_t>((byte)config.wdtPrescaler))
+      failed |= SFE_SMOL_POWER_CONFIG_WDT_PRESCALER;
+  }
+
+  if (fields & SFE_SMOL_POWER_CONFIG_POWERDOWN_DURATION)
+  {
+    uint16_t duration;
+    if (!getCachedPowerDownDurationWDTInts(&duration) || (duration != config.powerDownDuration))
+    {
+      if (!writeRegister<sfe_power_board_reg_powerdown_duration_t>(config.powerDownDuration))
+        failed |= SFE_SMOL_POWER_CONFIG_POWERDOWN_DURATION;
+    }
+  }
+
+  // The ATtiny43U responds on the new address as soon as it is written, so change it last
+  if ((fields & SFE_SMOL_POWER_CONFIG_I2C_ADDRESS) && (smolPowerBoard_io.getAddress() != config.i2cAddress))
+  {
+    if (writeRegister<sfe_power_board_reg_i2c_address_t>(config.i2cAddress))
+      smolPowerBoard_io.setAddress(config.i2cAddress);
+    else
+      failed |= SFE_SMOL_POWER_CONFIG_I2C_ADDRESS;
+  }
+
+  // Verify everything in one pass. This also updates the shadow copies
+  if ((fields & SFE_SMOL_POWER_CONFIG_ADC_REFERENCE) && (getADCVoltageReference() != config.adcReference))
+    failed |= SFE_SMOL_POWER_CONFIG_ADC_REFERENCE;
+
+  if ((fields & SFE_SMOL_POWER_CONFIG_WDT_PRESCALER) && (getWatchdogTimerPrescaler() != config.wdtPrescaler))
+    failed |= SFE_SMOL_POWER_CONFIG_WDT_PRESCALER;
+
+  if (fields & SFE_SMOL_POWER_CONFIG_POWERDOWN_DURATION)
+  {
+    uint16_t duration;
+    if (!getPowerDownDurationWDTInts(&duration) || (duration != config.powerDownDuration))
+      failed |= SFE_SMOL_POWER_CONFIG_POWERDOWN_DURATION;
+  }
+
+  if ((fields & SFE_SMOL_POWER_CONFIG_I2C_ADDRESS) && (getI2CAddress() != config.i2cAddress))
+    failed |= SFE_SMOL_POWER_CONFIG_I2C_ADDRESS;
+
+  verifyWrite(failed == 0);
+  return (failed);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Capture the board's identity and configuration, so that resume can be used
+            instead of begin after the host wakes from power-down.
+            Anything which is not already cached is read now, before powering down, so it
+            does not need to be read after waking.
+            Call this after the last configuration change: use configurePowerDown, then
+            saveResumeState, then powerDownNow (powerDownFor changes the configuration).
+            Store state somewhere which survives the power-down.
+    @param  state
+            The sfe_power_board_resume_t which will hold the state. It is always valid,
+            but only holds the configuration which could be read.
+    @return True if everything was captured, otherwise false.
+*/
+/**************************************************************************/
+bool sfeSmolPowerBoard::saveResumeState(sfe_power_board_resume_t &state)
+{
+  if (_resetReason & SFE_SMOL_POWER_COMM_ERROR)
+    getResetReason(); // Read this first: it may invalidate the shadow copies
+  if (_firmwareVersion == 0)
+    getFirmwareVersion();
+  sfe_power_board_ADC_ref_e ref = getCachedADCVoltageReference();
+  sfe_power_board_WDT_prescale_e prescaler = getCachedWatchdogTimerPrescaler();
+  uint16_t duration = 0;
+  bool result = getCachedPowerDownDurationWDTInts(&duration);
+
+  memset(&state, 0, sizeof(sfe_power_board_resume_t)); // Clear any padding, so the CRC is repeatable
+  state.magic = SFE_SMOL_POWER_RESUME_MAGIC;
+  state.version = SFE_SMOL_POWER_RESUME_VERSION;
+  state.i2cAddress = smolPowerBoard_io.getAddress();
+  state.firmwareVersion = _firmwareVersion;
+  state.resetReason = _resetReason;
+  state.shadowValid = _shadowValid & (SFE_SMOL_POWER_SHADOW_ADC_REFERENCE | SFE_SMOL_POWER_SHADOW_WDT_PRESCALER | SFE_SMOL_POWER_SHADOW_POWERDOWN_DURATION);
+  state.adcReference = (byte)_shadowADCReference;
+  state.wdtPrescaler = (byte)_shadowWDTPrescaler;
+  state.powerDownDuration = _shadowPowerDownDuration;
+  state.crc = sfeSmolPowerCRC8((const byte *)&state, (byte)offsetof(sfe_power_board_resume_t, crc));
+
+  return (result && (ref != SFE_SMOL_POWER_USE_ADC_REF_UNDEFINED) && (prescaler != SFE_SMOL_POWER_WDT_TIMEOUT_UNDEFINED)
+          && (_firmwareVersion != 0) && ((_resetReason & SFE_SMOL_POWER_COMM_ERROR) == 0));
+}
+
+/**************************************************************************/
+/*!
+    @brief  Check that a resume state was saved by this version of the library and has not been corrupted.
+    @param  state
+            The state saved by saveResumeState.
+    @return True if the magic, version and CRC are correct.
+*/
+/**************************************************************************/
+bool sfeSmolPowerBoard::isResumeStateValid(const sfe_power_board_resume_t &state)
+{
+  return ((state.magic == SFE_SMOL_POWER_RESUME_MAGIC) && (state.version == SFE_SMOL_POWER_RESUME_VERSION)
+          && (state.i2cAddress != 0)
+          && (state.crc == sfeSmolPowerCRC8((const byte *)&state, (byte)offsetof(sfe_power_board_resume_t, crc))));
+}
+
+/**************************************************************************/
+/*!
+    @brief  Restore the identity and configuration from state, then check the board.
+            begin needs a probe, then reads of the address, reset reason and firmware version.
+            Here, only I2C_ADDRESS and RESET_REASON are read. That proves the board is alive
+            and at the right address.
+            If the reset reason has not changed since the state was saved, the firmware version
+            and configuration are restored from state. (The configuration is held in the
+            ATtiny43U's eeprom, so it survives a reset unless the eeprom was found to be corrupt.)
+            Otherwise the firmware version is read again and the configuration will be read when needed.
+    @param  state
+            The state saved by saveResumeState.
+    @param  resetReason
+            Optional pointer for the reset reason.
+    @return True if the board responded and the state was restored, otherwise false.
+*/
+/**************************************************************************/
+bool sfeSmolPowerBoard::resumeBoard(const sfe_power_board_resume_t &state, byte *resetReason)
+{
+  if (resetReason != NULL)
+    *resetReason = SFE_SMOL_POWER_COMM_ERROR;
+  invalidateCache();
+  _firmwareVersion = 0;
+  _resetReason = SFE_SMOL_POWER_COMM_ERROR;
+
+  if (!isResumeStateValid(state))
+  {
+    smolPowerBoard_io.setLastError(SFE_SMOL_POWER_ERROR_INVALID_VALUE);
+    return (false);
+  }
+  smolPowerBoard_io.setAddress(state.i2cAddress);
+
+  byte identity[2]; // I2C_ADDRESS, RESET_REASON
+  if (!readRegister<sfe_power_board_reg_i2c_address_t>(&identity[0]) || !readRegister<sfe_power_board_reg_reset_reason_t>(&identity[1]))
+    return (false);
+  if (identity[0] != state.i2cAddress) // Something is responding, but it is not the Power Board
+  {
+    smolPowerBoard_io.setLastError(SFE_SMOL_POWER_ERROR_INVALID_VALUE);
+    return (false);
+  }
+
+  _resetReason = identity[1];
+  if (resetReason != NULL)
+    *resetReason = identity[1];
+  _shadowI2CAddress = state.i2cAddress;
+  _shadowValid = SFE_SMOL_POWER_SHADOW_I2C_ADDRESS;
+
+  if ((identity[1] != state.resetReason) || (identity[1] & SFE_SMOL_POWER_EEPROM_CORRUPT_ON_RESET))
+    return (getFirmwareVersion() != 0); // The ATtiny43U has restarted: its firmware may have been updated
+
+  _firmwareVersion = state.firmwareVersion;
+  _shadowADCReference = (sfe_power_board_ADC_ref_e)state.adcReference;
+  _shadowWDTPrescaler = (sfe_power_board_WDT_prescale_e)state.wdtPrescaler;
+  _shadowPowerDownDuration = state.powerDownDuration;
+  _shadowValid |= state.shadowValid & (SFE_SMOL_POWER_SHADOW_ADC_REFERENCE | SFE_SMOL_POWER_SHADOW_WDT_PRESCALER | SFE_SMOL_POWER_SHADOW_POWERDOWN_DURATION);
+  return (true);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Power down for (approximately) the requested duration.
+            The prescaler and number of WDT interrupts are chosen by planPowerDown.
+            The prescaler and power-down duration are only written if they have changed,
+            saving the eeprom update delay (and eeprom wear).
+    @param  durationMS
+            The requested power-down duration in ms.
+    @param  plan
+            Optional pointer for the plan: the prescaler, WDT interrupts, achieved duration and rounding error.
+    @param  toleranceMS
+            The acceptable rounding error in ms. By default: durationMS / 32.
+    @return True if the ATtiny43U was configured and powered down, false if not.
+*/
+/**************************************************************************/
+bool sfeSmolPowerBoard::powerDownFor(unsigned long durationMS, sfe_power_board_powerdown_plan_t *plan, unsigned long toleranceMS)
+{
+  SFE_SMOL_POWER_API_SCOPE(SFE_SMOL_POWER_API_POWER_DOWN_FOR);
+  if (!configurePowerDown(durationMS, plan, toleranceMS))
+    return (false);
+  return (powerDownNow());
+}
+
+/**************************************************************************/
+/*!
+    @brief  Configure the ATtiny43U for a power-down of (approximately) the requested duration,
+            without powering down. powerDownFor is configurePowerDown followed by powerDownNow.
+            Use this to save the resume state (saveResumeState) after the configuration has
+            changed but before the power is removed.
+    @param  durationMS
+            The requested power-down duration in ms.
+    @param  plan
+            Optional pointer for the plan: the prescaler, WDT interrupts, achieved duration and rounding error.
+    @param  toleranceMS
+            The acceptable rounding error in ms. By default: durationMS / 32.
+    @return True if the ATtiny43U was configured, false if not.
+*/
+/**************************************************************************/
+bool sfeSmolPowerBoard::configurePowerDown(unsigned long durationMS, sfe_power_board_powerdown_plan_t *plan, unsigned long toleranceMS)
+{
+  SFE_SMOL_POWER_API_SCOPE(SFE_SMOL_POWER_API_POWER_DOWN_FOR);
+  sfe_power_board_powerdown_plan_t thePlan;
+  if (!planPowerDown(durationMS, thePlan, toleranceMS))
+  {
+    smolPowerBoard_io.setLastError(SFE_SMOL_POWER_ERROR_INVALID_VALUE);
+    return (false);
+  }
+  if (plan != NULL)
+    *plan = thePlan;
+
+  if (getCachedWatchdogTimerPrescaler() != thePlan.prescaler) // Only write the prescaler if it has changed
+  {
+    if (!setWatchdogTimerPrescaler(thePlan.prescaler))
+      return (false);
+  }
+
+  uint16_t duration;
+  if (!getCachedPowerDownDurationWDTInts(&duration) || (duration != thePlan.wdtInts)) // Only write the duration if it has changed
+  {
+    if (!setPowerdownDurationWDTInts(thePlan.wdtInts))
+      return (false);
+  }
+  return (true);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Plan a power-down: pick the Watchdog Timer prescaler and number of WDT interrupts
+            which achieve the requested duration with the fewest WDT interrupts.
+            Each WDT interrupt wakes the ATtiny43U, so fewer interrupts use less energy.
+            The longest prescaler whose rounding error is within the tolerance is chosen.
+            If none is within the tolerance, the plan with the smallest error is chosen.
+    @param  durationMS
+            The requested power-down duration in ms.
+    @param  plan
+            The sfe_power_board_powerdown_plan_t which will hold the plan.
+    @param  toleranceMS
+            The acceptable rounding error in ms. By default: durationMS / 32.
+    @return True if a plan was made, false if durationMS is zero or too long (more than 65535 * 8s).
+*/
+/**************************************************************************/
+bool sfeSmolPowerBoard::planPowerDown(unsigned long durationMS, sfe_power_board_powerdown_plan_t &plan, unsigned long toleranceMS)
+{
+  // Too long for 65535 of the longest WDT period. Checked first: durationMS + half a period would overflow near 2^32
+  if ((durationMS == 0) || (durationMS > (0xFFFFUL * getWDTPeriodMS(SFE_SMOL_POWER_WDT_TIMEOUT_8s))))
+    return (false);
+  if (toleranceMS == SFE_SMOL_POWER_POWERDOWN_TOLERANCE_AUTO)
+    toleranceMS = durationMS >> SFE_SMOL_POWER_POWERDOWN_TOLERANCE_SHIFT;
+
+  bool planned = false;
+  unsigned long bestError = 0;
+
+  // Start with the longest prescaler: the fewest WDT interrupts
+  for (int p = SFE_SMOL_POWER_WDT_TIMEOUT_8s; p >= SFE_SMOL_POWER_WDT_TIMEOUT_16ms; p--)
+  {
+    sfe_power_board_WDT_prescale_e prescaler = (sfe_power_board_WDT_prescale_e)p;
+    unsigned long period = getWDTPeriodMS(prescaler);
+    unsigned long ints = (durationMS + (period >> 1)) / period; // Round to the nearest number of interrupts
+    if (ints == 0)
+      ints = 1;
+    if (ints > 0xFFFF)
+      break; // Too many interrupts. The shorter prescalers need even more
+
+    unsigned long achieved = ints * period;
+    unsigned long error = (achieved > durationMS) ? (achieved - durationMS) : (durationMS - achieved);
+    if ((!planned) || (error < bestError)) // Prefer the longer prescaler if the errors are equal
+    {
+      planned = true;
+      bestError = error;
+      plan.prescaler = prescaler;
+      plan.wdtInts = (uint16_t)ints;
+      plan.durationMS = achieved;
+      plan.errorMS = (achieved >= durationMS) ? (long)error : -(long)error;
+    }
+    if (error <= toleranceMS)
+      break; // Good enough. This prescaler gives the fewest interrupts
+  }
+  return (planned);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Get the nominal Watchdog Timer period for a prescaler.
+            The ATtiny43U's WDT oscillator is not calibrated. The actual period varies with VCC and temperature.
+    @param  prescaler
+            The Watchdog Timer prescaler.
+    @return The nominal period in ms or 0 if prescaler is invalid.
+*/
+/**************************************************************************/
+uint16_t sfeSmolPowerBoard::getWDTPeriodMS(sfe_power_board_WDT_prescale_e prescaler)
+{
+  static const uint16_t periodMS[] = { 16, 32, 64, 125, 250, 500, 1000, 2000, 4000, 8000 };
+  if (prescaler > SFE_SMOL_POWER_WDT_TIMEOUT_8s)
+    return (0);
+  return (periodMS[prescaler]);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Get the Power Board firmware version.
+    @return The firmware version if read successfully, 0x00 if not.
+            The firmware version is: Major Version (4-bits << 4) | Minor Version (4-bits).
+            E.g. 0x10 is: v1.0, Major Version 1, Minor Version 0.
+*/
+/**************************************************************************/
+byte sfeSmolPowerBoard::getFirmwareVersion()
+{
+  SFE_SMOL_POWER_API_SCOPE(SFE_SMOL_POWER_API_GET_FIRMWARE_VERSION);
+  byte version;
+  bool result = readRegister<sfe_power_board_reg_firmware_version_t>(&version);
+  if (!result)
+    version = 0;
+  else
+    _firmwareVersion = version;
+  return (version);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Read a telemetry snapshot: temperature, VBAT and 1V1 (VCC).
+            The registers are read individually: six transactions and three ADC waits (45ms).
+            TEMPERATURE, VBAT and 1V1 are contiguous registers. If burst reads have been enabled
+            with setBurstReads, all three are read in a single transaction instead: two transactions
+            and one SFE_SMOL_POWER_ADC_BURST_READ_DELAY wait (38ms). The ATtiny43U still performs
+            three conversions, so this saves four transactions and ~7ms, not two thirds of the time.
+            If the burst read fails, the registers are read individually.
+            Either way, the battery voltage is scaled using the VCC from the same snapshot,
+            so no extra VCC measurement is needed.
+    @param  telemetry
+            The sfe_power_board_telemetry_t which will hold the snapshot.
+    @return True if the snapshot was read successfully, otherwise false.
+*/
+/**************************************************************************/
+bool sfeSmolPowerBoard::getTelemetry(sfe_power_board_telemetry_t &telemetry)
+{
+  SFE_SMOL_POWER_API_SCOPE(SFE_SMOL_POWER_API_GET_TELEMETRY);
+  telemetry.temperatureCentiC = SFE_SMOL_POWER_TEMPERATURE_CENTI_C_ERROR; // Return -273.15°C and 0mV if something bad happened
+  telemetry.vccMillivolts = 0;
+  telemetry.batteryMillivolts = 0;
+#ifndef SFE_SMOL_POWER_DISABLE_FLOAT
+  telemetry.temperature = -273.15; // Return -273.15 and -99.0 if something bad happened
+  telemetry.vcc = -99.0;
+  telemetry.batteryVoltage = -99.0;
+#endif
+
+  telemetry.reference = getCachedADCVoltageReference(); // Find out which voltage reference is being used
+  if (telemetry.reference == SFE_SMOL_POWER_USE_ADC_REF_UNDEFINED)
+    return (false); // Return now if getCachedADCVoltageReference failed
+
+  bool result = false;
+  if (_burstReads)
+  {
+    // Read TEMPERATURE, VBAT and 1V1 in a single transaction
+    byte theBytes[6];
+    result = readBurst(sfe_power_board_reg_temperature_t::address, theBytes, 6);
+    if (result)
+    {
+      telemetry.rawTemperature = sfe_power_board_reg_temperature_t::decode(&theBytes[0]);
+      telemetry.rawVBAT = sfe_power_board_reg_vbat_t::decode(&theBytes[2]);
+      telemetry.raw1V1 = sfe_power_board_reg_1v1_t::decode(&theBytes[4]);
+    }
+  }
+  if (!result)
+  {
+    // Read the registers individually
+    result = readRegister<sfe_power_board_reg_temperature_t>(&telemetry.rawTemperature)
+             && readRegister<sfe_power_board_reg_vbat_t>(&telemetry.rawVBAT)
+             && readRegister<sfe_power_board_reg_1v1_t>(&telemetry.raw1V1);
+  }
+  if (!result)
+    return (false);
+
+  updateCachedRaw1V1(telemetry.raw1V1);
+  telemetry.temperatureCentiC = convertTemperatureCentiC(telemetry.rawTemperature);
+  telemetry.vccMillivolts = convertVCCMillivolts(telemetry.raw1V1);
+  telemetry.batteryMillivolts = convertBatteryMillivolts(telemetry.rawVBAT, telemetry.reference, telemetry.raw1V1);
+#ifndef SFE_SMOL_POWER_DISABLE_FLOAT
+  telemetry.temperature = convertTemperature(telemetry.rawTemperature);
+  telemetry.vcc = convertVCC(telemetry.raw1V1);
+  telemetry.batteryVoltage = convertBatteryVoltage(telemetry.rawVBAT, telemetry.reference, telemetry.raw1V1);
+#endif
+  return (true);
+}
+
+#ifdef SFE_SMOL_POWER_TRANSPORT_TWOWIRE
+/**************************************************************************/
+/*!
+    @brief  Read a telemetry snapshot from the ATtiny43U. The battery voltage is read from the fuel gauge.
+    @param  telemetry
+            The sfe_power_board_telemetry_t which will hold the snapshot.
+    @return True if the snapshot was read successfully, otherwise false.
+            False if the fuel gauge could not be read (the battery voltage reads as 0).
+*/
+/**************************************************************************/
+bool smolPowerLiPo::getTelemetry(sfe_power_board_telemetry_t &telemetry)
+{
+  bool result = sfeSmolPowerBoard::getTelemetry(telemetry);
+  telemetry.batteryMillivolts = getBatteryMillivolts();
+#ifndef SFE_SMOL_POWER_DISABLE_FLOAT
+  telemetry.batteryVoltage = ((float)telemetry.batteryMillivolts) / 1000.0;
+#endif
+  if (telemetry.batteryMillivolts == 0) // The MAX1704x library returns 0V if the read fails
+  {
+    smolPowerBoard_io.setLastError(SFE_SMOL_POWER_ERROR_SHORT_READ);
+    result = false;
+  }
+  return (result);
+}
+#endif
+
+/**************************************************************************/
+/*!
+    @brief  Read every readable ATtiny43U register for diagnostics.
+            The registers are read individually. Reading carries on after a failure, so the dump holds
+            those which could be read. The firmware version is only read if it is not already known.
+            The registers from I2C_ADDRESS to POWERDOWN_DURATION are contiguous. If burst reads have been
+            enabled with setBurstReads, they are read in a single transaction with a single ADC wait instead.
+            If the burst read fails, the registers are read individually.
+            The shadow copies, reset reason and cached VCC are updated from the dump.
+    @param  dump
+            The sfe_power_board_register_dump_t which will hold the registers.
+            dump.valid has bit (1 << register) set for each register which was read.
+    @return True if every register was read successfully, otherwise false.
+*/
+/**************************************************************************/
+bool sfeSmolPowerBoard::dumpRegisters(sfe_power_board_register_dump_t &dump)
+{
+  SFE_SMOL_POWER_API_SCOPE(SFE_SMOL_POWER_API_DUMP_REGISTERS);
+  const uint16_t allRegisters = (1 << SFE_SMOL_POWER_REGISTER_I2C_ADDRESS) | (1 << SFE_SMOL_POWER_REGISTER_RESET_REASON)
+                                | (1 << SFE_SMOL_POWER_REGISTER_TEMPERATURE) | (1 << SFE_SMOL_POWER_REGISTER_VBAT)
+                                | (1 << SFE_SMOL_POWER_REGISTER_1V1) | (1 << SFE_SMOL_POWER_REGISTER_ADC_REFERENCE)
+                                | (1 << SFE_SMOL_POWER_REGISTER_WDT_PRESCALER) | (1 << SFE_SMOL_POWER_REGISTER_POWERDOWN_DURATION)
+                                | (1 << SFE_SMOL_POWER_REGISTER_FIRMWARE_VERSION);
+  const uint16_t contiguousRegisters = allRegisters & ~(1 << SFE_SMOL_POWER_REGISTER_FIRMWARE_VERSION); // I2C_ADDRESS to POWERDOWN_DURATION
+
+  memset(&dump, 0, sizeof(sfe_power_board_register_dump_t));
+
+  if (_firmwareVersion == 0) // Do we know the firmware version?
+    getFirmwareVersion();
+  if (_firmwareVersion != 0)
+  {
+    dump.firmwareVersion = _firmwareVersion;
+    dump.valid |= 1 << SFE_SMOL_POWER_REGISTER_FIRMWARE_VERSION;
+  }
+
+  if (_burstReads)
+  {
+    // Read I2C_ADDRESS to POWERDOWN_DURATION in a single transaction
+    const byte burstLength = sfe_power_board_reg_i2c_address_t::payloadSize + sfe_power_board_reg_reset_reason_t::payloadSize
+                             + sfe_power_board_reg_temperature_t::payloadSize + sfe_power_board_reg_vbat_t::payloadSize
+                             + sfe_power_board_reg_1v1_t::payloadSize + sfe_power_board_reg_adc_reference_t::payloadSize
+                             + sfe_power_board_reg_wdt_prescaler_t::payloadSize + sfe_power_board_reg_powerdown_duration_t::payloadSize;
+    byte theBytes[burstLength];
+    if (readBurst(sfe_power_board_reg_i2c_address_t::address, theBytes, burstLength))
+    {
+      dump.i2cAddress = sfe_power_board_reg_i2c_address_t::decode(&theBytes[0]);
+      dump.resetReason = sfe_power_board_reg_reset_reason_t::decode(&theBytes[1]);
+      dump.rawTemperature = sfe_power_board_reg_temperature_t::decode(&theBytes[2]);
+      dump.rawVBAT = sfe_power_board_reg_vbat_t::decode(&theBytes[4]);
+      dump.raw1V1 = sfe_power_board_reg_1v1_t::decode(&theBytes[6]);
+      dump.adcReference = sfe_power_board_reg_adc_reference_t::decode(&theBytes[8]);
+      dump.wdtPrescaler = sfe_power_board_reg_wdt_prescaler_t::decode(&theBytes[9]);
+      dump.powerDownDuration = sfe_power_board_reg_powerdown_duration_t::decode(&theBytes[10]);
+      dump.valid |= contiguousRegisters;
+    }
+  }
+  if ((dump.valid & contiguousRegisters) != contiguousRegisters)
+  {
+    // Read the registers individually. Carry on after a failure, so the dump holds as much as possible
+    if (readRegister<sfe_power_board_reg_i2c_address_t>(&dump.i2cAddress))
+      dump.valid |= 1 << SFE_SMOL_POWER_REGISTER_I2C_ADDRESS;
+    if (readRegister<sfe_power_board_reg_reset_reason_t>(&dump.resetReason))
+      dump.valid |= 1 << SFE_SMOL_POWER_REGISTER_RESET_REASON;
+    if (readRegister<sfe_power_board_reg_temperature_t>(&dump.rawTemperature))
+      dump.valid |= 1 << SFE_SMOL_POWER_REGISTER_TEMPERATURE;
+    if (readRegister<sfe_power_board_reg_vbat_t>(&dump.rawVBAT))
+      dump.valid |= 1 << SFE_SMOL_POWER_REGISTER_VBAT;
+    if (readRegister<sfe_power_board_reg_1v1_t>(&dump.raw1V1))
+      dump.valid |= 1 << SFE_SMOL_POWER_REGISTER_1V1;
+    if (readRegister<sfe_power_board_reg_adc_reference_t>(&dump.adcReference))
+      dump.valid |= 1 << SFE_SMOL_POWER_REGISTER_ADC_REFERENCE;
+    if (readRegister<sfe_power_board_reg_wdt_prescaler_t>(&dump.wdtPrescaler))
+      dump.valid |= 1 << SFE_SMOL_POWER_REGISTER_WDT_PRESCALER;
+    if (readRegister<sfe_power_board_reg_powerdown_duration_t>(&dump.powerDownDuration))
+      dump.valid |= 1 << SFE_SMOL_POWER_REGISTER_POWERDOWN_DURATION;
+  }
+
+  // Update the reset reason first: it may invalidate the shadow copies
+  if (dump.valid & (1 << SFE_SMOL_POWER_REGISTER_RESET_REASON))
+    updateResetReason(dump.resetReason);
+  if (dump.valid & (1 << SFE_SMOL_POWER_REGISTER_I2C_ADDRESS))
+  {
+    _shadowI2CAddress = dump.i2cAddress;
+    _shadowValid |= SFE_SMOL_POWER_SHADOW_I2C_ADDRESS;
+  }
+  if ((dump.valid & (1 << SFE_SMOL_POWER_REGISTER_ADC_REFERENCE))
+      && (((sfe_power_board_ADC_ref_e)dump.adcReference == SFE_SMOL_POWER_USE_ADC_REF_VCC) || ((sfe_power_board_ADC_ref_e)dump.adcReference == SFE_SMOL_POWER_USE_ADC_REF_1V1)))
+  {
+    _shadowADCReference = (sfe_power_board_ADC_ref_e)dump.adcReference;
+    _shadowValid |= SFE_SMOL_POWER_SHADOW_ADC_REFERENCE;
+  }
+  if ((dump.valid & (1 << SFE_SMOL_POWER_REGISTER_WDT_PRESCALER)) && ((sfe_power_board_WDT_prescale_e)dump.wdtPrescaler <= SFE_SMOL_POWER_WDT_TIMEOUT_8s))
+  {
+    _shadowWDTPrescaler = (sfe_power_board_WDT_prescale_e)dump.wdtPrescaler;
+    _shadowValid |= SFE_SMOL_POWER_SHADOW_WDT_PRESCALER;
+  }
+  if (dump.valid & (1 << SFE_SMOL_POWER_REGISTER_POWERDOWN_DURATION))
+  {
+    _shadowPowerDownDuration = dump.powerDownDuration;
+    _shadowValid |= SFE_SMOL_POWER_SHADOW_POWERDOWN_DURATION;
+  }
+  if (dump.valid & (1 << SFE_SMOL_POWER_REGISTER_1V1))
+    updateCachedRaw1V1(dump.raw1V1);
+
+  return (dump.valid == allRegisters);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Pack a register dump into a compact binary record, e.g. to send over a radio link.
+            The record is SFE_SMOL_POWER_DUMP_RECORD_SIZE bytes: the record version, the registers
+            (little endian) and a CRC8. The layout is described with sfe_power_board_register_dump_t.
+            It does not depend on the host's struct layout or byte order.
+    @param  dump
+            The dump filled by dumpRegisters.
+    @param  record
+            The buffer which will hold the record.
+    @param  length
+            The size of the buffer. Must be at least SFE_SMOL_POWER_DUMP_RECORD_SIZE.
+    @return The size of the record, or 0 if length is too small.
+*/
+/**************************************************************************/
+byte sfeSmolPowerBoard::serializeRegisterDump(const sfe_power_board_register_dump_t &dump, byte *record, byte length)
+{
+  if ((record == NULL) || (length < SFE_SMOL_POWER_DUMP_RECORD_SIZE))
+    return (0);
+  record[0] = SFE_SMOL_POWER_DUMP_RECORD_VERSION;
+  record[1] = (byte)(dump.valid & 0xFF);
+  record[2] = (byte)(dump.valid >> 8);
+  record[3] = dump.i2cAddress;
+  record[4] = dump.resetReason;
+  sfe_power_board_reg_temperature_t::encode(dump.rawTemperature, &record[5]);
+  sfe_power_board_reg_vbat_t::encode(dump.rawVBAT, &record[7]);
+  sfe_power_board_reg_1v1_t::encode(dump.raw1V1, &record[9]);
+  record[11] = dump.adcReference;
+  record[12] = dump.wdtPrescaler;
+  sfe_power_board_reg_powerdown_duration_t::encode(dump.powerDownDuration, &record[13]);
+  record[15] = dump.firmwareVersion;
+  record[16] = sfeSmolPowerCRC8(record, SFE_SMOL_POWER_DUMP_RECORD_SIZE - 1);
+  return (SFE_SMOL_POWER_DUMP_RECORD_SIZE);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Unpack a record made by serializeRegisterDump, e.g. on the receiving gateway.
+    @param  record
+            The record.
+    @param  length
+            The number of bytes received.
+    @param  dump
+            The sfe_power_board_register_dump_t which will hold the registers.
+    @return True if the record is complete, has the current version and its CRC is correct.
+            dump is only changed if the record is valid.
+*/
+/**************************************************************************/
+bool sfeSmolPowerBoard::deserializeRegisterDump(const byte *record, byte length, sfe_power_board_register_dump_t &dump)
+{
+  if ((record == NULL) || (length < SFE_SMOL_POWER_DUMP_RECORD_SIZE))
+    return (false);
+  if ((record[0] != SFE_SMOL_POWER_DUMP_RECORD_VERSION)
+      || (record[16] != sfeSmolPowerCRC8(record, SFE_SMOL_POWER_DUMP_RECORD_SIZE - 1)))
+    return (false);
+  dump.valid = ((uint16_t)record[1]) | (((uint16_t)record[2]) << 8);
+  dump.i2cAddress = record[3];
+  dump.resetReason = record[4];
+  dump.rawTemperature = sfe_power_board_reg_temperature_t::decode(&record[5]);
+  dump.rawVBAT = sfe_power_board_reg_vbat_t::decode(&record[7]);
+  dump.raw1V1 = sfe_power_board_reg_1v1_t::decode(&record[9]);
+  dump.adcReference = record[11];
+  dump.wdtPrescaler = record[12];
+  dump.powerDownDuration = sfe_power_board_reg_powerdown_duration_t::decode(&record[13]);
+  dump.firmwareVersion = record[15];
+  return (true);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Read the ATtiny's internal temperature count times and calculate the statistics.
+            <br>This is much quicker than calling getTemperatureCentiC in a loop: each reading
+            is a single register read, and the readings are accumulated in constant memory.
+            The readings are accumulated as raw ADU, so the mean has a resolution of 0.01°C.
+            <br>This function blocks for approximately count * SFE_SMOL_POWER_ADC_READ_DELAY ms.
+            Any deadline in the retry policy applies to the whole batch.
+    @param  count
+            The number of readings.
+    @param  stats
+            The sfe_power_board_sample_stats_t which will hold the statistics in centi-°C.
+            If a read fails, stats holds the statistics of the readings before the failure.
+    @return True if all count readings were read successfully, otherwise false.
+*/
+/**************************************************************************/
+bool sfeSmolPowerBoard::sampleTemperature(uint16_t count, sfe_power_board_sample_stats_t &stats)
+{
+  SFE_SMOL_POWER_API_SCOPE(SFE_SMOL_POWER_API_SAMPLE_TEMPERATURE);
+  sfeSmolPowerStatistics statistics;
+  bool result = (count > 0);
+  for (uint16_t i = 0; result && (i < count); i++)
+  {
+    uint16_t rawTemp;
+    result = readRegister<sfe_power_board_reg_temperature_t>(&rawTemp);
+    if (result)
+      statistics.update(rawTemp);
+  }
+  // convertTemperatureCentiC is linear: centi-°C = (raw * 100) - (SFE_SMOL_POWER_TEMPERATURE_RAW_AT_0C * 100)
+  statistics.get(stats, 100, -(SFE_SMOL_POWER_TEMPERATURE_RAW_AT_0C * 100));
+  return (result);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Read the battery voltage (VBAT) count times and calculate the statistics.
+            <br>This is much quicker than calling getBatteryMillivolts in a loop: the ADC reference
+            is read once and, if the reference is VCC, one VCC measurement is reused for all of the readings
+            (the cached VCC is used if it is valid). The readings are accumulated in constant memory.
+            <br>This function blocks for approximately count * SFE_SMOL_POWER_ADC_READ_DELAY ms,
+            plus the VCC measurements. Any deadline in the retry policy applies to the whole batch.
+    @param  count
+            The number of readings.
+    @param  stats
+            The sfe_power_board_sample_stats_t which will hold the statistics in mV.
+            If a read fails, stats holds the statistics of the readings before the failure.
+    @param  vccInterval
+            If the reference is VCC: measure VCC again before every vccInterval readings,
+            to follow a drifting VCC. 0 (default) measures VCC once.
+    @return True if all count readings were read successfully, otherwise false.
+            False if a VCC measurement reads 0 (VCC can't be calculated).
+*/
+/**************************************************************************/
+bool smolPowerAAA::sampleBattery(uint16_t count, sfe_power_board_sample_stats_t &stats, uint16_t vccInterval)
+{
+  SFE_SMOL_POWER_API_SCOPE(SFE_SMOL_POWER_API_SAMPLE_BATTERY);
+  sfeSmolPowerStatistics statistics;
+  sfe_power_board_ADC_ref_e ref = getCachedADCVoltageReference(); // Read the reference once
+  bool result = (count > 0) && (ref != SFE_SMOL_POWER_USE_ADC_REF_UNDEFINED);
+  uint16_t raw1V1 = 0;
+  for (uint16_t i = 0; result && (i < count); i++)
+  {
+    if (ref == SFE_SMOL_POWER_USE_ADC_REF_VCC)
+    {
+      bool measureVCC = (i == 0) ? !getCachedRaw1V1(&raw1V1) : ((vccInterval > 0) && ((i % vccInterval) == 0));
+      if (measureVCC)
+      {
+        result = readRegister<sfe_power_board_reg_1v1_t>(&raw1V1);
+        if (!result)
+          break;
+        updateCachedRaw1V1(raw1V1);
+        if (raw1V1 == 0) // VCC can't be calculated: every reading would be 0mV
+        {
+          smolPowerBoard_io.setLastError(SFE_SMOL_POWER_ERROR_INVALID_VALUE);
+          result = false;
+          break;
+        }
+      }
+    }
+    uint16_t rawVBAT;
+    result = readRegister<sfe_power_board_reg_vbat_t>(&rawVBAT);
+    if (result)
+      statistics.update(convertBatteryMillivolts(rawVBAT, ref, raw1V1));
+  }
+  statistics.get(stats);
+  return (result);
+}
+
+#ifndef SFE_SMOL_POWER_DISABLE_FLOAT
+/**************************************************************************/
+/*!
+    @brief  Convert a raw TEMPERATURE ADC reading to Degrees C.
+            The sensitivity is approximately 1 LSB/°C with 25°C reading as 300 ADU.
+    @param  rawTemp
+            The raw 10-bit ADC reading.
+    @return The temperature in Degrees Centigrade / Celcius.
+*/
+/**************************************************************************/
+float sfeSmolPowerBoard::convertTemperature(uint16_t rawTemp)
+{
+  return (25.0 + ((float)rawTemp) - 300.0); // Convert to °C
+}
+
+/**************************************************************************/
+/*!
+    @brief  Convert a raw 1V1 ADC reading to VCC.
+    @param  raw1V1
+            The raw 10-bit ADC reading of the 1.1V internal reference, using VCC as the reference.
+    @return VCC in Volts or -99.0 if raw1V1 is zero.
+*/
+/**************************************************************************/
+float sfeSmolPowerBoard::convertVCC(uint16_t raw1V1)
+{
+  if (raw1V1 == 0)
+    return (-99.0);
+  float fractionFullRange = ((float)raw1V1) / 1023.0; // Convert 10-bit ADC result to the fraction of full range
+  // We know that the ADC has measured the 1.1V internal reference using VCC as the full range.
+  // Therefore we can calculate VCC from fractionFullRange.
+  // fractionFullRange = 1.1V / VCC
+  // VCC = 1.1 / fractionFullRange
+  return (1.1 / fractionFullRange);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Convert a raw VBAT ADC reading to the battery voltage.
+            The ADC has a built-in divide-by-2 circuit, so we can measure up to 2*VCC or 2.2V depending on the reference.
+    @param  rawVBAT
+            The raw 10-bit ADC reading.
+    @param  ref
+            The ADC reference used for the reading.
+    @param  raw1V1
+            The raw 1V1 ADC reading (VCC). Only used if ref is SFE_SMOL_POWER_USE_ADC_REF_VCC.
+    @return The battery voltage in Volts or -99.0 if the reference or VCC is invalid.
+*/
+/**************************************************************************/
+float sfeSmolPowerBoard::convertBatteryVoltage(uint16_t rawVBAT, sfe_power_board_ADC_ref_e ref, uint16_t raw1V1)
+{
+  float result = ((float)rawVBAT) / 1023.0; // Convert 10-bit ADC result to the fraction of full range
+  if (ref == SFE_SMOL_POWER_USE_ADC_REF_VCC) // Are we using VCC as the reference?
+  {
+    if (raw1V1 > 0)
+      return (result * 2.0 * convertVCC(raw1V1)); // Scale rawVolts to VCC
+  }
+  else if (ref == SFE_SMOL_POWER_USE_ADC_REF_1V1) // Are we using the 1.1V reference?
+  {
+    return (result * 2.0 * 1.1); // Scale rawVolts to 1.1V
+  }
+  return (-99.0);
+}
+#endif
+
+/**************************************************************************/
+/*!
+    @brief  Convert a raw TEMPERATURE ADC reading to hundredths of a Degree C using integer arithmetic.
+            Identical to convertTemperature: 25°C reads as 300 ADU, 1 LSB/°C.
+    @param  rawTemp
+            The raw 10-bit ADC reading.
+    @return The temperature in hundredths of a Degree C (centi-°C).
+*/
+/**************************************************************************/
+int32_t sfeSmolPowerBoard::convertTemperatureCentiC(uint16_t rawTemp)
+{
+  return ((((int32_t)rawTemp) - SFE_SMOL_POWER_TEMPERATURE_RAW_AT_0C) * 100);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Convert a raw 1V1 ADC reading to VCC in mV using integer arithmetic.
+            VCC = 1100mV * 1023 / raw1V1, rounded to the nearest mV.
+    @param  raw1V1
+            The raw 10-bit ADC reading of the 1.1V internal reference, using VCC as the reference.
+    @return VCC in mV or 0 if raw1V1 is zero.
+*/
+/**************************************************************************/
+uint16_t sfeSmolPowerBoard::convertVCCMillivolts(uint16_t raw1V1)
+{
+  if (raw1V1 == 0)
+    return (0);
+  uint32_t mV = (SFE_SMOL_POWER_VCC_MV_NUMERATOR + (raw1V1 >> 1)) / raw1V1; // Round to nearest
+  return ((mV > 0xFFFF) ? 0xFFFF : (uint16_t)mV); // Only possible for raw1V1 < 18 - which means VCC is way out of range
+}
+
+/**************************************************************************/
+/*!
+    @brief  Convert a raw VBAT ADC reading to the battery voltage in mV using integer arithmetic.
+            With the VCC reference, VBAT = 2 * rawVBAT / 1023 * VCC and VCC = 1100mV * 1023 / raw1V1.
+            The 1023s cancel, so VBAT = 2200mV * rawVBAT / raw1V1 with a single rounded division.
+    @param  rawVBAT
+            The raw 10-bit ADC reading.
+    @param  ref
+            The ADC reference used for the reading.
+    @param  raw1V1
+            The raw 1V1 ADC reading (VCC). Only used if ref is SFE_SMOL_POWER_USE_ADC_REF_VCC.
+    @return The battery voltage in mV or 0 if the reference or VCC is invalid.
+*/
+/**************************************************************************/
+uint16_t sfeSmolPowerBoard::convertBatteryMillivolts(uint16_t rawVBAT, sfe_power_board_ADC_ref_e ref, uint16_t raw1V1)
+{
+  uint32_t mV;
+  if (ref == SFE_SMOL_POWER_USE_ADC_REF_VCC) // Are we using VCC as the reference?
+  {
+    if (raw1V1 == 0)
+      return (0);
+    mV = ((((uint32_t)rawVBAT) * SFE_SMOL_POWER_VBAT_MV_NUMERATOR) + (raw1V1 >> 1)) / raw1V1;
+  }
+  else if (ref == SFE_SMOL_POWER_USE_ADC_REF_1V1) // Are we using the 1.1V reference?
+  {
+    mV = ((((uint32_t)rawVBAT) * SFE_SMOL_POWER_VBAT_MV_NUMERATOR) + (SFE_SMOL_POWER_ADC_FULL_SCALE >> 1)) / SFE_SMOL_POWER_ADC_FULL_SCALE;
+  }
+  else
+    return (0);
+  return ((mV > 0xFFFF) ? 0xFFFF : (uint16_t)mV);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Get the ATtiny43U's ADC voltage reference from the shadow copy.
+            The register is only read if the shadow copy is invalid.
+    @return SFE_SMOL_POWER_USE_ADC_REF_VCC or SFE_SMOL_POWER_USE_ADC_REF_1V1 if the reference is known,
+            SFE_SMOL_POWER_USE_ADC_REF_UNDEFINED if not.
+*/
+/**************************************************************************/
+sfe_power_board_ADC_ref_e sfeSmolPowerBoard::getCachedADCVoltageReference()
+{
+  if (_shadowValid & SFE_SMOL_POWER_SHADOW_ADC_REFERENCE)
+  {
+    _cacheHits++;
+    return (_shadowADCReference);
+  }
+  _cacheMisses++;
+  return (getADCVoltageReference());
+}
+
+/**************************************************************************/
+/*!
+    @brief  Get the ATtiny43U's Watchdog Timer prescaler setting from the shadow copy.
+            The register is only read if the shadow copy is invalid.
+    @return The appropriate SFE_SMOL_POWER_WDT_PRESCALE_ or SFE_SMOL_POWER_WDT_PRESCALE_UNDEFINED if communication failed.
+*/
+/**************************************************************************/
+sfe_power_board_WDT_prescale_e sfeSmolPowerBoard::getCachedWatchdogTimerPrescaler()
+{
+  if (_shadowValid & SFE_SMOL_POWER_SHADOW_WDT_PRESCALER)
+  {
+    _cacheHits++;
+    return (_shadowWDTPrescaler);
+  }
+  _cacheMisses++;
+  return (getWatchdogTimerPrescaler());
+}
+
+/**************************************************************************/
+/*!
+    @brief  Get the Power Board Power-down duration in Watchdog Timer interrupts from the shadow copy.
+            The register is only read if the shadow copy is invalid.
+    @param  duration
+            Pointer for the power-down duration.
+    @return True if the duration is known, false if not.
+*/
+/**************************************************************************/
+bool sfeSmolPowerBoard::getCachedPowerDownDurationWDTInts(uint16_t *duration)
+{
+  if (_shadowValid & SFE_SMOL_POWER_SHADOW_POWERDOWN_DURATION)
+  {
+    _cacheHits++;
+    *duration = _shadowPowerDownDuration;
+    return (true);
+  }
+  _cacheMisses++;
+  return (getPowerDownDurationWDTInts(duration));
+}
+
+/**************************************************************************/
+/*!
+    @brief  Mark the shadow copies of the registers, and the cached VCC, as invalid.
+            The next cached read will read the register from the ATtiny43U.
+            This is called automatically by getResetReason if the ATtiny43U has been reset.
+*/
+/**************************************************************************/
+void sfeSmolPowerBoard::invalidateCache()
+{
+  _shadowValid = 0;
+  _vccCacheValid = false;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Set the time-to-live of the cached VCC measurement.
+            When the ADC reference is VCC, getBatteryVoltage needs to measure VCC
+            to scale the VBAT reading. With the cache enabled, a VCC measurement
+            is reused until it is ttlMS old, saving one transaction and one ADC wait.
+    @param  ttlMS
+            The time-to-live in ms. 0 disables the cache (the default).
+*/
+/**************************************************************************/
+void sfeSmolPowerBoard::setVCCCacheTTL(unsigned long ttlMS)
+{
+  _vccCacheTTL = ttlMS;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Get the number of shadow register and VCC cache hits since the last resetCacheStatistics.
+    @return The number of cache hits.
+*/
+/**************************************************************************/
+unsigned long sfeSmolPowerBoard::getCacheHits()
+{
+  return (_cacheHits);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Get the number of shadow register and VCC cache misses since the last resetCacheStatistics.
+    @return The number of cache misses.
+*/
+/**************************************************************************/
+unsigned long sfeSmolPowerBoard::getCacheMisses()
+{
+  return (_cacheMisses);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Reset the cache hit and miss counters to zero.
+*/
+/**************************************************************************/
+void sfeSmolPowerBoard::resetCacheStatistics()
+{
+  _cacheHits = 0;
+  _cacheMisses = 0;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Get the class of the error from the most recent call.
+            Use this to tell a NACK from a short read from a corrupt value when a call fails.
+    @return SFE_SMOL_POWER_ERROR_NONE if the call succeeded, otherwise the class of the error: SFE_SMOL_POWER_ERROR_NACK_ADDRESS etc.
+*/
+/**************************************************************************/
+sfe_power_board_error_e sfeSmolPowerBoard::getLastError()
+{
+  return (smolPowerBoard_io.getLastError());
+}
+
+/**************************************************************************/
+/*!
+    @brief  Set the retry policy and deadline. These apply to every subsequent call.
+            The deadline is a hard upper bound on the duration of each public method,
+            including all retries and ADC / eeprom waits. A method which would overrun
+            the deadline fails with SFE_SMOL_POWER_ERROR_TIMEOUT.
+    @param  policy
+            The sfe_power_board_retry_policy_t holding the new policy.
+*/
+/**************************************************************************/
+void sfeSmolPowerBoard::setRetryPolicy(const sfe_power_board_retry_policy_t &policy)
+{
+  smolPowerBoard_io.setRetryPolicy(policy);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Get the retry policy and deadline.
+    @param  policy
+            The sfe_power_board_retry_policy_t which will hold a copy of the policy.
+*/
+/**************************************************************************/
+void sfeSmolPowerBoard::getRetryPolicy(sfe_power_board_retry_policy_t &policy)
+{
+  smolPowerBoard_io.getRetryPolicy(policy);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Lock the I2C bus around each transaction, when the bus is shared with other tasks.
+            On the smôl ESP32, the Power Board and the MAX17048 fuel gauge share the Wire port
+            with the other sensors. Use sfeSmolPowerFreeRTOSBusLock with a mutex which every task
+            takes before using the bus.
+            The lock is released while the ATtiny43U is converting (ADC), updating eeprom,
+            or between retries, so the other tasks can use the bus.
+            Do not share one sfeSmolPowerBoard object between tasks: use it from one task,
+            or protect it with a separate lock.
+            Call setBusLock before begin.
+    @param  busLock
+            The sfe_power_board_bus_lock_t holding the lock and unlock hooks.
+*/
+/**************************************************************************/
+void sfeSmolPowerBoard::setBusLock(const sfe_power_board_bus_lock_t &busLock)
+{
+  smolPowerBoard_io.setBusLock(busLock);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Enable or disable the adaptive ADC settle time.
+            When enabled, the temperature, VBAT and 1V1 readings are collected after the settle time
+            learned for this board, instead of always waiting SFE_SMOL_POWER_ADC_READ_DELAY.
+            If the ATtiny43U has not finished the conversion, the reading is polled until it has.
+            Repeated failures fall back to the fixed delay. Burst reads always use the fixed delay.
+            Disabling the adaptive settle time forgets the learned settle times.
+            This relies on the ATtiny43U returning a short read, or an out-of-range value, until the
+            conversion is complete. The firmware does not document this: see SparkFun_smol_Power_Board_Constants.h.
+            The Linux I2C transport cannot signal a short read, so the adaptive settle time is not available there.
+    @param  enable
+            True to learn the settle time, false to use the fixed delay.
+    @return True if the setting was applied. False if the transport cannot support the adaptive settle time.
+*/
+/**************************************************************************/
+bool sfeSmolPowerBoard::setAdaptiveADCSettle(bool enable)
+{
+  if (!enable)
+    smolPowerBoard_io.resetSettle();
+  return (smolPowerBoard_io.setAdaptiveSettle(enable));
+}
+
+/**************************************************************************/
+/*!
+    @brief  Enable or disable burst reads of consecutive registers (getTelemetry and dumpRegisters).
+            The ATtiny43U firmware is not documented to return more than the addressed register in
+            a single read, so burst reads are disabled by default. Only enable them if your firmware
+            is known to support them. If a burst read fails, the registers are read individually
+            and burst reads are disabled again, so firmware without burst support only costs one failed read.
+    @param  enable
+            True to try burst reads first, false (default) to always read the registers individually.
+*/
+/**************************************************************************/
+void sfeSmolPowerBoard::setBurstReads(bool enable)
+{
+  _burstReads = enable;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Read consecutive registers in a single transaction, waiting SFE_SMOL_POWER_ADC_BURST_READ_DELAY.
+            If the read fails, burst reads are disabled and the error is discarded: the caller reads the registers individually.
+    @param  registerAddress
+            The first register.
+    @param  buffer
+            The buffer for the payloads of the registers.
+    @param  length
+            The total number of bytes.
+    @return True if the registers were read successfully, otherwise false.
+*/
+/**************************************************************************/
+bool sfeSmolPowerBoard::readBurst(byte registerAddress, byte *buffer, byte length)
+{
+  if (!_burstReads)
+    return (false);
+  sfe_power_board_error_e previousError = smolPowerBoard_io.getLastError();
+  if (smolPowerBoard_io.readMultipleBytes(registerAddress, buffer, length, SFE_SMOL_POWER_ADC_BURST_READ_DELAY))
+    return (true);
+  smolPowerBoard_io.setLastError(previousError);
+  _burstReads = false; // The firmware may not support burst reads. Read the registers individually from now on
+  return (false);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Get the wait before the first attempt to collect a measurement.
+    @param  measurement
+            SFE_SMOL_POWER_MEASUREMENT_TEMPERATURE, _BATTERY or _VCC.
+    @return The wait in ms. SFE_SMOL_POWER_ADC_READ_DELAY if the adaptive settle time is disabled or not yet learned.
+*/
+/**************************************************************************/
+byte sfeSmolPowerBoard::getADCSettleMS(sfe_power_board_measurement_e measurement)
+{
+  byte registerAddress = SFE_SMOL_POWER_REGISTER_TEMPERATURE;
+  if (measurement == SFE_SMOL_POWER_MEASUREMENT_BATTERY)
+    registerAddress = SFE_SMOL_POWER_REGISTER_VBAT;
+  else if (measurement == SFE_SMOL_POWER_MEASUREMENT_VCC)
+    registerAddress = SFE_SMOL_POWER_REGISTER_1V1;
+  return (smolPowerBoard_io.getSettleMS(registerAddress));
+}
+
+/**************************************************************************/
+/*!
+    @brief  Record SFE_SMOL_POWER_ERROR_VERIFY_FAILED if a read-back did not match,
+            unless a communication error has already been recorded.
+    @param  matched
+            True if the read-back matched.
+    @return matched
+*/
+/**************************************************************************/
+bool sfeSmolPowerBoard::verifyWrite(bool matched)
+{
+  if ((!matched) && (smolPowerBoard_io.getLastError() == SFE_SMOL_POWER_ERROR_NONE))
+    smolPowerBoard_io.setLastError(SFE_SMOL_POWER_ERROR_VERIFY_FAILED);
+  return (matched);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Get the cached raw 1V1 reading (VCC), if the cache is enabled and the measurement has not expired.
+    @param  raw1V1
+            Pointer for the cached raw 1V1 reading.
+    @return True if the cached reading can be used, false if VCC needs to be measured.
+*/
+/**************************************************************************/
+bool sfeSmolPowerBoard::getCachedRaw1V1(uint16_t *raw1V1)
+{
+  if (_vccCacheTTL == 0)
+    return (false); // The cache is disabled
+  if (_vccCacheValid && ((millis() - _vccCacheMillis) < _vccCacheTTL))
+  {
+    _cacheHits++;
+    *raw1V1 = _raw1V1Cache;
+    return (true);
+  }
+  _cacheMisses++;
+  return (false);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Update the cached raw 1V1 reading (VCC) with a new measurement.
+            A reading of 0 is not cached (VCC can't be calculated from it): the cache is invalidated instead.
+    @param  raw1V1
+            The raw 1V1 reading.
+*/
+/**************************************************************************/
+void sfeSmolPowerBoard::updateCachedRaw1V1(uint16_t raw1V1)
+{
+  if (raw1V1 == 0)
+  {
+    _vccCacheValid = false;
+    return;
+  }
+  _raw1V1Cache = raw1V1;
+  _vccCacheMillis = millis();
+  _vccCacheValid = true;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Given an array of bytes, this calculates the CRC8 for those bytes.
+            From: http://www.sunshine2k.de/articles/coding/crc/understanding_crc.html
+            Tested with: http://www.sunshine2k.de/coding/javascript/crc/crc_js.html
+            x^8+x^5+x^4+1 = 0x31
+    @param  data
+            The array of bytes
+    @param  len
+            The length of the array of bytes
+    @return The CRC
+*/
+/**************************************************************************/
+byte sfeSmolPowerBoard::computeCRC8(byte data[], byte len)
+{
+  byte crc = 0xFF; //Init with 0xFF
+
+  for (byte x = 0; x < len; x++)
+  {
+    crc ^= data[x]; // XOR-in the next input byte
+
+    for (byte i = 0; i < 8; i++)
+    {
+      if ((crc & 0x80) != 0)
+        crc = (byte)((crc << 1) ^ 0x31);
+      else
+        crc <<= 1;
+    }
+  }
+
+  return crc; //No output reflection
+}
+
+
+#ifdef SFE_SMOL_POWER_ENABLE_BUS_STATISTICS
+/**************************************************************************/
+/*!
+    @brief  Get the bus statistics for one public method, collected since the last resetBusStatistics.
+    @param  api
+            The method: SFE_SMOL_POWER_API_BEGIN etc.
+    @param  stats
+            The sfe_power_board_bus_stats_t which will hold a copy of the statistics.
+    @return True if api is valid, false if not.
+*/
+/**************************************************************************/
+bool sfeSmolPowerBoard::getBusStatistics(sfe_power_board_api_e api, sfe_power_board_bus_stats_t &stats)
+{
+  if (api >= SFE_SMOL_POWER_API_COUNT)
+    return (false);
+  stats = _apiBusStats[api];
+  return (true);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Get the total bus statistics for all methods, collected since the last resetBusStatistics.
+    @param  stats
+            The sfe_power_board_bus_stats_t which will hold a copy of the statistics.
+*/
+/**************************************************************************/
+void sfeSmolPowerBoard::getTotalBusStatistics(sfe_power_board_bus_stats_t &stats)
+{
+  smolPowerBoard_io.getBusStatistics(stats);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Reset the bus statistics for all methods to zero.
+*/
+/**************************************************************************/
+void sfeSmolPowerBoard::resetBusStatistics()
+{
+  memset(_apiBusStats, 0, sizeof(_apiBusStats));
+  smolPowerBoard_io.resetBusStatistics();
+}
+
+/**************************************************************************/
+/*!
+    @brief  Start attributing the bus statistics to a public method.
+            If the method was called by another public method, the statistics
+            are attributed to the outer method instead.
+    @param  board
+            The board whose statistics are being attributed.
+    @param  api
+            The method: SFE_SMOL_POWER_API_BEGIN etc.
+*/
+/**************************************************************************/
+sfeSmolPowerBusStatsScope::sfeSmolPowerBusStatsScope(sfeSmolPowerBoard *board, sfe_power_board_api_e api)
+{
+  _board = board;
+  _api = api;
+  if (_board->_busStatsDepth++ == 0) // Is this the outermost method?
+    _board->smolPowerBoard_io.getBusStatistics(_start);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Add the bus statistics collected during the method to the method's totals.
+*/
+/**************************************************************************/
+sfeSmolPowerBusStatsScope::~sfeSmolPowerBusStatsScope()
+{
+  if (--_board->_busStatsDepth != 0) // Is this a nested method?
+    return;
+  sfe_power_board_bus_stats_t now;
+  _board->smolPowerBoard_io.getBusStatistics(now);
+  sfe_power_board_bus_stats_t *total = &_board->_apiBusStats[_api];
+  total->transactions += now.transactions - _start.transactions;
+  total->bytesWritten += now.bytesWritten - _start.bytesWritten;
+  total->bytesRead += now.bytesRead - _start.bytesRead;
+  total->nacks += now.nacks - _start.nacks;
+  total->shortReads += now.shortReads - _start.shortReads;
+  total->delayMS += now.delayMS - _start.delayMS;
+  total->retries += now.retries - _start.retries;
+  total->timeouts += now.timeouts - _start.timeouts;
 }
+#endif
@@ -22,11 +22,40 @@
 #ifndef __SFE_SMOL_POWER_BOARD__
 #define __SFE_SMOL_POWER_BOARD__
 
-#include <Arduino.h>
+#include "SparkFun_smol_Power_Board_Platform.h"
 
 #include "SparkFun_smol_Power_Board_Constants.h"
 #include "SparkFun_smol_Power_Board_IO.h"
+#include "SparkFun_smol_Power_Board_Registers.h"
+#ifdef SFE_SMOL_POWER_TRANSPORT_TWOWIRE
 #include <SparkFun_MAX1704x_Fuel_Gauge_Arduino_Library.h>
+#endif
+
+#ifdef SFE_SMOL_POWER_ENABLE_BUS_STATISTICS
+class sfeSmolPowerBoard;
+
+/** Attributes the bus statistics to a public sfeSmolPowerBoard method. Nested calls are attributed to the outermost method */
+class sfeSmolPowerBusStatsScope
+{
+public:
+  sfeSmolPowerBusStatsScope(sfeSmolPowerBoard *board, sfe_power_board_api_e api);
+  ~sfeSmolPowerBusStatsScope();
+
+private:
+  sfeSmolPowerBoard *_board;
+  sfe_power_board_api_e _api;
+  sfe_power_board_bus_stats_t _start;
+};
+
+#endif
+
+/** Placed at the start of each public sfeSmolPowerBoard method: starts the deadline and clears the last error
+    (for the outermost method), and attributes the bus statistics (if enabled) */
+#ifdef SFE_SMOL_POWER_ENABLE_BUS_STATISTICS
+#define SFE_SMOL_POWER_API_SCOPE(api) sfeSmolPowerIOCallScope ioCallScope(&smolPowerBoard_io); sfeSmolPowerBusStatsScope busStatsScope(this, api)
+#else
+#define SFE_SMOL_POWER_API_SCOPE(api) sfeSmolPowerIOCallScope ioCallScope(&smolPowerBoard_io)
+#endif
 
 /** Communication interface for the SparkFun smôl Power Boards */
 class sfeSmolPowerBoard
@@ -37,8 +66,15 @@ public:
   bool setI2CAddress(byte address);
   byte getI2CAddress();
   byte getResetReason();
+#ifndef SFE_SMOL_POWER_DISABLE_FLOAT
   float getTemperature();
   float measureVCC();
+#endif
+  int32_t getTemperatureCentiC(); // Temperature in hundredths of a Degree C. Integer arithmetic only
+  uint16_t measureVCCMillivolts(); // VCC in mV. Integer arithmetic only
+  bool getRawTemperature(uint16_t *raw); // Raw 10-bit ADC readings
+  bool getRawVBAT(uint16_t *raw);
+  bool getRaw1V1(uint16_t *raw);
   bool setADCVoltageReference(sfe_power_board_ADC_ref_e ref);
   sfe_power_board_ADC_ref_e getADCVoltageReference();
   bool setWatchdogTimerPrescaler(sfe_power_board_WDT_prescale_e prescaler);
@@ -46,12 +82,147 @@ public:
   bool setPowerdownDurationWDTInts(uint16_t duration);
   bool getPowerDownDurationWDTInts(uint16_t *duration);
   bool powerDownNow();
+  bool powerDownFor(unsigned long durationMS, sfe_power_board_powerdown_plan_t *plan = NULL, unsigned long toleranceMS = SFE_SMOL_POWER_POWERDOWN_TOLERANCE_AUTO); // Plan, configure (only if needed), then power down
+  bool configurePowerDown(unsigned long durationMS, sfe_power_board_powerdown_plan_t *plan = NULL, unsigned long toleranceMS = SFE_SMOL_POWER_POWERDOWN_TOLERANCE_AUTO); // As powerDownFor, but does not power down
+  static bool planPowerDown(unsigned long durationMS, sfe_power_board_powerdown_plan_t &plan, unsigned long toleranceMS = SFE_SMOL_POWER_POWERDOWN_TOLERANCE_AUTO); // Pick the prescaler and WDT interrupts with the fewest interrupts
+  static uint16_t getWDTPeriodMS(sfe_power_board_WDT_prescale_e prescaler); // The nominal Watchdog Timer period in ms. 0 if prescaler is invalid
   byte getFirmwareVersion();
+  bool getTelemetry(sfe_power_board_telemetry_t &telemetry); // Read temperature, VBAT and 1V1 in as few transactions as possible
+  void setBurstReads(bool enable); // Opt in to single-transaction reads of consecutive registers. Only if the firmware supports them
+
+  // Configuration
+  bool readConfig(sfe_power_board_config_t &config); // Read all of the configuration registers
+  byte applyConfig(const sfe_power_board_config_t &config, byte fields = SFE_SMOL_POWER_CONFIG_ALL); // Write only the changed registers, then verify. Returns the fields which failed
+
+  // Fast resume after power-down
+  bool saveResumeState(sfe_power_board_resume_t &state); // Capture the identity and configuration. Call before powering down
+  static bool isResumeStateValid(const sfe_power_board_resume_t &state); // Check the magic, version and CRC
+
+  // Register dumps for diagnostics
+  bool dumpRegisters(sfe_power_board_register_dump_t &dump); // Read every readable register in as few transactions as possible
+  static byte serializeRegisterDump(const sfe_power_board_register_dump_t &dump, byte *record, byte length); // Pack into SFE_SMOL_POWER_DUMP_RECORD_SIZE bytes. Returns the size, or 0 if length is too small
+  static bool deserializeRegisterDump(const byte *record, byte length, sfe_power_board_register_dump_t &dump); // Check the version and CRC, then unpack
+
+  // Batch statistics
+  bool sampleTemperature(uint16_t count, sfe_power_board_sample_stats_t &stats); // Read the temperature count times. Statistics in centi-°C
+
+  // Split-phase (non-blocking) ADC measurements
+  bool startTemperature(); // Start a temperature measurement. Collect the result with collect()
+  bool startMeasureVCC(); // Start a VCC measurement. Collect the result with collect()
+  bool poll(); // Service the measurement. Returns true when the result is ready to collect
+  bool isReady(); // Returns true when the result is ready to collect. Does not service the measurement
+#ifndef SFE_SMOL_POWER_DISABLE_FLOAT
+  float collect(); // Return the result and end the measurement
+#endif
+  int32_t collectFixedPoint(); // Return the result in centi-°C or mV and end the measurement
+  sfe_power_board_measurement_state_e getMeasurementState(); // Return the state of the split-phase measurement
+
+  // Shadow register and VCC caches
+  sfe_power_board_ADC_ref_e getCachedADCVoltageReference(); // Return the shadow copy of the ADC reference. Only reads the register if the copy is invalid
+  sfe_power_board_WDT_prescale_e getCachedWatchdogTimerPrescaler(); // Return the shadow copy of the WDT prescaler. Only reads the register if the copy is invalid
+  bool getCachedPowerDownDurationWDTInts(uint16_t *duration); // Return the shadow copy of the power-down duration. Only reads the register if the copy is invalid
+  void invalidateCache(); // Mark all shadow copies and the cached VCC as invalid
+  void setVCCCacheTTL(unsigned long ttlMS); // Reuse a measured VCC for this many ms when reading the battery voltage. 0 disables the cache
+  // Error classification, retries and deadline
+  sfe_power_board_error_e getLastError(); // The class of the error from the most recent call
+  void setRetryPolicy(const sfe_power_board_retry_policy_t &policy); // Retry NACKs and short reads, and limit the duration of each call
+  void getRetryPolicy(sfe_power_board_retry_policy_t &policy);
+  void setBusLock(const sfe_power_board_bus_lock_t &busLock); // Lock a bus shared with other tasks around each transaction. Released during the ADC and eeprom waits
+  // Adaptive ADC settle time
+  bool setAdaptiveADCSettle(bool enable); // Learn the ADC settle time of this board instead of always waiting SFE_SMOL_POWER_ADC_READ_DELAY. Returns false if the transport can't support it
+  byte getADCSettleMS(sfe_power_board_measurement_e measurement); // The wait (ms) before the first attempt to read the measurement
+
+  unsigned long getCacheHits();
+  unsigned long getCacheMisses();
+  void resetCacheStatistics();
+
+#ifdef SFE_SMOL_POWER_ENABLE_BUS_STATISTICS
+  // Bus statistics
+  bool getBusStatistics(sfe_power_board_api_e api, sfe_power_board_bus_stats_t &stats); // Snapshot the statistics for one method
+  void getTotalBusStatistics(sfe_power_board_bus_stats_t &stats); // Snapshot the statistics for all methods
+  void resetBusStatistics();
+#endif
 
   // I2C communication object instance
   SMOL_POWER_BOARD_IO smolPowerBoard_io;
   
   byte computeCRC8(byte data[], byte len);
+
+protected:
+  bool waitForMeasurement(); // Block until the split-phase measurement is complete
+  bool verifyWrite(bool matched); // Record SFE_SMOL_POWER_ERROR_VERIFY_FAILED if a read-back did not match
+  bool resumeBoard(const sfe_power_board_resume_t &state, byte *resetReason); // Restore the state and check the board: two register reads instead of the begin handshake
+
+  /** Write a register using its descriptor: add the CRC (if needed), then wait for the eeprom (if needed) */
+  template <typename Register>
+  bool writeRegister(typename Register::payload_t value)
+  {
+    byte frame[Register::frameSize];
+    Register::encode(value, frame);
+    if (Register::crcProtected)
+      frame[Register::frameSize - 1] = computeCRC8(frame, Register::payloadSize);
+    bool result = smolPowerBoard_io.writeMultipleBytes(Register::address, frame, Register::frameSize);
+    if (result)
+      smolPowerBoard_io.delayMS(Register::writeDelay); // Wait for the eeprom to be updated
+    return (result);
+  }
+
+  /** Read a register using its descriptor: wait for the ADC (if needed) */
+  template <typename Register>
+  bool readRegister(typename Register::payload_t *value)
+  {
+    byte buffer[Register::payloadSize];
+    bool result = smolPowerBoard_io.readMultipleBytes(Register::address, buffer, Register::payloadSize, Register::readDelay);
+    if (result)
+      *value = Register::decode(buffer);
+    return (result);
+  }
+
+  // Convert the raw ADC readings
+#ifndef SFE_SMOL_POWER_DISABLE_FLOAT
+  static float convertTemperature(uint16_t rawTemp);
+  static float convertVCC(uint16_t raw1V1);
+  static float convertBatteryVoltage(uint16_t rawVBAT, sfe_power_board_ADC_ref_e ref, uint16_t raw1V1);
+#endif
+  static int32_t convertTemperatureCentiC(uint16_t rawTemp);
+  static uint16_t convertVCCMillivolts(uint16_t raw1V1);
+  static uint16_t convertBatteryMillivolts(uint16_t rawVBAT, sfe_power_board_ADC_ref_e ref, uint16_t raw1V1);
+
+  byte _firmwareVersion = 0; // Updated by getFirmwareVersion. 0 if unknown
+  byte _resetReason = SFE_SMOL_POWER_COMM_ERROR; // Updated by getResetReason. SFE_SMOL_POWER_COMM_ERROR if unknown
+  void updateResetReason(byte reason); // Invalidate the shadow copies if the reason has changed
+  bool readBurst(byte registerAddress, byte *buffer, byte length); // Read consecutive registers if burst reads are enabled
+  bool _burstReads = false; // Set by setBurstReads. Cleared if a burst read fails
+
+  sfe_power_board_measurement_e _measurement = SFE_SMOL_POWER_MEASUREMENT_NONE;
+  sfe_power_board_measurement_state_e _measurementState = SFE_SMOL_POWER_MEASUREMENT_IDLE;
+  sfe_power_board_ADC_ref_e _measurementReference = SFE_SMOL_POWER_USE_ADC_REF_UNDEFINED;
+  uint16_t _rawResult; // The raw ADC reading. Converted by collect. (The fuel gauge result is held in mV)
+  uint16_t _raw1V1; // Battery voltage: the raw 1V1 reading used to scale VBAT when using the VCC reference
+
+  // Shadow copies of the configuration registers, updated on every successful set/get
+  byte _shadowValid = 0; // Logical OR of SFE_SMOL_POWER_SHADOW_ flags
+  byte _shadowI2CAddress;
+  sfe_power_board_ADC_ref_e _shadowADCReference;
+  sfe_power_board_WDT_prescale_e _shadowWDTPrescaler;
+  uint16_t _shadowPowerDownDuration;
+
+  // Time-to-live cache for the measured VCC (the raw 1V1 reading)
+  bool getCachedRaw1V1(uint16_t *raw1V1);
+  void updateCachedRaw1V1(uint16_t raw1V1);
+  unsigned long _vccCacheTTL = 0; // Disabled by default
+  unsigned long _vccCacheMillis;
+  uint16_t _raw1V1Cache;
+  bool _vccCacheValid = false;
+
+  unsigned long _cacheHits = 0;
+  unsigned long _cacheMisses = 0;
+
+#ifdef SFE_SMOL_POWER_ENABLE_BUS_STATISTICS
+  friend class sfeSmolPowerBusStatsScope;
+  sfe_power_board_bus_stats_t _apiBusStats[SFE_SMOL_POWER_API_COUNT] = {};
+  byte _busStatsDepth = 0;
+#endif
 };
 
 /** Communication interface for the SparkFun smôl Power Board AAA */
@@ -61,24 +232,83 @@ public:
   /** @brief Create an object to communicate with the SparkFun smôl Power Board AAA */
   smolPowerAAA() {}
 
-  bool begin(byte deviceAddress = SFE_SMOL_POWER_DEFAULT_I2C_ADDRESS, TwoWire &wirePort = Wire);
+#ifdef SFE_SMOL_POWER_DEFAULT_PORT
+  bool begin(byte deviceAddress = SFE_SMOL_POWER_DEFAULT_I2C_ADDRESS, sfe_power_board_port_t &port = SFE_SMOL_POWER_DEFAULT_PORT);
+#else
+  bool begin(byte deviceAddress, sfe_power_board_port_t &port); // There is no default port for the mock and Linux transports
+#endif
+#ifdef SFE_SMOL_POWER_DEFAULT_PORT
+  bool resume(const sfe_power_board_resume_t &state, sfe_power_board_port_t &port = SFE_SMOL_POWER_DEFAULT_PORT, byte *resetReason = NULL); // Use instead of begin after waking from power-down
+#else
+  bool resume(const sfe_power_board_resume_t &state, sfe_power_board_port_t &port, byte *resetReason = NULL); // Use instead of begin after waking from power-down
+#endif
+#ifndef SFE_SMOL_POWER_DISABLE_FLOAT
   float getBatteryVoltage(); // Measure the battery voltage via the ATtiny43U ADC
+#endif
+  uint16_t getBatteryMillivolts(); // Measure the battery voltage in mV via the ATtiny43U ADC. Integer arithmetic only
+  bool startBatteryVoltage(); // Start a battery voltage measurement. Collect the result with collect()
+  bool sampleBattery(uint16_t count, sfe_power_board_sample_stats_t &stats, uint16_t vccInterval = 0); // Read the battery voltage count times. Statistics in mV
 
 };
 
+#ifdef SFE_SMOL_POWER_TRANSPORT_TWOWIRE // The MAX1704x library needs TwoWire
 /** Communication interface for the SparkFun smôl Power Board LiPo */
 class smolPowerLiPo : public sfeSmolPowerBoard
 {
 public:
   /** @brief Create an object to communicate with the SparkFun smôl Power Board LiPo */
   smolPowerLiPo() {}
+  /** @brief Release the alert interrupt, if this object owns it */
+  ~smolPowerLiPo() { detachAlertInterrupt(); }
 
   bool begin(byte deviceAddress = SFE_SMOL_POWER_DEFAULT_I2C_ADDRESS, TwoWire &wirePort = Wire);
+  bool resume(const sfe_power_board_resume_t &state, TwoWire &wirePort = Wire, byte *resetReason = NULL); // Use instead of begin after waking from power-down
+#ifndef SFE_SMOL_POWER_DISABLE_FLOAT
   float getBatteryVoltage(); // Measure the battery voltage via the MAX17048 fuel gauge
+#endif
+  uint16_t getBatteryMillivolts(); // Measure the battery voltage in mV via the MAX17048 fuel gauge
+  bool getTelemetry(sfe_power_board_telemetry_t &telemetry); // As sfeSmolPowerBoard::getTelemetry, but the battery voltage is read from the fuel gauge
+  bool startBatteryVoltage(); // Read the battery voltage from the fuel gauge. Collect the result with collect()
+
+  // MAX17048 state of charge and change rate
+#ifndef SFE_SMOL_POWER_DISABLE_FLOAT
+  float getSOC(); // The state of charge in %
+  float getChangeRate(); // The rate of change of the state of charge in %/hr. Negative while discharging
+#endif
+  uint16_t getSOCCentiPercent(); // The state of charge in 0.01%
+  int32_t getChangeRateCentiPercentPerHour(); // The rate of change of the state of charge in 0.01%/hr
+
+  // MAX17048 alert configuration
+  bool setEmptyAlertThreshold(byte percent); // Raise SFE_SMOL_POWER_ALERT_SOC_LOW when the state of charge falls below percent (1-32)
+  byte getEmptyAlertThreshold(); // The empty alert threshold in %
+  bool setVoltageAlertThresholds(uint16_t minMillivolts, uint16_t maxMillivolts); // Raise _VOLTAGE_LOW / _VOLTAGE_HIGH outside this window. 20mV resolution
+  bool enableSOCChangeAlert(bool enable = true); // Raise SFE_SMOL_POWER_ALERT_SOC_CHANGE each time the state of charge changes by 1%
+  byte getAlerts(); // Read the SFE_SMOL_POWER_ALERT_ flags which are set
+  bool clearAlerts(byte alerts = SFE_SMOL_POWER_ALERT_ALL); // Clear the alert flags and release the ALRT pin
+  bool sleepFuelGauge(); // Put the MAX17048 into hibernate
+  bool wakeFuelGauge();
+  bool isFuelGaugeConnected(); // True if the MAX17048 acknowledges. Tells a failed read (0) from a true 0
+  SFE_MAX1704X &getFuelGauge(); // Direct access to the MAX17048 for anything not wrapped here
+
+  // Interrupt-driven alerts: the gauge pulls ALRT low. No I2C traffic until it does
+  // Only one smolPowerLiPo can own the alert interrupt at a time: attachAlertInterrupt fails while another object owns it
+  bool attachAlertInterrupt(int pin, void (*callback)() = nullptr); // Pin must be interrupt-capable and connected to the MAX17048 ALRT pin
+  void detachAlertInterrupt(); // Releases the alert interrupt, if this object owns it
+  bool isAlertPending(); // True if ALRT has fallen since the alerts were last serviced. No I2C traffic
+  byte serviceAlerts(); // If ALRT has fallen: read and clear the alerts. Returns the SFE_SMOL_POWER_ALERT_ flags, or 0 (no I2C traffic) if there is no alert
 
 private:
   // MAX17048 fuel gauge instance
   SFE_MAX1704X powerBoardFuelGauge = SFE_MAX1704X(MAX1704X_MAX17048);
+
+  // The ALRT interrupt. attachInterrupt takes a plain function, so the state is shared by all smolPowerLiPo objects.
+  // _alertOwner records which object attached it
+  static void alertISR();
+  static smolPowerLiPo *_alertOwner;
+  static volatile bool _alertPending;
+  static void (*_alertCallback)();
+  int _alertPin = -1;
 };
+#endif
 
 #endif // /__SFE_SMOL_POWER_BOARD__
@@ -31,13 +31,88 @@
 
 #endif
 
+//The transport is selected at compile time, so calls are dispatched statically (no virtual calls).
+//By default, Arduino builds use TwoWire. Define one of these (here or on the compiler command line) to use a different transport:
+//SFE_SMOL_POWER_TRANSPORT_MOCK: an in-memory simulation of the ATtiny43U. Tests the whole library on any host
+//SFE_SMOL_POWER_TRANSPORT_LINUX: Linux /dev/i2c-* using the I2C_RDWR ioctl
+//smolPowerLiPo is only available with TwoWire: the MAX1704x library talks to the fuel gauge using TwoWire
+//#define SFE_SMOL_POWER_TRANSPORT_MOCK
+//#define SFE_SMOL_POWER_TRANSPORT_LINUX
+
+#if !defined(SFE_SMOL_POWER_TRANSPORT_MOCK) && !defined(SFE_SMOL_POWER_TRANSPORT_LINUX)
+#if defined(ARDUINO)
+#define SFE_SMOL_POWER_TRANSPORT_TWOWIRE
+#else
+#error "Please define SFE_SMOL_POWER_TRANSPORT_MOCK or SFE_SMOL_POWER_TRANSPORT_LINUX: TwoWire is only available on Arduino"
+#endif
+#endif
+
+//The simulated ATtiny43U (sfeSmolPowerMockBoard) is included by the mock transport. Define SFE_SMOL_POWER_MOCK_BOARD to include it
+//with another transport, e.g. behind a host TwoWire stand-in (see extras/test)
+#if defined(SFE_SMOL_POWER_TRANSPORT_MOCK) && !defined(SFE_SMOL_POWER_MOCK_BOARD)
+#define SFE_SMOL_POWER_MOCK_BOARD
+#endif
+
 #define SFE_SMOL_POWER_DEFAULT_I2C_ADDRESS 0x50
 
+//Uncomment the next line to enable the bus statistics (transactions, bytes, NACKs, short reads, delay time)
+//The statistics are attributed to each public sfeSmolPowerBoard method. They cost nothing when disabled.
+//#define SFE_SMOL_POWER_ENABLE_BUS_STATISTICS
+
+//Uncomment the next line to compile out the float API (getTemperature, measureVCC, getBatteryVoltage, collect etc.)
+//Use the integer API instead (getTemperatureCentiC, measureVCCMillivolts, getBatteryMillivolts, collectFixedPoint etc.)
+//This avoids pulling in the soft-float library on platforms without an FPU.
+//#define SFE_SMOL_POWER_DISABLE_FLOAT
+
 //-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
 
 /** delay durations for the ADC read and eeprom update */
 #define SFE_SMOL_POWER_ADC_READ_DELAY              15 ///< The ADC read (eight samples, averaged) takes ~11ms to complete at 4MHz. 15ms provides margin.
 #define SFE_SMOL_POWER_EEPROM_UPDATE_DELAY         6  ///< The eeprom update takes ~4ms to complete at 4MHz. 6ms provides margin.
+#define SFE_SMOL_POWER_ADC_BURST_READ_DELAY        38 ///< A burst read (see setBurstReads) of TEMPERATURE, VBAT and 1V1 needs three ADC reads (~33ms at 4MHz). 38ms provides margin.
+
+/** The default retry policy: no retries and no deadline, so each call behaves as it always has */
+#define SFE_SMOL_POWER_DEFAULT_RETRIES             0  ///< The number of retries after a NACK, bus error or short read
+#define SFE_SMOL_POWER_DEFAULT_RETRY_DELAY         2  ///< The delay (ms) before each retry. The ATtiny43U NACKs while it wakes or updates eeprom
+#define SFE_SMOL_POWER_DEFAULT_DEADLINE            0  ///< The maximum duration (ms) of each call. 0 disables the deadline
+
+/** planPowerDown accepts a plan if the rounding error is within this tolerance. By default the tolerance is target / 32 (~3%),
+    well within the accuracy of the ATtiny43U's Watchdog Timer oscillator */
+#define SFE_SMOL_POWER_POWERDOWN_TOLERANCE_AUTO    0xFFFFFFFF ///< Use the default tolerance: target / 32
+#define SFE_SMOL_POWER_POWERDOWN_TOLERANCE_SHIFT   5          ///< The default tolerance is target >> SFE_SMOL_POWER_POWERDOWN_TOLERANCE_SHIFT
+
+/** Adaptive ADC settle time. When enabled, single-register ADC reads (TEMPERATURE, VBAT, 1V1) start with a shorter wait,
+    poll until the ATtiny43U returns a valid result, and learn the settle time for each register.
+    This relies on an assumption which the ATtiny43U firmware does not document: until the conversion is complete,
+    a read returns fewer bytes than requested, or a value with bits set above the 10-bit ADC result (0xFF padding).
+    If the firmware instead returns the previous result, that stale result passes the check, so leave the adaptive
+    settle time disabled with such firmware. Transports which cannot return a short read (signalsNotReady is false,
+    e.g. the Linux I2C bus) never adapt. */
+#define SFE_SMOL_POWER_ADC_ADAPTIVE_INITIAL_WAIT   11 ///< The first wait (ms) before the settle time has been learned: the typical conversion time
+#define SFE_SMOL_POWER_ADC_ADAPTIVE_MARGIN         1  ///< The safety margin (ms) added to the learned settle time
+#define SFE_SMOL_POWER_ADC_ADAPTIVE_PROBE          2  ///< A result which was ready on the first attempt is learned as this many ms earlier, so the wait keeps tracking the real conversion time
+#define SFE_SMOL_POWER_ADC_ADAPTIVE_POLL_INTERVAL  1  ///< The interval (ms) between polls while the conversion is not yet complete
+#define SFE_SMOL_POWER_ADC_ADAPTIVE_MAX_ERRORS     3  ///< After this many reads fail to settle within SFE_SMOL_POWER_ADC_READ_DELAY, fall back to the fixed delay
+#define SFE_SMOL_POWER_ADC_ADAPTIVE_BACKOFF        16 ///< The number of reads which use the fixed delay before adapting again
+#define SFE_SMOL_POWER_ADC_ADAPTIVE_REGISTERS      3  ///< The number of adaptive registers: TEMPERATURE, VBAT and 1V1
+
+/** MAX17048 fuel gauge alerts (smolPowerLiPo). These match the bits of the MAX17048 STATUS register */
+#define SFE_SMOL_POWER_ALERT_RESET          0x01 ///< RI: the fuel gauge has reset and needs to be configured
+#define SFE_SMOL_POWER_ALERT_VOLTAGE_HIGH   0x02 ///< VH: the battery voltage is above the VALRT.MAX threshold
+#define SFE_SMOL_POWER_ALERT_VOLTAGE_LOW    0x04 ///< VL: the battery voltage is below the VALRT.MIN threshold
+#define SFE_SMOL_POWER_ALERT_VOLTAGE_RESET  0x08 ///< VR: the battery voltage has fallen below the reset threshold
+#define SFE_SMOL_POWER_ALERT_SOC_LOW        0x10 ///< HD: the state of charge is below the empty alert threshold
+#define SFE_SMOL_POWER_ALERT_SOC_CHANGE     0x20 ///< SC: the state of charge has changed by 1%
+#define SFE_SMOL_POWER_ALERT_ALL            0x3F ///< All of the alerts
+#define SFE_SMOL_POWER_VALRT_MV_PER_LSB     20   ///< The resolution of the MAX17048 VALRT thresholds in mV
+
+/** Fixed-point scale factors for the integer conversions. These give the same results as the float conversions, rounded to the nearest LSB */
+#define SFE_SMOL_POWER_ADC_FULL_SCALE              1023UL                                             ///< The full scale of the 10-bit ADC
+#define SFE_SMOL_POWER_1V1_MILLIVOLTS              1100UL                                             ///< The ATtiny43U's internal 1.1V reference in mV
+#define SFE_SMOL_POWER_VCC_MV_NUMERATOR            (SFE_SMOL_POWER_1V1_MILLIVOLTS * SFE_SMOL_POWER_ADC_FULL_SCALE) ///< VCC (mV) = SFE_SMOL_POWER_VCC_MV_NUMERATOR / raw1V1
+#define SFE_SMOL_POWER_VBAT_MV_NUMERATOR           (2UL * SFE_SMOL_POWER_1V1_MILLIVOLTS)              ///< VBAT has a divide-by-2. VBAT (mV) = rawVBAT * 2200 / 1023 (1.1V ref) or rawVBAT * 2200 / raw1V1 (VCC ref)
+#define SFE_SMOL_POWER_TEMPERATURE_RAW_AT_0C       275                                                ///< The raw TEMPERATURE reading at 0°C (25°C reads as 300 ADU, 1 LSB/°C)
+#define SFE_SMOL_POWER_TEMPERATURE_CENTI_C_ERROR   (-27315)                                           ///< getTemperatureCentiC returns -273.15°C if an error occurred
 
 
 //-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
@@ -58,6 +133,24 @@
 
 //-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
 
+/** sfeSmolPowerBoard keeps shadow copies of the configuration registers. These flags indicate which copies are valid */
+#define SFE_SMOL_POWER_SHADOW_I2C_ADDRESS          (1 << 0)                                           ///< The shadow copy of the I2C address is valid
+#define SFE_SMOL_POWER_SHADOW_ADC_REFERENCE        (1 << 1)                                           ///< The shadow copy of the ADC reference is valid
+#define SFE_SMOL_POWER_SHADOW_WDT_PRESCALER        (1 << 2)                                           ///< The shadow copy of the WDT prescaler is valid
+#define SFE_SMOL_POWER_SHADOW_POWERDOWN_DURATION   (1 << 3)                                           ///< The shadow copy of the power-down duration is valid
+
+/** applyConfig applies, and reports failures for, these configuration fields */
+#define SFE_SMOL_POWER_CONFIG_I2C_ADDRESS          SFE_SMOL_POWER_SHADOW_I2C_ADDRESS                  ///< sfe_power_board_config_t i2cAddress
+#define SFE_SMOL_POWER_CONFIG_ADC_REFERENCE        SFE_SMOL_POWER_SHADOW_ADC_REFERENCE                ///< sfe_power_board_config_t adcReference
+#define SFE_SMOL_POWER_CONFIG_WDT_PRESCALER        SFE_SMOL_POWER_SHADOW_WDT_PRESCALER                ///< sfe_power_board_config_t wdtPrescaler
+#define SFE_SMOL_POWER_CONFIG_POWERDOWN_DURATION   SFE_SMOL_POWER_SHADOW_POWERDOWN_DURATION           ///< sfe_power_board_config_t powerDownDuration
+#define SFE_SMOL_POWER_CONFIG_ALL                  (SFE_SMOL_POWER_CONFIG_I2C_ADDRESS | SFE_SMOL_POWER_CONFIG_ADC_REFERENCE | SFE_SMOL_POWER_CONFIG_WDT_PRESCALER | SFE_SMOL_POWER_CONFIG_POWERDOWN_DURATION) ///< All of the configuration fields
+
+/** Any of these reset reason flags indicate that the ATtiny43U may have restarted with different settings */
+#define SFE_SMOL_POWER_RESET_REASON_INVALIDATES_SHADOW (SFE_SMOL_POWER_RESET_REASON_PORF | SFE_SMOL_POWER_RESET_REASON_EXTRF | SFE_SMOL_POWER_RESET_REASON_BORF | SFE_SMOL_POWER_RESET_REASON_WDRF | SFE_SMOL_POWER_EEPROM_CORRUPT_ON_RESET)
+
+//-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
 /** The addresses of the registers within the ATtiny43U's memory */
 typedef enum 
 {
@@ -97,4 +190,311 @@ typedef enum
   SFE_SMOL_POWER_WDT_TIMEOUT_UNDEFINED   //Something bad has happened...
 } sfe_power_board_WDT_prescale_e;
 
+/** A telemetry snapshot from the contiguous TEMPERATURE, VBAT and 1V1 registers. Filled by getTelemetry */
+typedef struct
+{
+  uint16_t rawTemperature;             //The raw 10-bit ADC reading from SFE_SMOL_POWER_REGISTER_TEMPERATURE
+  uint16_t rawVBAT;                    //The raw 10-bit ADC reading from SFE_SMOL_POWER_REGISTER_VBAT
+  uint16_t raw1V1;                     //The raw 10-bit ADC reading from SFE_SMOL_POWER_REGISTER_1V1
+  sfe_power_board_ADC_ref_e reference; //The ADC reference used for rawVBAT
+  int32_t temperatureCentiC;           //The temperature in hundredths of a Degree C
+  uint16_t vccMillivolts;              //VCC in mV, derived from raw1V1
+  uint16_t batteryMillivolts;          //The battery voltage in mV
+#ifndef SFE_SMOL_POWER_DISABLE_FLOAT
+  float temperature;                   //The temperature in Degrees C
+  float vcc;                           //VCC in Volts, derived from raw1V1
+  float batteryVoltage;                //The battery voltage in Volts
+#endif
+} sfe_power_board_telemetry_t;
+
+/** Bus statistics collected by SMOL_POWER_BOARD_IO when SFE_SMOL_POWER_ENABLE_BUS_STATISTICS is defined */
+typedef struct
+{
+  unsigned long transactions;          //The number of I2C transactions (START to STOP). A register read is two: write the address, then read the data
+  unsigned long bytesWritten;          //The number of bytes written, including register addresses
+  unsigned long bytesRead;             //The number of bytes read
+  unsigned long nacks;                 //The number of writes which were not acknowledged (endTransmission returned non-zero)
+  unsigned long shortReads;            //The number of reads which returned fewer bytes than requested
+  unsigned long delayMS;               //The total time spent in delay() waiting for the ATtiny43U, in ms
+  unsigned long retries;               //The number of transactions which were retried
+  unsigned long timeouts;              //The number of calls which failed because the deadline expired
+} sfe_power_board_bus_stats_t;
+
+/** The learned ADC settle time for one register */
+typedef struct
+{
+  uint16_t settle16;                   //The EWMA of the settle time in 1/16 ms. 0 if not yet learned
+  byte errors;                         //Recent reads which did not settle within SFE_SMOL_POWER_ADC_READ_DELAY
+  byte backoff;                        //The number of reads remaining which will use the fixed delay
+} sfe_power_board_adc_settle_t;
+
+/** The class of the error from the most recent call. Returned by getLastError */
+typedef enum 
+{
+  SFE_SMOL_POWER_ERROR_NONE = 0,       //No error
+  SFE_SMOL_POWER_ERROR_NACK_ADDRESS,   //The I2C address was not acknowledged (endTransmission returned 2). The ATtiny43U may be asleep or busy
+  SFE_SMOL_POWER_ERROR_NACK_DATA,      //The data was not acknowledged (endTransmission returned 3)
+  SFE_SMOL_POWER_ERROR_BUS,            //Some other I2C error (endTransmission returned 1, 4 or 5)
+  SFE_SMOL_POWER_ERROR_SHORT_READ,     //Fewer bytes were returned than requested
+  SFE_SMOL_POWER_ERROR_INVALID_VALUE,  //The value read was out of range or corrupt
+  SFE_SMOL_POWER_ERROR_VERIFY_FAILED,  //The value read back after a write did not match
+  SFE_SMOL_POWER_ERROR_TIMEOUT         //The deadline expired before the call could complete
+} sfe_power_board_error_e;
+
+/** How the I2C transactions are retried, and the maximum duration of each call */
+typedef struct
+{
+  byte retries;                        //The number of retries after a NACK, bus error or short read. 0 disables retries
+  byte retryDelayMS;                   //The delay before each retry, in ms
+  unsigned long deadlineMS;            //The maximum duration of each call in ms, including retries and the ADC / eeprom waits. 0 disables the deadline
+} sfe_power_board_retry_policy_t;
+
+/** The public sfeSmolPowerBoard methods. Used to attribute the bus statistics */
+typedef enum 
+{
+  SFE_SMOL_POWER_API_BEGIN = 0,
+  SFE_SMOL_POWER_API_IS_CONNECTED,
+  SFE_SMOL_POWER_API_SET_I2C_ADDRESS,
+  SFE_SMOL_POWER_API_GET_I2C_ADDRESS,
+  SFE_SMOL_POWER_API_GET_RESET_REASON,
+  SFE_SMOL_POWER_API_GET_TEMPERATURE,
+  SFE_SMOL_POWER_API_MEASURE_VCC,
+  SFE_SMOL_POWER_API_GET_BATTERY_VOLTAGE,
+  SFE_SMOL_POWER_API_SET_ADC_REFERENCE,
+  SFE_SMOL_POWER_API_GET_ADC_REFERENCE,
+  SFE_SMOL_POWER_API_SET_WDT_PRESCALER,
+  SFE_SMOL_POWER_API_GET_WDT_PRESCALER,
+  SFE_SMOL_POWER_API_SET_POWERDOWN_DURATION,
+  SFE_SMOL_POWER_API_GET_POWERDOWN_DURATION,
+  SFE_SMOL_POWER_API_POWER_DOWN_NOW,
+  SFE_SMOL_POWER_API_GET_FIRMWARE_VERSION,
+  SFE_SMOL_POWER_API_GET_TELEMETRY,
+  SFE_SMOL_POWER_API_START_MEASUREMENT,  //startTemperature, startMeasureVCC, startBatteryVoltage
+  SFE_SMOL_POWER_API_POLL,
+  SFE_SMOL_POWER_API_POWER_DOWN_FOR,
+  SFE_SMOL_POWER_API_READ_CONFIG,
+  SFE_SMOL_POWER_API_APPLY_CONFIG,
+  SFE_SMOL_POWER_API_RESUME,
+  SFE_SMOL_POWER_API_DUMP_REGISTERS,
+  SFE_SMOL_POWER_API_SAMPLE_BATTERY,
+  SFE_SMOL_POWER_API_SAMPLE_TEMPERATURE,
+  SFE_SMOL_POWER_API_COUNT               //The number of methods. Not a method...
+} sfe_power_board_api_e;
+
+/** The measurements which can be performed using the split-phase (non-blocking) ADC API */
+typedef enum 
+{
+  SFE_SMOL_POWER_MEASUREMENT_NONE = 0,      //No measurement has been started
+  SFE_SMOL_POWER_MEASUREMENT_TEMPERATURE,   //startTemperature
+  SFE_SMOL_POWER_MEASUREMENT_VCC,           //startMeasureVCC
+  SFE_SMOL_POWER_MEASUREMENT_BATTERY,       //startBatteryVoltage (AAA)
+  SFE_SMOL_POWER_MEASUREMENT_FUEL_GAUGE     //startBatteryVoltage (LiPo). The result is already in mV
+} sfe_power_board_measurement_e;
+
+/** The result of a single attempt to complete a split-phase read. Returned by SMOL_POWER_BOARD_IO::pollRead */
+typedef enum 
+{
+  SFE_SMOL_POWER_READ_PENDING = 0,          //The data is not ready yet, or a retry is scheduled. Call pollRead again later
+  SFE_SMOL_POWER_READ_COMPLETE,             //The data was read successfully
+  SFE_SMOL_POWER_READ_FAILED                //The read failed, or no read is pending
+} sfe_power_board_read_status_e;
+
+/** The state of the split-phase (non-blocking) ADC measurement */
+typedef enum 
+{
+  SFE_SMOL_POWER_MEASUREMENT_IDLE = 0,      //No measurement in progress
+  SFE_SMOL_POWER_MEASUREMENT_WAITING,       //Waiting for the ATtiny43U to complete the ADC conversion
+  SFE_SMOL_POWER_MEASUREMENT_WAITING_VCC,   //Battery voltage: waiting for the VCC measurement needed to scale VBAT
+  SFE_SMOL_POWER_MEASUREMENT_COMPLETE,      //The result is ready to be collected
+  SFE_SMOL_POWER_MEASUREMENT_FAILED         //Something bad has happened...
+} sfe_power_board_measurement_state_e;
+
+/** The ATtiny43U's configuration registers. Read with readConfig, written with applyConfig */
+typedef struct
+{
+  byte i2cAddress;                     //The I2C address
+  sfe_power_board_ADC_ref_e adcReference; //The ADC reference for VBAT
+  sfe_power_board_WDT_prescale_e wdtPrescaler; //The Watchdog Timer prescaler
+  uint16_t powerDownDuration;          //The power-down duration in WDT interrupts
+} sfe_power_board_config_t;
+
+/** A power-down plan: the prescaler and number of WDT interrupts which best achieve a target duration. Filled by planPowerDown */
+typedef struct
+{
+  sfe_power_board_WDT_prescale_e prescaler; //The Watchdog Timer prescaler
+  uint16_t wdtInts;                    //The power-down duration in WDT interrupts
+  unsigned long durationMS;            //The achieved duration in ms: wdtInts * the nominal WDT period
+  long errorMS;                        //The rounding error in ms: durationMS - the target duration
+} sfe_power_board_powerdown_plan_t;
+
+/** Telemetry history (sfeSmolPowerHistory) */
+#define SFE_SMOL_POWER_HISTORY_ESCAPE       (-128)     ///< The temperature delta which marks a sample held in full (its deltas do not fit in 4 bytes)
+
+/** The channels stored by sfeSmolPowerHistory */
+typedef enum 
+{
+  SFE_SMOL_POWER_HISTORY_TEMPERATURE = 0,   //The raw 10-bit ADC reading from SFE_SMOL_POWER_REGISTER_TEMPERATURE
+  SFE_SMOL_POWER_HISTORY_VBAT               //The raw 10-bit ADC reading from SFE_SMOL_POWER_REGISTER_VBAT
+} sfe_power_board_history_channel_e;
+
+/** One decoded sfeSmolPowerHistory sample */
+typedef struct
+{
+  unsigned long millis;                //millis() when the sample was taken (to the nearest history time unit)
+  uint16_t rawTemperature;             //The raw 10-bit ADC reading from SFE_SMOL_POWER_REGISTER_TEMPERATURE
+  uint16_t rawVBAT;                    //The raw 10-bit ADC reading from SFE_SMOL_POWER_REGISTER_VBAT
+} sfe_power_board_history_sample_t;
+
+/** Aggregates over the most recent sfeSmolPowerHistory samples of one channel */
+typedef struct
+{
+  uint16_t count;                      //The number of samples aggregated
+  uint16_t minimum;                    //The minimum raw reading
+  uint16_t maximum;                    //The maximum raw reading
+  uint16_t mean;                       //The mean raw reading, rounded to the nearest ADU
+} sfe_power_board_history_stats_t;
+
+/** The statistics of a batch of readings from sampleBattery or sampleTemperature (see sfeSmolPowerStatistics) */
+typedef struct
+{
+  uint16_t count;                      //The number of readings
+  int32_t minimum;                     //The minimum reading: mV or hundredths of a Degree C
+  int32_t maximum;                     //The maximum reading
+  int32_t mean;                        //The mean reading, rounded to the nearest unit
+  uint32_t variance;                   //The sample variance (divided by count - 1) in units squared, rounded. 0 if count < 2
+  uint32_t standardDeviation;          //The square root of the variance, rounded down
+} sfe_power_board_sample_stats_t;
+
+/** Time-to-empty estimation (sfeSmolPowerRuntime) */
+#define SFE_SMOL_POWER_CAPACITY_FULL        10000      ///< The full battery capacity in 0.01%
+#define SFE_SMOL_POWER_RUNTIME_UNKNOWN      0xFFFFFFFF ///< The remaining runtime is unknown: too few samples, or the battery is not discharging
+
+/** One point of a voltage-to-capacity discharge curve. Curves are sorted by descending voltage */
+typedef struct
+{
+  uint16_t millivolts;                 //The battery voltage in mV
+  uint16_t capacity;                   //The remaining capacity in 0.01%
+} sfe_power_board_discharge_point_t;
+
+/** The remaining runtime estimated by sfeSmolPowerRuntime */
+typedef struct
+{
+  unsigned long secondsRemaining;      //The estimated time to empty in seconds. SFE_SMOL_POWER_RUNTIME_UNKNOWN if unknown
+  byte confidence;                     //0-100: how well the samples fit a straight line (R^2), scaled by how full the window is
+  uint16_t capacity;                   //The remaining capacity now in 0.01%, from the fitted line
+  int32_t rateCentiPercentPerHour;     //The rate of change of capacity in 0.01%/hr. Negative while discharging
+} sfe_power_board_runtime_t;
+
+/** Duty-cycle scheduling (sfeSmolPowerScheduler) */
+#define SFE_SMOL_POWER_SCHEDULE_MIN_DROP    50         ///< The capacity drop (0.01%) needed before the discharge rate is measured
+#define SFE_SMOL_POWER_SCHEDULE_NO_CAPACITY 0xFFFF     ///< The reference capacity has not been measured
+
+/** The sfeSmolPowerScheduler state. Save this before powering down (the host loses power) and restore it after waking */
+typedef struct
+{
+  unsigned long elapsedSeconds;        //The time since the schedule started
+  unsigned long sleepMS;               //The sleep interval chosen last. 0 if the schedule has not started
+  unsigned long referenceSeconds;      //When referenceCapacity was measured
+  uint16_t referenceCapacity;          //The capacity (0.01%) at the start of the rate measurement. SFE_SMOL_POWER_SCHEDULE_NO_CAPACITY if not measured
+  uint16_t elapsedRemainderMS;         //The part-second carried to the next cycle
+  uint16_t cycles;                     //The number of wake cycles since referenceCapacity was measured
+} sfe_power_board_schedule_state_t;
+
+/** Fast resume after power-down (saveResumeState / resume) */
+#define SFE_SMOL_POWER_RESUME_MAGIC   0x5352 ///< Identifies a sfe_power_board_resume_t ("SR")
+#define SFE_SMOL_POWER_RESUME_VERSION 1      ///< Incremented whenever sfe_power_board_resume_t changes
+
+/** The board identity and configuration, saved before powering down and used by resume to skip the begin handshake.
+    Store it anywhere which survives the host's power-down: RTC memory, eeprom or flash. It is protected by a CRC */
+typedef struct
+{
+  uint16_t magic;                      //SFE_SMOL_POWER_RESUME_MAGIC
+  byte version;                        //SFE_SMOL_POWER_RESUME_VERSION
+  byte i2cAddress;                     //The I2C address
+  byte firmwareVersion;                //The ATtiny43U firmware version
+  byte resetReason;                    //The reset reason when the state was saved
+  byte shadowValid;                    //The SFE_SMOL_POWER_SHADOW_ flags of the configuration below which are valid
+  byte adcReference;                   //sfe_power_board_ADC_ref_e
+  byte wdtPrescaler;                   //sfe_power_board_WDT_prescale_e
+  byte reserved;
+  uint16_t powerDownDuration;          //The power-down duration in WDT interrupts
+  byte crc;                            //CRC8 of all of the preceding bytes
+} sfe_power_board_resume_t;
+
+/** Threshold and reset events (sfeSmolPowerEvents) */
+#define SFE_SMOL_POWER_EVENT_NO_RULE       0xFF ///< Returned by addRule when there is no room for the rule
+#define SFE_SMOL_POWER_EVENT_RESET_DEFAULT (SFE_SMOL_POWER_RESET_REASON_BORF | SFE_SMOL_POWER_RESET_REASON_WDRF | SFE_SMOL_POWER_EEPROM_CORRUPT_ON_RESET) ///< The reset reason flags reported by default
+
+/** The values which event rules can watch */
+typedef enum
+{
+  SFE_SMOL_POWER_EVENT_SOURCE_BATTERY = 0, //The battery voltage in mV
+  SFE_SMOL_POWER_EVENT_SOURCE_TEMPERATURE, //The temperature in hundredths of a Degree C
+  SFE_SMOL_POWER_EVENT_SOURCE_VCC,         //VCC in mV
+  SFE_SMOL_POWER_EVENT_SOURCE_SOC,         //LiPo: the state of charge in 0.01%
+  SFE_SMOL_POWER_EVENT_SOURCE_COUNT,       //The number of sources. Not a source...
+  SFE_SMOL_POWER_EVENT_SOURCE_RESET = SFE_SMOL_POWER_EVENT_SOURCE_COUNT //Reset events: the ATtiny43U reset reason
+} sfe_power_board_event_source_e;
+
+/** When a rule becomes active */
+typedef enum
+{
+  SFE_SMOL_POWER_EVENT_BELOW = 0,      //Active at or below the threshold (e.g. low battery). Clears above threshold + hysteresis
+  SFE_SMOL_POWER_EVENT_ABOVE           //Active at or above the threshold (e.g. over-temperature). Clears below threshold - hysteresis
+} sfe_power_board_event_direction_e;
+
+/** An event: a rule has become active or has cleared, or the ATtiny43U reported a reset */
+typedef struct
+{
+  sfe_power_board_event_source_e source; //The value the rule watches. SFE_SMOL_POWER_EVENT_SOURCE_RESET for reset events
+  byte rule;                           //The rule returned by addRule. For reset events: the reset reason flag
+  bool active;                         //True if the rule has become active, false if it has cleared. Always true for reset events
+  int32_t value;                       //The value which caused the transition. For reset events: the whole reset reason
+} sfe_power_board_event_t;
+
+/** The event callback */
+typedef void (*sfe_power_board_event_callback_t)(const sfe_power_board_event_t &event);
+
+/** Register dumps (dumpRegisters / serializeRegisterDump) */
+#define SFE_SMOL_POWER_DUMP_RECORD_VERSION 1  ///< Incremented whenever the serialized register dump changes
+#define SFE_SMOL_POWER_DUMP_RECORD_SIZE    17 ///< The size of a serialized register dump in bytes
+
+/** Every readable ATtiny43U register (POWERDOWN_NOW is write-only), as raw register values. Filled by dumpRegisters.
+    Serialized by serializeRegisterDump into SFE_SMOL_POWER_DUMP_RECORD_SIZE bytes, all little endian:
+    0: SFE_SMOL_POWER_DUMP_RECORD_VERSION, 1-2: valid, 3: i2cAddress, 4: resetReason, 5-6: rawTemperature, 7-8: rawVBAT,
+    9-10: raw1V1, 11: adcReference, 12: wdtPrescaler, 13-14: powerDownDuration, 15: firmwareVersion,
+    16: CRC8 of bytes 0-15 (polynomial 0x31, initialised with 0xFF, no reflection) */
+typedef struct
+{
+  uint16_t valid;                      //Bit (1 << register) is set for each register which was read successfully
+  byte i2cAddress;                     //SFE_SMOL_POWER_REGISTER_I2C_ADDRESS
+  byte resetReason;                    //SFE_SMOL_POWER_REGISTER_RESET_REASON
+  uint16_t rawTemperature;             //SFE_SMOL_POWER_REGISTER_TEMPERATURE: the raw 10-bit ADC reading
+  uint16_t rawVBAT;                    //SFE_SMOL_POWER_REGISTER_VBAT: the raw 10-bit ADC reading
+  uint16_t raw1V1;                     //SFE_SMOL_POWER_REGISTER_1V1: the raw 10-bit ADC reading
+  byte adcReference;                   //SFE_SMOL_POWER_REGISTER_ADC_REFERENCE
+  byte wdtPrescaler;                   //SFE_SMOL_POWER_REGISTER_WDT_PRESCALER
+  uint16_t powerDownDuration;          //SFE_SMOL_POWER_REGISTER_POWERDOWN_DURATION
+  byte firmwareVersion;                //SFE_SMOL_POWER_REGISTER_FIRMWARE_VERSION
+} sfe_power_board_register_dump_t;
+
+/** Bus lock hooks (setBusLock), for a bus shared with other tasks. lock blocks until the bus is free.
+    Both are passed context, e.g. a mutex handle. The same lock must be used by every task which uses the bus */
+typedef struct
+{
+  void (*lock)(void *context);         //Take the bus. nullptr if there is no lock
+  void (*unlock)(void *context);       //Release the bus
+  void *context;                       //Passed to lock and unlock
+} sfe_power_board_bus_lock_t;
+
+/** The latest values published by sfeSmolPowerSampler */
+typedef struct
+{
+  unsigned long millis;                //millis() when the sample was taken
+  unsigned long count;                 //The number of samples published so far
+  int32_t temperatureCentiC;           //The temperature in hundredths of a Degree C
+  uint16_t batteryMillivolts;          //The battery voltage in mV
+  uint16_t vccMillivolts;              //VCC in mV
+} sfe_power_board_sample_t;
+
 #endif // /__SFE_SMOL_POWER_BOARD_CONSTANTS__
@@ -0,0 +1,273 @@
+/*!
+ * @file SparkFun_smol_Power_Board_Events.h
+ *
+ * SparkFun smôl Power Board Arduino Library
+ *
+ * This library facilitates communication with the smôl Power Boards over I<sup>2</sup>C.
+ *
+ * Want to support open source hardware? Buy a board from SparkFun!
+ * <br>SparkX smôl Power Board LiPo (SPX-18622): https://www.sparkfun.com/products/18622
+ * <br>SparkX smôl Power Board AAA (SPX-18621): https://www.sparkfun.com/products/18621
+ * <br>SparkX smôl ESP32 (SPX-18619): https://www.sparkfun.com/products/18619
+ *
+ * This library was written by:
+ * Paul Clark
+ * SparkFun Electronics
+ * July 23rd 2021
+ *
+ * Please see LICENSE.md for the license information
+ *
+ */
+
+#ifndef __SFE_SMOL_POWER_BOARD_EVENTS__
+#define __SFE_SMOL_POWER_BOARD_EVENTS__
+
+#include "SparkFun_smol_Power_Board_Platform.h"
+
+#include "SparkFun_smol_Power_Board.h"
+
+/** Threshold and reset event engine.
+    Each rule watches one value (battery, temperature, VCC or state of charge) and becomes active when
+    the value crosses its threshold, then clears when the value moves back past the threshold plus the
+    hysteresis. A transition only happens after debounce consecutive samples agree. The callback is
+    called on each transition, never while the state is unchanged.
+
+    sample reads one telemetry snapshot for all of the rules. (update feeds values read elsewhere.)
+    service evaluates only the rules whose value has a new sample, so it never touches the bus.
+
+    The ATtiny43U reset reason flags (brown-out, watchdog, eeprom corrupt by default) are reported
+    once each, as reset events. MaxRules must be 1 to 32. */
+template <byte MaxRules = 8>
+class sfeSmolPowerEvents
+{
+  static_assert((MaxRules >= 1) && (MaxRules <= 32), "sfeSmolPowerEvents MaxRules must be 1 to 32");
+
+public:
+  /** @brief Create an event engine with no rules */
+  sfeSmolPowerEvents() { clear(); }
+
+  /** Add a rule. hysteresis is in the units of the source. debounce is the number of consecutive samples
+      needed to change the state (0 or 1: change immediately).
+      Returns the rule, or SFE_SMOL_POWER_EVENT_NO_RULE if there is no room */
+  byte addRule(sfe_power_board_event_source_e source, sfe_power_board_event_direction_e direction, int32_t threshold,
+               int32_t hysteresis, byte debounce, sfe_power_board_event_callback_t callback)
+  {
+    if ((byte)source >= SFE_SMOL_POWER_EVENT_SOURCE_COUNT)
+      return (SFE_SMOL_POWER_EVENT_NO_RULE);
+    for (byte i = 0; i < MaxRules; i++)
+    {
+      if (_rules[i].callback == nullptr)
+      {
+        _rules[i].source = source;
+        _rules[i].direction = direction;
+        _rules[i].threshold = threshold;
+        _rules[i].hysteresis = (hysteresis < 0) ? -hysteresis : hysteresis;
+        _rules[i].debounce = (debounce == 0) ? 1 : debounce;
+        _rules[i].count = 0;
+        _rules[i].active = false;
+        _rules[i].callback = callback;
+        return (i);
+      }
+    }
+    return (SFE_SMOL_POWER_EVENT_NO_RULE);
+  }
+
+  /** Call callback when the battery falls to millivolts. It clears above millivolts + hysteresisMV */
+  byte onLowBattery(uint16_t millivolts, uint16_t hysteresisMV, byte debounce, sfe_power_board_event_callback_t callback)
+  {
+    return (addRule(SFE_SMOL_POWER_EVENT_SOURCE_BATTERY, SFE_SMOL_POWER_EVENT_BELOW, millivolts, hysteresisMV, debounce, callback));
+  }
+
+  /** Call callback when the temperature rises to centiC. It clears below centiC - hysteresisCentiC */
+  byte onOverTemperature(int32_t centiC, int32_t hysteresisCentiC, byte debounce, sfe_power_board_event_callback_t callback)
+  {
+    return (addRule(SFE_SMOL_POWER_EVENT_SOURCE_TEMPERATURE, SFE_SMOL_POWER_EVENT_ABOVE, centiC, hysteresisCentiC, debounce, callback));
+  }
+
+  /** Call callback once for each of the flags in the ATtiny43U reset reason */
+  void onReset(sfe_power_board_event_callback_t callback, byte flags = SFE_SMOL_POWER_EVENT_RESET_DEFAULT)
+  {
+    _resetCallback = callback;
+    _resetFlags = flags & ~SFE_SMOL_POWER_COMM_ERROR;
+  }
+
+  /** Remove a rule. Returns false if rule is not in use */
+  bool removeRule(byte rule)
+  {
+    if ((rule >= MaxRules) || (_rules[rule].callback == nullptr))
+      return (false);
+    _rules[rule].callback = nullptr;
+    return (true);
+  }
+
+  /** True if the rule is active */
+  bool isActive(byte rule)
+  {
+    return ((rule < MaxRules) && (_rules[rule].callback != nullptr) && _rules[rule].active);
+  }
+
+  /** Read a telemetry snapshot (getTelemetry) and update the battery, temperature and VCC.
+      On the first call, the reset reason is also read if there is a reset callback and
+      setResetReason has not been called. Returns false if the read fails */
+  bool sample(smolPowerAAA &board)
+  {
+    readResetReason(board);
+    sfe_power_board_telemetry_t telemetry;
+    if (!board.getTelemetry(telemetry))
+      return (false);
+    update(telemetry);
+    return (true);
+  }
+
+#ifdef SFE_SMOL_POWER_TRANSPORT_TWOWIRE
+  /** As above. The battery voltage is read from the fuel gauge, and the state of charge is updated too.
+      The MAX1704x library reads 0 if the gauge does not respond, so a state of charge of 0 is only
+      used if the gauge is still connected. Returns false (and leaves the state of charge unchanged) if it is not */
+  bool sample(smolPowerLiPo &board)
+  {
+    readResetReason(board);
+    sfe_power_board_telemetry_t telemetry;
+    if (!board.getTelemetry(telemetry)) // Fails if the fuel gauge reads 0mV
+      return (false);
+    update(telemetry);
+    uint16_t soc = board.getSOCCentiPercent();
+    if ((soc == 0) && !board.isFuelGaugeConnected())
+      return (false);
+    update(SFE_SMOL_POWER_EVENT_SOURCE_SOC, soc);
+    return (true);
+  }
+#endif
+
+  /** Update the battery, temperature and VCC from a telemetry snapshot read elsewhere */
+  void update(const sfe_power_board_telemetry_t &telemetry)
+  {
+    update(SFE_SMOL_POWER_EVENT_SOURCE_BATTERY, telemetry.batteryMillivolts);
+    update(SFE_SMOL_POWER_EVENT_SOURCE_TEMPERATURE, telemetry.temperatureCentiC);
+    update(SFE_SMOL_POWER_EVENT_SOURCE_VCC, telemetry.vccMillivolts);
+  }
+
+  /** Update one value, e.g. from getBatteryMillivolts or a split-phase measurement */
+  void update(sfe_power_board_event_source_e source, int32_t value)
+  {
+    if ((byte)source >= SFE_SMOL_POWER_EVENT_SOURCE_COUNT)
+      return;
+    _values[source] = value;
+    _fresh |= (byte)(1 << source);
+  }
+
+  /** Report the reset reason, e.g. from getResetReason or resume. The reset events are fired by the next service */
+  void setResetReason(byte reason)
+  {
+    if (reason & SFE_SMOL_POWER_COMM_ERROR)
+      return;
+    _resetReason = reason;
+    _resetKnown = true;
+    _resetPending = true;
+  }
+
+  /** Evaluate the rules whose value has a new sample, and fire the callbacks for any transitions.
+      No bus traffic. Returns the number of events fired */
+  byte service()
+  {
+    byte fired = 0;
+    sfe_power_board_event_t event;
+
+    if (_resetPending && (_resetCallback != nullptr))
+    {
+      _resetPending = false;
+      event.source = SFE_SMOL_POWER_EVENT_SOURCE_RESET;
+      event.active = true;
+      event.value = _resetReason;
+      for (byte bit = 0; bit < 8; bit++)
+      {
+        byte flag = (byte)(1 << bit);
+        if (_resetReason & _resetFlags & flag)
+        {
+          event.rule = flag;
+          _resetCallback(event);
+          fired++;
+        }
+      }
+    }
+
+    byte fresh = _fresh;
+    _fresh = 0;
+    if (fresh == 0)
+      return (fired);
+
+    for (byte i = 0; i < MaxRules; i++)
+    {
+      rule_t &rule = _rules[i];
+      if ((rule.callback == nullptr) || ((fresh & (1 << rule.source)) == 0))
+        continue;
+
+      int32_t value = _values[rule.source];
+      bool beyond; // Beyond the level needed to change the state
+      if (!rule.active)
+        beyond = (rule.direction == SFE_SMOL_POWER_EVENT_BELOW) ? (value <= rule.threshold) : (value >= rule.threshold);
+      else
+        beyond = (rule.direction == SFE_SMOL_POWER_EVENT_BELOW) ? (value > (rule.threshold + rule.hysteresis)) : (value < (rule.threshold - rule.hysteresis));
+
+      if (!beyond)
+      {
+        rule.count = 0;
+        continue;
+      }
+      if (++rule.count < rule.debounce)
+        continue;
+
+      rule.count = 0;
+      rule.active = !rule.active;
+      event.source = rule.source;
+      event.rule = i;
+      event.active = rule.active;
+      event.value = value;
+      rule.callback(event);
+      fired++;
+    }
+    return (fired);
+  }
+
+  /** Remove all rules and the reset callback */
+  void clear()
+  {
+    for (byte i = 0; i < MaxRules; i++)
+      _rules[i].callback = nullptr;
+    _fresh = 0;
+    _resetCallback = nullptr;
+    _resetFlags = SFE_SMOL_POWER_EVENT_RESET_DEFAULT;
+    _resetKnown = false;
+    _resetPending = false;
+  }
+
+private:
+  typedef struct
+  {
+    int32_t threshold;
+    int32_t hysteresis;
+    sfe_power_board_event_callback_t callback; // nullptr if the rule is not in use
+    sfe_power_board_event_source_e source;
+    sfe_power_board_event_direction_e direction;
+    byte debounce;
+    byte count; // Consecutive samples beyond the level needed to change the state
+    bool active;
+  } rule_t;
+
+  void readResetReason(sfeSmolPowerBoard &board)
+  {
+    if ((_resetCallback != nullptr) && !_resetKnown)
+      setResetReason(board.getResetReason()); // Ignored if the read failed: it is tried again next time
+  }
+
+  rule_t _rules[MaxRules];
+  int32_t _values[SFE_SMOL_POWER_EVENT_SOURCE_COUNT];
+  byte _fresh; // A bit for each source which has a new sample
+
+  sfe_power_board_event_callback_t _resetCallback;
+  byte _resetFlags;
+  byte _resetReason = 0;
+  bool _resetKnown;
+  bool _resetPending;
+};
+
+#endif // /__SFE_SMOL_POWER_BOARD_EVENTS__
@@ -0,0 +1,348 @@
+/*!
+ * @file SparkFun_smol_Power_Board_Filters.h
+ *
+ * SparkFun smôl Power Board Arduino Library
+ *
+ * This library facilitates communication with the smôl Power Boards over I<sup>2</sup>C.
+ *
+ * Want to support open source hardware? Buy a board from SparkFun!
+ * <br>SparkX smôl Power Board LiPo (SPX-18622): https://www.sparkfun.com/products/18622
+ * <br>SparkX smôl Power Board AAA (SPX-18621): https://www.sparkfun.com/products/18621
+ * <br>SparkX smôl ESP32 (SPX-18619): https://www.sparkfun.com/products/18619
+ *
+ * This library was written by:
+ * Paul Clark
+ * SparkFun Electronics
+ * July 23rd 2021
+ *
+ * Please see LICENSE.md for the license information
+ *
+ */
+
+#ifndef __SFE_SMOL_POWER_BOARD_FILTERS__
+#define __SFE_SMOL_POWER_BOARD_FILTERS__
+
+#include "SparkFun_smol_Power_Board_Platform.h"
+
+#include "SparkFun_smol_Power_Board_Constants.h"
+
+/** Streaming filters for the raw ADC readings (or the integer mV / centi-°C results).
+    Each filter uses fixed memory and integer arithmetic only. Feed each filter from
+    one place (e.g. where the split-phase measurement is collected). The filtered value
+    can then be read as often as needed without any more bus traffic. */
+
+//-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
+/** Exponential moving average: y += (x - y) / 2^shift. O(1).
+    The average is held with shift extra fractional bits, so small steps are not lost.
+    A larger shift gives more smoothing: the time constant is approximately 2^shift samples. */
+class sfeSmolPowerEMA
+{
+public:
+  /** @brief Create an EMA filter. shift is limited to 15 */
+  sfeSmolPowerEMA(byte shift = 3) { setShift(shift); }
+
+  /** Change the amount of smoothing. The filter is reset */
+  void setShift(byte shift)
+  {
+    _shift = (shift > 15) ? 15 : shift;
+    reset();
+  }
+
+  /** Add a new reading. The first reading initialises the average. Returns the new average */
+  uint16_t update(uint16_t value)
+  {
+    if (!_valid)
+    {
+      _state = ((int32_t)value) << _shift;
+      _valid = true;
+    }
+    else
+      _state += ((int32_t)value) - (_state >> _shift);
+    return (get());
+  }
+
+  /** The current average, rounded to the nearest integer. 0 if there have been no readings */
+  uint16_t get()
+  {
+    if (!_valid)
+      return (0);
+    return ((uint16_t)((_state + ((((int32_t)1) << _shift) >> 1)) >> _shift));
+  }
+
+  /** True once the first reading has been added */
+  bool isValid() { return (_valid); }
+
+  /** Discard the average */
+  void reset() { _valid = false; }
+
+private:
+  int32_t _state = 0; // The average, scaled by 2^shift
+  byte _shift;
+  bool _valid = false;
+};
+
+//-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
+/** Running median of the last Size readings, for spike rejection. Size must be odd and no more than 15.
+    The window is kept sorted: each update removes the oldest reading and inserts the new one,
+    moving at most Size entries. Size is a small compile-time constant, so the cost per update is fixed. */
+template <byte Size>
+class sfeSmolPowerMedian
+{
+  static_assert((Size % 2) == 1, "sfeSmolPowerMedian Size must be odd");
+  static_assert(Size <= 15, "sfeSmolPowerMedian is intended for small windows. Size must be no more than 15");
+
+public:
+  /** @brief Create an empty median filter */
+  sfeSmolPowerMedian() {}
+
+  /** Add a new reading, discarding the oldest once the window is full. Returns the new median */
+  uint16_t update(uint16_t value)
+  {
+    byte pos;
+    if (_count == Size) // Remove the oldest reading from the sorted window
+    {
+      uint16_t oldest = _window[_next];
+      for (pos = 0; _sorted[pos] != oldest; pos++)
+        ;
+      for (; pos < (Size - 1); pos++)
+        _sorted[pos] = _sorted[pos + 1];
+      _count--;
+    }
+    // Insert the new reading
+    for (pos = _count; (pos > 0) && (_sorted[pos - 1] > value); pos--)
+      _sorted[pos] = _sorted[pos - 1];
+    _sorted[pos] = value;
+    _count++;
+    _window[_next] = value;
+    _next = (_next == (Size - 1)) ? 0 : (_next + 1);
+    return (get());
+  }
+
+  /** The median of the readings in the window. Until the window is full, this is the median of the readings so far.
+      0 if there have been no readings */
+  uint16_t get()
+  {
+    if (_count == 0)
+      return (0);
+    return (_sorted[(_count - 1) >> 1]);
+  }
+
+  /** True once the window is full */
+  bool isValid() { return (_count == Size); }
+
+  /** Discard the readings */
+  void reset()
+  {
+    _count = 0;
+    _next = 0;
+  }
+
+private:
+  uint16_t _window[Size]; // The readings in the order they arrived
+  uint16_t _sorted[Size]; // The readings in ascending order
+  byte _count = 0;
+  byte _next = 0; // The index in _window for the next reading
+};
+
+//-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
+/** Hysteresis for threshold decisions (e.g. battery low). O(1).
+    The state goes high when the value reaches the high threshold,
+    and low when the value falls to the low threshold. In between, the state does not change. */
+class sfeSmolPowerHysteresis
+{
+public:
+  /** @brief Create a hysteresis comparator. The initial state is low */
+  sfeSmolPowerHysteresis(uint16_t lowThreshold = 0, uint16_t highThreshold = 0xFFFF) { setThresholds(lowThreshold, highThreshold); }
+
+  /** Change the thresholds. The thresholds are swapped if lowThreshold is greater than highThreshold */
+  void setThresholds(uint16_t lowThreshold, uint16_t highThreshold)
+  {
+    _low = (lowThreshold < highThreshold) ? lowThreshold : highThreshold;
+    _high = (lowThreshold < highThreshold) ? highThreshold : lowThreshold;
+  }
+
+  /** Add a new value. Returns the new state */
+  bool update(uint16_t value)
+  {
+    if (value >= _high)
+      _state = true;
+    else if (value <= _low)
+      _state = false;
+    return (_state);
+  }
+
+  /** The current state: true if the value last crossed the high threshold */
+  bool get() { return (_state); }
+
+  /** Force the state */
+  void reset(bool state = false) { _state = state; }
+
+private:
+  uint16_t _low;
+  uint16_t _high;
+  bool _state = false;
+};
+
+//-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
+/** A median filter (spike rejection) followed by an EMA (noise reduction). Use MedianSize 1 for the EMA alone */
+template <byte MedianSize = 3>
+class sfeSmolPowerFilter
+{
+public:
+  /** @brief Create a median + EMA filter */
+  sfeSmolPowerFilter(byte emaShift = 3) : _ema(emaShift) {}
+
+  /** Add a new reading. Returns the new filtered value */
+  uint16_t update(uint16_t value) { return (_ema.update(_median.update(value))); }
+
+  /** The filtered value. No bus traffic. 0 if there have been no readings */
+  uint16_t get() { return (_ema.get()); }
+
+  /** The median of the recent readings, before the EMA */
+  uint16_t getMedian() { return (_median.get()); }
+
+  /** True once the first reading has been added */
+  bool isValid() { return (_ema.isValid()); }
+
+  /** Discard the readings */
+  void reset()
+  {
+    _median.reset();
+    _ema.reset();
+  }
+
+  /** Change the amount of EMA smoothing. The filter is reset */
+  void setShift(byte shift)
+  {
+    _median.reset();
+    _ema.setShift(shift);
+  }
+
+private:
+  sfeSmolPowerMedian<MedianSize> _median;
+  sfeSmolPowerEMA _ema;
+};
+
+//-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
+/** Batch statistics: the count, minimum, maximum, mean and variance of a stream of readings. O(1), fixed memory.
+    Like Welford's method, this avoids the cancellation in sum(x^2) - sum(x)^2 / n: each reading is held
+    relative to the first one, and the sums of the deviations and their squares are exact 64-bit integers.
+    Nothing is rounded until get, so no floating point is needed.
+    Up to 65535 readings are added. Each reading must be within +/-32767 of the first one. */
+class sfeSmolPowerStatistics
+{
+public:
+  /** @brief Create an empty accumulator */
+  sfeSmolPowerStatistics() { reset(); }
+
+  /** Add a reading. Ignored once 65535 readings have been added */
+  void update(int32_t value)
+  {
+    if (_count == 0xFFFF)
+      return;
+    if (_count == 0)
+    {
+      _first = value;
+      _minimum = value;
+      _maximum = value;
+    }
+    if (value < _minimum)
+      _minimum = value;
+    if (value > _maximum)
+      _maximum = value;
+    int64_t deviation = ((int64_t)value) - _first;
+    _sumD += deviation;
+    _sumDD += (uint64_t)(deviation * deviation);
+    _count++;
+  }
+
+  /** Fill stats. Each reading x is reported as (x * scale) + offset, e.g. to convert raw ADU to centi-°C.
+      scale must be 1 to 100 */
+  void get(sfe_power_board_sample_stats_t &stats, int32_t scale = 1, int32_t offset = 0)
+  {
+    stats.count = _count;
+    stats.minimum = 0;
+    stats.maximum = 0;
+    stats.mean = 0;
+    stats.variance = 0;
+    stats.standardDeviation = 0;
+    if (_count == 0)
+      return;
+
+    int64_t n = _count;
+    stats.minimum = (_minimum * scale) + offset;
+    stats.maximum = (_maximum * scale) + offset;
+    stats.mean = (int32_t)((((int64_t)_first) * scale) + offset + divideRounded(_sumD * scale, n));
+    if (_count < 2)
+      return;
+
+    // The sum of the squared deviations from the mean is sumDD - (sumD^2 / n). With sumD = (q * n) + r,
+    // that is a - (r * sumD / n), where a = sumDD - (q * sumD) >= 0. Both parts are scaled. a is divided
+    // by (n - 1) first and its remainder is carried into the second part, so the variance is rounded once
+    int64_t q = _sumD / n;
+    int64_t r = _sumD % n;
+    int64_t scale2 = ((int64_t)scale) * scale;
+    int64_t a = (((int64_t)_sumDD) - (q * _sumD)) * scale2;
+    int64_t variance = (a / (n - 1)) + divideRounded(((a % (n - 1)) * n) - (r * _sumD * scale2), n * (n - 1));
+    if (variance < 0)
+      variance = 0;
+    stats.variance = (variance > 0xFFFFFFFF) ? 0xFFFFFFFF : (uint32_t)variance;
+    stats.standardDeviation = squareRoot((uint64_t)variance);
+  }
+
+  /** The number of readings */
+  uint16_t getCount() { return (_count); }
+
+  /** True once the first reading has been added */
+  bool isValid() { return (_count > 0); }
+
+  /** Discard the readings */
+  void reset()
+  {
+    _count = 0;
+    _sumD = 0;
+    _sumDD = 0;
+  }
+
+private:
+  /** num / den rounded to the nearest integer (halves away from zero). den must be positive */
+  static int64_t divideRounded(int64_t num, int64_t den)
+  {
+    return ((num >= 0) ? ((num + (den / 2)) / den) : -((-num + (den / 2)) / den));
+  }
+
+  /** The integer square root, rounded down */
+  static uint32_t squareRoot(uint64_t value)
+  {
+    uint64_t root = 0;
+    uint64_t bit = ((uint64_t)1) << 62;
+    while (bit > value)
+      bit >>= 2;
+    while (bit != 0)
+    {
+      if (value >= root + bit)
+      {
+        value -= root + bit;
+        root = (root >> 1) + bit;
+      }
+      else
+        root >>= 1;
+      bit >>= 2;
+    }
+    return ((uint32_t)root);
+  }
+
+  int32_t _first = 0; // The deviations are relative to the first reading
+  int32_t _minimum = 0;
+  int32_t _maximum = 0;
+  int64_t _sumD = 0;
+  uint64_t _sumDD = 0;
+  uint16_t _count = 0;
+};
+
+#endif // /__SFE_SMOL_POWER_BOARD_FILTERS__
@@ -0,0 +1,318 @@
+/*!
+ * @file SparkFun_smol_Power_Board_History.h
+ *
+ * SparkFun smôl Power Board Arduino Library
+ *
+ * This library facilitates communication with the smôl Power Boards over I<sup>2</sup>C.
+ *
+ * Want to support open source hardware? Buy a board from SparkFun!
+ * <br>SparkX smôl Power Board LiPo (SPX-18622): https://www.sparkfun.com/products/18622
+ * <br>SparkX smôl Power Board AAA (SPX-18621): https://www.sparkfun.com/products/18621
+ * <br>SparkX smôl ESP32 (SPX-18619): https://www.sparkfun.com/products/18619
+ *
+ * This library was written by:
+ * Paul Clark
+ * SparkFun Electronics
+ * July 23rd 2021
+ *
+ * Please see LICENSE.md for the license information
+ *
+ */
+
+#ifndef __SFE_SMOL_POWER_BOARD_HISTORY__
+#define __SFE_SMOL_POWER_BOARD_HISTORY__
+
+#include "SparkFun_smol_Power_Board_Platform.h"
+
+#include "SparkFun_smol_Power_Board.h"
+
+/** A heap-free ring buffer holding the history of the raw TEMPERATURE and VBAT readings.
+    Each sample is delta-encoded: one signed byte per channel plus a 16-bit time step,
+    4 bytes in total (a float pair plus a timestamp would need 12).
+    Only the newest and oldest samples are held in full. Appending is O(1).
+    A sample whose deltas do not fit (more than +/-127 ADU, or more than 65535 time units) is escaped:
+    its deltas are held in full, in three slots. Nothing is clamped, so every sample decodes exactly.
+    Aggregates over the last n samples decode n samples, never the whole buffer.
+
+    Size is the number of 4-byte slots: the number of samples held if none are escaped.
+    TimeUnitMS is the resolution of the timestamps. */
+template <uint16_t Size, unsigned long TimeUnitMS = 1>
+class sfeSmolPowerHistory
+{
+  static_assert(Size >= 3, "sfeSmolPowerHistory needs at least three slots, to hold an escaped sample");
+  static_assert(TimeUnitMS > 0, "sfeSmolPowerHistory TimeUnitMS must be at least 1");
+
+  // The deltas of one sample. The value deltas are modulo 2^16, so they can be undone exactly
+  typedef struct
+  {
+    uint32_t steps; // In units of TimeUnitMS
+    uint16_t temperature;
+    uint16_t vbat;
+  } delta_t;
+
+public:
+  /** Walks the history from the newest sample to the oldest. Invalidated by append */
+  class iterator
+  {
+  public:
+    /** Decode the next (older) sample. Returns false when there are no more samples */
+    bool next(sfe_power_board_history_sample_t &sample)
+    {
+      if (_remaining == 0)
+        return (false);
+      sample.millis = _millis;
+      sample.rawTemperature = _rawTemperature;
+      sample.rawVBAT = _rawVBAT;
+      _remaining--;
+      if (_remaining > 0) // Undo the deltas to step back to the previous sample
+      {
+        uint16_t first = back(_index, _history->length(_index) - 1);
+        delta_t delta;
+        _history->read(first, delta);
+        _millis -= ((unsigned long)delta.steps) * TimeUnitMS;
+        _rawTemperature -= delta.temperature;
+        _rawVBAT -= delta.vbat;
+        _index = back(first, 1);
+      }
+      return (true);
+    }
+
+  private:
+    friend class sfeSmolPowerHistory;
+    const sfeSmolPowerHistory *_history;
+    uint16_t _index; // The last slot of the current sample
+    uint16_t _remaining;
+    unsigned long _millis;
+    uint16_t _rawTemperature;
+    uint16_t _rawVBAT;
+  };
+
+  /** @brief Create an empty history */
+  sfeSmolPowerHistory() {}
+
+  /** Read TEMPERATURE and VBAT from the board and append them. Returns false if either read fails */
+  bool sample(sfeSmolPowerBoard &board)
+  {
+    uint16_t rawTemperature, rawVBAT;
+    if (!board.getRawTemperature(&rawTemperature) || !board.getRawVBAT(&rawVBAT))
+      return (false);
+    append(millis(), rawTemperature, rawVBAT);
+    return (true);
+  }
+
+  /** Append a sample. When the history is full, the oldest samples are discarded. O(1) */
+  void append(unsigned long sampleMillis, uint16_t rawTemperature, uint16_t rawVBAT)
+  {
+    // Encode against the reconstructed newest sample, so rounding errors do not accumulate
+    delta_t delta;
+    delta.steps = (uint32_t)((sampleMillis - _newestMillis + (TimeUnitMS / 2)) / TimeUnitMS);
+    delta.temperature = rawTemperature - _newestTemperature;
+    delta.vbat = rawVBAT - _newestVBAT;
+    bool escape = (delta.steps > 0xFFFF) || !fits((int16_t)delta.temperature) || !fits((int16_t)delta.vbat);
+    uint16_t length = escape ? 3 : 1;
+
+    while ((_count > 0) && ((_slots + length) > Size)) // Discard the oldest sample. It is held in full
+    {
+      _sumTemperature -= _oldestTemperature;
+      _sumVBAT -= _oldestVBAT;
+      uint16_t oldestLength = this->length(_tail);
+      _tail = forward(_tail, oldestLength);
+      _slots -= oldestLength;
+      _count--;
+      if (_count > 0) // The second-oldest becomes the oldest
+      {
+        delta_t second;
+        read(_tail, second);
+        _oldestMillis += ((unsigned long)second.steps) * TimeUnitMS;
+        _oldestTemperature += second.temperature;
+        _oldestVBAT += second.vbat;
+      }
+    }
+
+    if (_count == 0)
+    {
+      _head = _tail = 0;
+      _slots = _count = 1;
+      _deltaTime[0] = 0;
+      _deltaTemperature[0] = 0;
+      _deltaVBAT[0] = 0;
+      _newestMillis = _oldestMillis = sampleMillis;
+      _newestTemperature = _oldestTemperature = rawTemperature;
+      _newestVBAT = _oldestVBAT = rawVBAT;
+      _sumTemperature = rawTemperature;
+      _sumVBAT = rawVBAT;
+      return;
+    }
+
+    uint16_t first = forward(_head, 1);
+    if (escape) // The first and last slots start with the escape code, so the sample can be walked in either direction
+    {
+      uint16_t middle = forward(first, 1);
+      _head = forward(first, 2);
+      _deltaTemperature[first] = _deltaTemperature[_head] = SFE_SMOL_POWER_HISTORY_ESCAPE;
+      _deltaTemperature[middle] = _deltaVBAT[middle] = 0;
+      _deltaTime[first] = delta.temperature;
+      _deltaTime[middle] = delta.vbat;
+      _deltaVBAT[first] = (int8_t)(delta.steps >> 24); // The time step: the top two bytes, then the low word
+      _deltaVBAT[_head] = (int8_t)(delta.steps >> 16);
+      _deltaTime[_head] = (uint16_t)delta.steps;
+    }
+    else
+    {
+      _head = first;
+      _deltaTime[_head] = (uint16_t)delta.steps;
+      _deltaTemperature[_head] = (int8_t)(int16_t)delta.temperature;
+      _deltaVBAT[_head] = (int8_t)(int16_t)delta.vbat;
+    }
+    _slots += length;
+    _count++;
+
+    _newestMillis += ((unsigned long)delta.steps) * TimeUnitMS;
+    _newestTemperature = rawTemperature;
+    _newestVBAT = rawVBAT;
+    _sumTemperature += _newestTemperature;
+    _sumVBAT += _newestVBAT;
+  }
+
+  /** Discard all samples */
+  void clear()
+  {
+    _count = 0;
+  }
+
+  /** The number of samples held */
+  uint16_t available()
+  {
+    return (_count);
+  }
+
+  /** The maximum number of samples which can be held. Each escaped sample takes the place of three */
+  uint16_t capacity()
+  {
+    return (Size);
+  }
+
+  /** Get the newest sample. O(1). Returns false if the history is empty */
+  bool getNewest(sfe_power_board_history_sample_t &sample)
+  {
+    if (_count == 0)
+      return (false);
+    sample.millis = _newestMillis;
+    sample.rawTemperature = _newestTemperature;
+    sample.rawVBAT = _newestVBAT;
+    return (true);
+  }
+
+  /** Get the oldest sample. O(1). Returns false if the history is empty */
+  bool getOldest(sfe_power_board_history_sample_t &sample)
+  {
+    if (_count == 0)
+      return (false);
+    sample.millis = _oldestMillis;
+    sample.rawTemperature = _oldestTemperature;
+    sample.rawVBAT = _oldestVBAT;
+    return (true);
+  }
+
+  /** Iterate from the newest sample to the oldest */
+  iterator newest() const
+  {
+    iterator it;
+    it._history = this;
+    it._index = _head;
+    it._remaining = _count;
+    it._millis = _newestMillis;
+    it._rawTemperature = _newestTemperature;
+    it._rawVBAT = _newestVBAT;
+    return (it);
+  }
+
+  /** Calculate the minimum, maximum and mean of one channel over the newest n samples.
+      O(n): the samples are decoded for the minimum and maximum. Use getMean for the O(1) mean of the whole history.
+      Returns false if the history is empty */
+  bool getStatistics(sfe_power_board_history_channel_e channel, uint16_t n, sfe_power_board_history_stats_t &stats)
+  {
+    if (_count == 0)
+      return (false);
+    if ((n == 0) || (n > _count))
+      n = _count;
+
+    stats.count = n;
+    stats.minimum = 0xFFFF;
+    stats.maximum = 0;
+    uint32_t sum = 0;
+    iterator it = newest();
+    sfe_power_board_history_sample_t sample;
+    for (uint16_t i = 0; i < n; i++)
+    {
+      it.next(sample);
+      uint16_t value = (channel == SFE_SMOL_POWER_HISTORY_TEMPERATURE) ? sample.rawTemperature : sample.rawVBAT;
+      if (value < stats.minimum)
+        stats.minimum = value;
+      if (value > stats.maximum)
+        stats.maximum = value;
+      sum += value;
+    }
+    stats.mean = (uint16_t)((sum + (n >> 1)) / n);
+    return (true);
+  }
+
+  /** The mean of one channel over the whole history. O(1). Returns 0 if the history is empty */
+  uint16_t getMean(sfe_power_board_history_channel_e channel)
+  {
+    if (_count == 0)
+      return (0);
+    uint32_t sum = (channel == SFE_SMOL_POWER_HISTORY_TEMPERATURE) ? _sumTemperature : _sumVBAT;
+    return ((uint16_t)((sum + (_count >> 1)) / _count));
+  }
+
+private:
+  static bool fits(int16_t delta) { return ((delta > SFE_SMOL_POWER_HISTORY_ESCAPE) && (delta <= 127)); }
+
+  static uint16_t forward(uint16_t index, uint16_t n) { return ((uint16_t)((index + n) % Size)); }
+  static uint16_t back(uint16_t index, uint16_t n) { return ((uint16_t)((index + Size - n) % Size)); }
+
+  // The number of slots used by a sample, from its first or last slot. Escaped samples start and end with the escape code
+  uint16_t length(uint16_t index) const { return ((_deltaTemperature[index] == SFE_SMOL_POWER_HISTORY_ESCAPE) ? 3 : 1); }
+
+  // Decode the deltas of the sample starting at slot first
+  void read(uint16_t first, delta_t &delta) const
+  {
+    if (length(first) == 1)
+    {
+      delta.steps = _deltaTime[first];
+      delta.temperature = (uint16_t)(int16_t)_deltaTemperature[first];
+      delta.vbat = (uint16_t)(int16_t)_deltaVBAT[first];
+      return;
+    }
+    uint16_t middle = forward(first, 1);
+    uint16_t last = forward(first, 2);
+    delta.temperature = _deltaTime[first];
+    delta.vbat = _deltaTime[middle];
+    delta.steps = (((uint32_t)(uint8_t)_deltaVBAT[first]) << 24) | (((uint32_t)(uint8_t)_deltaVBAT[last]) << 16) | _deltaTime[last];
+  }
+
+  // The deltas from the previous sample, one slot per sample, or three if escaped. The deltas of the oldest sample are not used
+  uint16_t _deltaTime[Size]; // In units of TimeUnitMS
+  int8_t _deltaTemperature[Size];
+  int8_t _deltaVBAT[Size];
+
+  uint16_t _head = 0; // The last slot of the newest sample
+  uint16_t _tail = 0; // The first slot of the oldest sample
+  uint16_t _slots = 0;
+  uint16_t _count = 0;
+
+  // The newest and oldest samples, held in full
+  unsigned long _newestMillis = 0;
+  uint16_t _newestTemperature = 0;
+  uint16_t _newestVBAT = 0;
+  unsigned long _oldestMillis = 0;
+  uint16_t _oldestTemperature = 0;
+  uint16_t _oldestVBAT = 0;
+
+  // Running sums for the O(1) mean
+  uint32_t _sumTemperature = 0;
+  uint32_t _sumVBAT = 0;
+};
+
+#endif // /__SFE_SMOL_POWER_BOARD_HISTORY__
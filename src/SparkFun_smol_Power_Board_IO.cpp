@@ -27,6 +27,18 @@
 
 #include "SparkFun_smol_Power_Board_IO.h"
 
+#ifdef SFE_SMOL_POWER_ENABLE_BUS_STATISTICS
+#define SFE_SMOL_POWER_BUS_STAT(counter, n) _busStats.counter += (n)
+/** Count one write transaction: packetLength bytes, and a NACK if endTransmission failed */
+#define SFE_SMOL_POWER_BUS_STAT_WRITE(packetLength, nack) { SFE_SMOL_POWER_BUS_STAT(transactions, 1); SFE_SMOL_POWER_BUS_STAT(bytesWritten, packetLength); SFE_SMOL_POWER_BUS_STAT(nacks, (nack) ? 1 : 0); }
+/** Count one read transaction: bytesReturned bytes, and a short read if fewer than packetLength were returned */
+#define SFE_SMOL_POWER_BUS_STAT_READ(bytesReturned, packetLength) { SFE_SMOL_POWER_BUS_STAT(transactions, 1); SFE_SMOL_POWER_BUS_STAT(bytesRead, bytesReturned); SFE_SMOL_POWER_BUS_STAT(shortReads, ((bytesReturned) < (packetLength)) ? 1 : 0); }
+#else
+#define SFE_SMOL_POWER_BUS_STAT(counter, n) // Compiled out
+#define SFE_SMOL_POWER_BUS_STAT_WRITE(packetLength, nack) (void)(nack) // Compiled out
+#define SFE_SMOL_POWER_BUS_STAT_READ(bytesReturned, packetLength) // Compiled out
+#endif
+
 /**************************************************************************/
 /*!
     @brief  Begin communication with the SparkFun smôl Power Board over I2C
@@ -34,19 +46,56 @@
             The I2C address of the Power Board.
             Default is SFE_SMOL_POWER_DEFAULT_I2C_ADDRESS 0x50.
             Can be changed with setI2CAddress.
-    @param  wirePort
-            The TwoWire (I2C) port used to communicate with the Power Board.
-            Default is Wire.
+    @param  port
+            The port used to communicate with the Power Board: the TwoWire (I2C) port
+            (default is Wire), the mock board, or the Linux I2C bus, depending on the transport.
     @return True if communication with the Power Board was successful, otherwise false.
 */
 /**************************************************************************/
-bool SMOL_POWER_BOARD_IO::begin(byte address, TwoWire& wirePort)
+bool SMOL_POWER_BOARD_IO::begin(byte address, sfe_power_board_port_t &port)
 {
-  _i2cPort = &wirePort;
+  setPort(port);
   _address = address;
   return isConnected();
 }
 
+/**************************************************************************/
+/*!
+    @brief  Select the port without checking the connection, e.g. when resuming
+            with a known address.
+    @param  port
+            The port: the TwoWire port, mock board or Linux I2C bus, depending on the transport.
+*/
+/**************************************************************************/
+void SMOL_POWER_BOARD_IO::setPort(sfe_power_board_port_t &port)
+{
+  _transport.begin(port);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Change the I2C address used to communicate with the Power Board.
+            Used after the Power Board's address has been changed with setI2CAddress.
+    @param  address
+            The new I2C address.
+*/
+/**************************************************************************/
+void SMOL_POWER_BOARD_IO::setAddress(byte address)
+{
+  _address = address;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Get the I2C address used to communicate with the Power Board.
+    @return The I2C address.
+*/
+/**************************************************************************/
+byte SMOL_POWER_BOARD_IO::getAddress()
+{
+  return (_address);
+}
+
 /**************************************************************************/
 /*!
     @brief  Reads the smôl Power Board's I2C address and confirms it matches _address.
@@ -55,20 +104,39 @@ bool SMOL_POWER_BOARD_IO::begin(byte address, TwoWire& wirePort)
 /**************************************************************************/
 bool SMOL_POWER_BOARD_IO::isConnected()
 {
-  _i2cPort->beginTransmission(_address);
-  if (_i2cPort->endTransmission() == 0)
-  {
-    _i2cPort->beginTransmission(_address);
-    _i2cPort->write(SFE_SMOL_POWER_REGISTER_I2C_ADDRESS);
-    _i2cPort->endTransmission(); // Send data and release the bus (the 43 (WireS) doesn't like it if the Controller holds the bus!)
-    byte bytesReturned = _i2cPort->requestFrom(_address, (byte)1);
-    if (bytesReturned != 1)
-        return (false);
-    byte incomingByte = _i2cPort->read();
-    if (incomingByte == _address)
-      return (true);
+  sfeSmolPowerIOCallScope callScope(this);
+  sfeSmolPowerBusLockScope busLockScope(this); // Released during the waits
+  sfe_power_board_error_e previousError = _lastError; // Restored if a retry succeeds
+  for (byte attempt = 0; ; attempt++)
+  {
+    if (!checkDeadline(0))
+      return (false);
+    byte status = _transport.probe(_address);
+    SFE_SMOL_POWER_BUS_STAT_WRITE(0, status != 0);
+    if (status == 0)
+      status = writeRegisterPointer(SFE_SMOL_POWER_REGISTER_I2C_ADDRESS);
+    if (status == 0)
+    {
+      byte incomingByte;
+      byte bytesReturned = _transport.read(_address, &incomingByte, 1);
+      SFE_SMOL_POWER_BUS_STAT_READ(bytesReturned, 1);
+      if (bytesReturned == 1)
+      {
+        if (incomingByte == _address)
+        {
+          _lastError = previousError;
+          return (true);
+        }
+        setLastError(SFE_SMOL_POWER_ERROR_INVALID_VALUE);
+        return (false); // Something is responding, but it is not the Power Board. Don't retry
+      }
+      setLastError(SFE_SMOL_POWER_ERROR_SHORT_READ);
+    }
+    else
+      setLastError(classifyStatus(status));
+    if (!retryAfterError(attempt))
+      return (false);
   }
-  return (false);
 }
 
 /**************************************************************************/
@@ -85,19 +153,31 @@ bool SMOL_POWER_BOARD_IO::isConnected()
 /**************************************************************************/
 bool SMOL_POWER_BOARD_IO::writeMultipleBytes(byte registerAddress, const byte* buffer, byte const packetLength)
 {
-  _i2cPort->beginTransmission(_address);
-  _i2cPort->write(registerAddress);
-
-  for (byte i = 0; i < packetLength; i++)
-    _i2cPort->write(buffer[i]);
-
-  return (_i2cPort->endTransmission() == 0);
+  sfeSmolPowerIOCallScope callScope(this);
+  sfeSmolPowerBusLockScope busLockScope(this); // Released during the waits
+  sfe_power_board_error_e previousError = _lastError; // Restored if a retry succeeds
+  for (byte attempt = 0; ; attempt++)
+  {
+    if (!checkDeadline(0))
+      return (false);
+    byte status = _transport.write(_address, registerAddress, buffer, packetLength);
+    SFE_SMOL_POWER_BUS_STAT_WRITE(packetLength + 1, status != 0);
+    if (status == 0)
+    {
+      _lastError = previousError;
+      return (true);
+    }
+    setLastError(classifyStatus(status));
+    if (!retryAfterError(attempt))
+      return (false);
+  }
 }
 
 /**************************************************************************/
 /*!
     @brief  Read multiple bytes from the SparkFun smôl Power Board over I2C.
             First the register address is written, then the data bytes are read.
+            If either fails, the whole transaction is retried according to the retry policy.
     @param  registerAddress
             The (software) register address being read from.
     @param  buffer
@@ -112,25 +192,34 @@ bool SMOL_POWER_BOARD_IO::writeMultipleBytes(byte registerAddress, const byte* b
 /**************************************************************************/
 bool SMOL_POWER_BOARD_IO::readMultipleBytes(byte registerAddress, byte* buffer, byte packetLength, byte waitMS)
 {
-  _i2cPort->beginTransmission(_address);
-  _i2cPort->write(registerAddress);
-  _i2cPort->endTransmission(); // Send data and release the bus (the 43 (WireS) doesn't like it if the Controller holds the bus!)
-
-  delay(waitMS); // Give the ATtiny43U time to collect the requested data
-
-  byte bytesReturned = _i2cPort->requestFrom(_address, packetLength);
-
-  byte i;
-  for (i = 0; (i < bytesReturned); i++)
-    buffer[i] = _i2cPort->read();
-
-  return (bytesReturned == packetLength);
+  sfeSmolPowerIOCallScope callScope(this);
+  sfeSmolPowerBusLockScope busLockScope(this); // Released during the waits
+  sfe_power_board_error_e previousError = _lastError; // Restored if a retry succeeds
+  for (byte attempt = 0; ; attempt++)
+  {
+    if (!checkDeadline(waitMS)) // Don't start the transaction if the data can't be collected before the deadline
+      return (false);
+    byte status = writeRegisterPointer(registerAddress);
+    if (status == 0)
+    {
+      if (requestData(registerAddress, buffer, packetLength, waitMS, millis())) // Wait for the ATtiny43U to collect the requested data, then read it
+      {
+        _lastError = previousError;
+        return (true);
+      }
+    }
+    else
+      setLastError(classifyStatus(status));
+    if (!retryAfterError(attempt))
+      return (false);
+  }
 }
 
 /**************************************************************************/
 /*!
     @brief  Read a single byte from the SparkFun smôl Power Board over I2C.
             First the register address is written, then the data byte is read.
+            If either fails, the whole transaction is retried according to the retry policy.
     @param  registerAddress
             The (software) register address being read from.
     @param  buffer
@@ -143,17 +232,35 @@ bool SMOL_POWER_BOARD_IO::readMultipleBytes(byte registerAddress, byte* buffer,
 /**************************************************************************/
 bool SMOL_POWER_BOARD_IO::readSingleByte(byte registerAddress, byte* buffer, byte waitMS)
 {
-  _i2cPort->beginTransmission(_address);
-  _i2cPort->write(registerAddress);
-  _i2cPort->endTransmission(); // Send data and release the bus (the 43 (WireS) doesn't like it if the Controller holds the bus!)
-
-  delay(waitMS); // Give the ATtiny43U time to collect the requested data
-
-  byte bytesReturned = _i2cPort->requestFrom(_address, (byte)1);
+  sfeSmolPowerIOCallScope callScope(this);
+  sfeSmolPowerBusLockScope busLockScope(this); // Released during the waits
+  sfe_power_board_error_e previousError = _lastError; // Restored if a retry succeeds
+  for (byte attempt = 0; ; attempt++)
+  {
+    if (!checkDeadline(waitMS)) // Don't start the transaction if the data can't be collected before the deadline
+      return (false);
+    byte status = writeRegisterPointer(registerAddress);
+    if (status == 0)
+    {
+      delayMS(waitMS); // Give the ATtiny43U time to collect the requested data
 
-  *buffer = _i2cPort->read();
+      byte incomingByte;
+      byte bytesReturned = _transport.read(_address, &incomingByte, 1);
+      SFE_SMOL_POWER_BUS_STAT_READ(bytesReturned, 1);
 
-  return (bytesReturned == 1);
+      if (bytesReturned == 1) // Leave buffer unchanged on a short read
+      {
+        *buffer = incomingByte;
+        _lastError = previousError;
+        return (true);
+      }
+      setLastError(SFE_SMOL_POWER_ERROR_SHORT_READ);
+    }
+    else
+      setLastError(classifyStatus(status));
+    if (!retryAfterError(attempt))
+      return (false);
+  }
 }
 
 /**************************************************************************/
@@ -168,8 +275,693 @@ bool SMOL_POWER_BOARD_IO::readSingleByte(byte registerAddress, byte* buffer, byt
 /**************************************************************************/
 bool SMOL_POWER_BOARD_IO::writeSingleByte(byte registerAddress, byte const value)
 {
-  _i2cPort->beginTransmission(_address);
-  _i2cPort->write(registerAddress);
-  _i2cPort->write(value);
-  return (_i2cPort->endTransmission() == 0);
+  return (writeMultipleBytes(registerAddress, &value, 1));
+}
+
+/**************************************************************************/
+/*!
+    @brief  Start a split-phase read from the SparkFun smôl Power Board over I2C.
+            The register address is written and the wait timer is started.
+            The host is not blocked while the ATtiny43U collects the data.
+            Call pollRead until it completes, or call collectRead to block until it does.
+    @param  registerAddress
+            The (software) register address being read from.
+    @param  waitMS
+            The number of ms to wait before attempting to read the data.
+            This gives the ATtiny43U time to collect the data.
+    @return True if the register address was written successfully, otherwise false.
+*/
+/**************************************************************************/
+bool SMOL_POWER_BOARD_IO::startRead(byte registerAddress, byte waitMS)
+{
+  sfeSmolPowerIOCallScope callScope(this);
+  sfeSmolPowerBusLockScope busLockScope(this); // Released during the waits
+  sfe_power_board_error_e previousError = _lastError; // Restored if a retry succeeds
+  _readPending = false;
+  for (byte attempt = 0; ; attempt++)
+  {
+    if (!checkDeadline(0))
+      return (false);
+    byte status = writeRegisterPointer(registerAddress);
+    if (status == 0)
+    {
+      _lastError = previousError;
+      break;
+    }
+    setLastError(classifyStatus(status));
+    if (!retryAfterError(attempt))
+      return (false);
+  }
+
+  _readPending = true;
+  _readStartMS = millis();
+  _readWaitMS = waitMS;
+  _readSettleMS = getSettleWait(registerAddress, waitMS);
+  _readRegister = registerAddress;
+  _readAttempt = 0;
+  _readRestart = false;
+  _readFirstAttempt = true;
+
+  return (true);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Check if a split-phase read has been started but not yet collected.
+    @return True if a split-phase read is pending, otherwise false.
+*/
+/**************************************************************************/
+bool SMOL_POWER_BOARD_IO::isReadPending()
+{
+  return (_readPending);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Check if the wait for a split-phase read has expired.
+    @return True if the data can be collected, otherwise false.
+*/
+/**************************************************************************/
+bool SMOL_POWER_BOARD_IO::isReadReady()
+{
+  return (_readPending && ((millis() - _readStartMS) >= _readSettleMS));
+}
+
+/**************************************************************************/
+/*!
+    @brief  Get the time remaining before a split-phase read can be collected.
+    @return The number of ms remaining. Returns zero if the data can be collected now,
+            or if no read is pending.
+*/
+/**************************************************************************/
+byte SMOL_POWER_BOARD_IO::getReadWaitRemaining()
+{
+  if (!_readPending)
+    return (0);
+  unsigned long elapsed = millis() - _readStartMS;
+  if (elapsed >= _readSettleMS)
+    return (0);
+  return ((byte)(_readSettleMS - elapsed));
+}
+
+/**************************************************************************/
+/*!
+    @brief  Make a single attempt to complete a split-phase read started by startRead. Never blocks.
+            If the wait has not yet expired, nothing is sent. Otherwise the data is read once.
+            If the data is not ready (adaptive settle), the next attempt is scheduled
+            SFE_SMOL_POWER_ADC_ADAPTIVE_POLL_INTERVAL later. If the read fails, a retry is scheduled
+            according to the retry policy: the ATtiny43U needs a new register address write before
+            it will perform a new ADC conversion, so the retry writes the register address again
+            and waits for the data. getReadWaitRemaining returns the time until the next attempt.
+            The error is only recorded if the read finally fails.
+    @param  buffer
+            A pointer to the byte array which will hold the read data.
+    @param  packetLength
+            The number of bytes to be read.
+    @return SFE_SMOL_POWER_READ_PENDING if the read is still in progress, SFE_SMOL_POWER_READ_COMPLETE
+            if the data was read successfully, or SFE_SMOL_POWER_READ_FAILED if the read failed
+            or no read is pending.
+*/
+/**************************************************************************/
+sfe_power_board_read_status_e SMOL_POWER_BOARD_IO::pollRead(byte* buffer, byte packetLength)
+{
+  sfeSmolPowerIOCallScope callScope(this);
+  if (!_readPending)
+    return (SFE_SMOL_POWER_READ_FAILED);
+
+  if (!isReadReady())
+  {
+    if (checkDeadline(getReadWaitRemaining())) // Can the next attempt be made before the deadline?
+      return (SFE_SMOL_POWER_READ_PENDING);
+    _readPending = false;
+    return (SFE_SMOL_POWER_READ_FAILED);
+  }
+
+  sfeSmolPowerBusLockScope busLockScope(this);
+
+  if (_readRestart) // A retry: write the register address again to start a new conversion
+  {
+    byte status = writeRegisterPointer(_readRegister);
+    if (status != 0)
+      return (scheduleRetry(classifyStatus(status)));
+    _readRestart = false;
+    _readFirstAttempt = true;
+    _readStartMS = millis();
+    _readSettleMS = getSettleWait(_readRegister, _readWaitMS);
+    return (SFE_SMOL_POWER_READ_PENDING);
+  }
+
+  bool adaptive = isAdaptive(_readRegister, _readWaitMS);
+  byte bytesReturned = _transport.read(_address, buffer, packetLength);
+  SFE_SMOL_POWER_BUS_STAT_READ(bytesReturned, packetLength);
+  unsigned long elapsed = millis() - _readStartMS;
+
+  if (isDataValid(adaptive, buffer, packetLength, bytesReturned))
+  {
+    if (adaptive)
+      learnSettle(_readRegister, elapsed, _readFirstAttempt);
+    _readPending = false;
+    return (SFE_SMOL_POWER_READ_COMPLETE);
+  }
+
+  _readFirstAttempt = false;
+  if (adaptive && (elapsed < _readWaitMS)) // Not ready yet. Try again shortly
+  {
+    elapsed += SFE_SMOL_POWER_ADC_ADAPTIVE_POLL_INTERVAL;
+    _readSettleMS = (elapsed > _readWaitMS) ? _readWaitMS : (byte)elapsed;
+    return (SFE_SMOL_POWER_READ_PENDING);
+  }
+  if (adaptive)
+    settleFailed(_readRegister); // The data did not settle within the fixed delay
+  return (scheduleRetry(SFE_SMOL_POWER_ERROR_SHORT_READ));
+}
+
+/**************************************************************************/
+/*!
+    @brief  Schedule a retry of a failed split-phase read, if the retry policy and deadline allow it.
+            The retry is made by pollRead after the retry delay.
+    @param  error
+            The class of the error. Recorded if the read will not be retried.
+    @return SFE_SMOL_POWER_READ_PENDING if a retry has been scheduled, otherwise SFE_SMOL_POWER_READ_FAILED.
+*/
+/**************************************************************************/
+sfe_power_board_read_status_e SMOL_POWER_BOARD_IO::scheduleRetry(sfe_power_board_error_e error)
+{
+  if (_readAttempt >= _retryPolicy.retries)
+  {
+    setLastError(error);
+    _readPending = false;
+    return (SFE_SMOL_POWER_READ_FAILED);
+  }
+  if (!checkDeadline(_retryPolicy.retryDelayMS))
+  {
+    _readPending = false;
+    return (SFE_SMOL_POWER_READ_FAILED);
+  }
+  _readAttempt++;
+  SFE_SMOL_POWER_BUS_STAT(retries, 1);
+  _readRestart = true;
+  _readStartMS = millis();
+  _readSettleMS = _retryPolicy.retryDelayMS;
+  return (SFE_SMOL_POWER_READ_PENDING);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Complete a split-phase read started by startRead.
+            This function blocks until pollRead completes: if the wait has not yet expired,
+            if the adaptive wait was too short, or while a failed read is retried.
+    @param  buffer
+            A pointer to the byte array which will hold the read data.
+    @param  packetLength
+            The number of bytes to be read.
+    @return True if the data was read successfully, otherwise false.
+*/
+/**************************************************************************/
+bool SMOL_POWER_BOARD_IO::collectRead(byte* buffer, byte packetLength)
+{
+  sfeSmolPowerIOCallScope callScope(this);
+  while (true)
+  {
+    sfe_power_board_read_status_e status = pollRead(buffer, packetLength);
+    if (status != SFE_SMOL_POWER_READ_PENDING)
+      return (status == SFE_SMOL_POWER_READ_COMPLETE);
+    delayMS(getReadWaitRemaining());
+  }
+}
+
+/**************************************************************************/
+/*!
+    @brief  Wait for the ATtiny43U to collect the data, then read it.
+            For adaptive registers, the first attempt is made after the learned settle time.
+            If the data is not ready, the read is repeated every SFE_SMOL_POWER_ADC_ADAPTIVE_POLL_INTERVAL
+            until waitMS has elapsed. The time the data took to settle is learned.
+    @param  registerAddress
+            The (software) register address being read from.
+    @param  buffer
+            A pointer to the byte array which will hold the read data.
+    @param  packetLength
+            The number of bytes to be read.
+    @param  waitMS
+            The fixed (conservative) wait.
+    @param  startMS
+            millis() when the register address was written.
+    @return True if the data was read successfully, otherwise false.
+*/
+/**************************************************************************/
+bool SMOL_POWER_BOARD_IO::requestData(byte registerAddress, byte* buffer, byte packetLength, byte waitMS, unsigned long startMS)
+{
+  bool adaptive = isAdaptive(registerAddress, waitMS);
+  byte settleMS = getSettleWait(registerAddress, waitMS);
+  unsigned long elapsed = millis() - startMS;
+  if (elapsed < settleMS)
+    delayMS(settleMS - elapsed); // Give the ATtiny43U time to collect the requested data
+
+  bool firstAttempt = true;
+  while (true)
+  {
+    byte bytesReturned = _transport.read(_address, buffer, packetLength);
+    SFE_SMOL_POWER_BUS_STAT_READ(bytesReturned, packetLength);
+
+    elapsed = millis() - startMS;
+
+    if (isDataValid(adaptive, buffer, packetLength, bytesReturned))
+    {
+      if (adaptive)
+        learnSettle(registerAddress, elapsed, firstAttempt);
+      return (true);
+    }
+
+    if ((!adaptive) || (elapsed >= waitMS) || (getDeadlineRemaining() < SFE_SMOL_POWER_ADC_ADAPTIVE_POLL_INTERVAL))
+      break;
+    delayMS(SFE_SMOL_POWER_ADC_ADAPTIVE_POLL_INTERVAL); // Not ready yet. Poll again shortly
+    firstAttempt = false;
+  }
+
+  if (adaptive && (elapsed >= waitMS)) // The data did not settle within the fixed delay
+    settleFailed(registerAddress);
+  setLastError(SFE_SMOL_POWER_ERROR_SHORT_READ);
+  return (false);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Check the data returned by a read. The read must be complete. For adaptive reads, the
+            ADC result must also be 10-bit. (See the adaptive ADC settle time constants for the firmware assumption.)
+    @param  adaptive
+            True if the read is adaptive.
+    @param  buffer
+            The data read.
+    @param  packetLength
+            The number of bytes requested.
+    @param  bytesReturned
+            The number of bytes read.
+    @return True if the data is valid.
+*/
+/**************************************************************************/
+bool SMOL_POWER_BOARD_IO::isDataValid(bool adaptive, const byte* buffer, byte packetLength, byte bytesReturned)
+{
+  if (bytesReturned != packetLength)
+    return (false);
+  if (adaptive && (packetLength == 2))
+    return ((buffer[1] & 0xFC) == 0); // The ADC result is 10-bit
+  return (true);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Learn the settle time of an adaptive register from a successful read.
+    @param  registerAddress
+            The (software) register address: TEMPERATURE, VBAT or 1V1.
+    @param  elapsed
+            The time (ms) from the register address write to the successful read.
+    @param  firstAttempt
+            True if the data was ready on the first attempt.
+*/
+/**************************************************************************/
+void SMOL_POWER_BOARD_IO::learnSettle(byte registerAddress, unsigned long elapsed, bool firstAttempt)
+{
+  sfe_power_board_adc_settle_t *settle = &_settle[registerAddress - SFE_SMOL_POWER_REGISTER_TEMPERATURE];
+  if (settle->backoff > 0)
+  {
+    settle->backoff--; // The fixed delay was used
+    return;
+  }
+  // A result which was ready on the first attempt may have been ready sooner, so probe earlier next time
+  int32_t sample16 = ((int32_t)elapsed) << 4;
+  if (firstAttempt)
+    sample16 -= ((int32_t)SFE_SMOL_POWER_ADC_ADAPTIVE_PROBE) << 4;
+  if (sample16 < 16)
+    sample16 = 16;
+  if (settle->settle16 == 0)
+    settle->settle16 = (uint16_t)sample16;
+  else
+    settle->settle16 = (uint16_t)((int32_t)settle->settle16 + ((sample16 - (int32_t)settle->settle16) / 4)); // EWMA
+  if (settle->errors > 0)
+    settle->errors--;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Record an adaptive read which did not settle within the fixed delay.
+            After too many, the fixed delay is used for a while, then the settle time is learned again.
+    @param  registerAddress
+            The (software) register address: TEMPERATURE, VBAT or 1V1.
+*/
+/**************************************************************************/
+void SMOL_POWER_BOARD_IO::settleFailed(byte registerAddress)
+{
+  sfe_power_board_adc_settle_t *settle = &_settle[registerAddress - SFE_SMOL_POWER_REGISTER_TEMPERATURE];
+  if (++settle->errors >= SFE_SMOL_POWER_ADC_ADAPTIVE_MAX_ERRORS)
+  {
+    settle->errors = 0;
+    settle->settle16 = 0;
+    settle->backoff = SFE_SMOL_POWER_ADC_ADAPTIVE_BACKOFF;
+  }
+}
+
+/**************************************************************************/
+/*!
+    @brief  Check if a read can use the adaptive settle time: a single-register read
+            of TEMPERATURE, VBAT or 1V1 using SFE_SMOL_POWER_ADC_READ_DELAY.
+    @param  registerAddress
+            The (software) register address being read from.
+    @param  waitMS
+            The fixed (conservative) wait.
+    @return True if the read is adaptive.
+*/
+/**************************************************************************/
+bool SMOL_POWER_BOARD_IO::isAdaptive(byte registerAddress, byte waitMS)
+{
+  return (_adaptiveSettle && (waitMS == SFE_SMOL_POWER_ADC_READ_DELAY)
+          && (registerAddress >= SFE_SMOL_POWER_REGISTER_TEMPERATURE) && (registerAddress <= SFE_SMOL_POWER_REGISTER_1V1));
+}
+
+/**************************************************************************/
+/*!
+    @brief  Get the wait before the first attempt to read the data.
+    @param  registerAddress
+            The (software) register address being read from.
+    @param  waitMS
+            The fixed (conservative) wait.
+    @return The learned settle time plus SFE_SMOL_POWER_ADC_ADAPTIVE_MARGIN, or waitMS if the read is not adaptive.
+*/
+/**************************************************************************/
+byte SMOL_POWER_BOARD_IO::getSettleWait(byte registerAddress, byte waitMS)
+{
+  if (!isAdaptive(registerAddress, waitMS))
+    return (waitMS);
+  sfe_power_board_adc_settle_t *settle = &_settle[registerAddress - SFE_SMOL_POWER_REGISTER_TEMPERATURE];
+  if (settle->backoff > 0)
+    return (waitMS);
+  unsigned long wait = SFE_SMOL_POWER_ADC_ADAPTIVE_INITIAL_WAIT;
+  if (settle->settle16 > 0)
+    wait = ((settle->settle16 + 15) >> 4) + SFE_SMOL_POWER_ADC_ADAPTIVE_MARGIN;
+  return ((wait > waitMS) ? waitMS : (byte)wait);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Enable or disable the adaptive ADC settle time.
+            When enabled, reads of TEMPERATURE, VBAT and 1V1 start with a shorter wait
+            and the settle time of each register is learned. If reads fail to settle within
+            SFE_SMOL_POWER_ADC_READ_DELAY, the fixed delay is used for a while.
+            The adaptive settle time needs a transport which can tell that the data is not ready
+            (sfe_power_board_transport_t::signalsNotReady). On other transports it stays disabled.
+    @param  enable
+            True to enable, false to use the fixed SFE_SMOL_POWER_ADC_READ_DELAY.
+    @return True if the setting was applied. False if enable is true but the transport cannot signal not ready.
+*/
+/**************************************************************************/
+bool SMOL_POWER_BOARD_IO::setAdaptiveSettle(bool enable)
+{
+  _adaptiveSettle = enable && sfe_power_board_transport_t::signalsNotReady;
+  return (_adaptiveSettle == enable);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Get the wait which will be used before the first attempt to read an ADC register.
+    @param  registerAddress
+            The (software) register address: SFE_SMOL_POWER_REGISTER_TEMPERATURE, _VBAT or _1V1.
+    @return The wait in ms.
+*/
+/**************************************************************************/
+byte SMOL_POWER_BOARD_IO::getSettleMS(byte registerAddress)
+{
+  return (getSettleWait(registerAddress, SFE_SMOL_POWER_ADC_READ_DELAY));
+}
+
+/**************************************************************************/
+/*!
+    @brief  Forget the learned settle times. Call this if the ATtiny43U's clock or firmware changes.
+*/
+/**************************************************************************/
+void SMOL_POWER_BOARD_IO::resetSettle()
+{
+  memset(_settle, 0, sizeof(_settle));
+}
+
+/**************************************************************************/
+/*!
+    @brief  Delay while the ATtiny43U collects data or updates eeprom.
+            The delay is included in the bus statistics.
+            The delay is cut short if it would overrun the deadline of the current call.
+    @param  ms
+            The number of ms to delay.
+*/
+/**************************************************************************/
+void SMOL_POWER_BOARD_IO::delayMS(unsigned long ms)
+{
+  unsigned long remaining = getDeadlineRemaining();
+  if (ms > remaining)
+  {
+    ms = remaining;
+    setLastError(SFE_SMOL_POWER_ERROR_TIMEOUT);
+  }
+  if (ms == 0)
+    return;
+  bool locked = (_busLockDepth > 0) && (_busLock.lock != nullptr);
+  if (locked)
+    _busLock.unlock(_busLock.context); // Let other tasks use the bus while the ATtiny43U is busy
+  delay(ms);
+  if (locked)
+    _busLock.lock(_busLock.context);
+  SFE_SMOL_POWER_BUS_STAT(delayMS, ms);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Set the hooks used to lock a bus which is shared with other tasks,
+            e.g. a FreeRTOS mutex on the smôl ESP32 (see sfeSmolPowerFreeRTOSBusLock).
+            The bus is locked for each transaction: the register address write and the data read.
+            It is released while waiting for the ADC, eeprom or a retry, so other tasks can use
+            the bus while the ATtiny43U is busy.
+            Set the lock before begin, while the bus is not locked.
+    @param  busLock
+            The sfe_power_board_bus_lock_t holding the hooks. Set lock to nullptr to disable the lock.
+*/
+/**************************************************************************/
+void SMOL_POWER_BOARD_IO::setBusLock(const sfe_power_board_bus_lock_t &busLock)
+{
+  _busLock = busLock;
+  if ((_busLock.lock == nullptr) || (_busLock.unlock == nullptr))
+    _busLock.lock = nullptr; // Both hooks are needed
+}
+
+/**************************************************************************/
+/*!
+    @brief  Lock the bus. Only the outermost call takes the lock, so transactions can be nested.
+*/
+/**************************************************************************/
+void SMOL_POWER_BOARD_IO::lockBus()
+{
+  if ((_busLockDepth++ == 0) && (_busLock.lock != nullptr))
+    _busLock.lock(_busLock.context);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Unlock the bus. Only the outermost call releases the lock.
+*/
+/**************************************************************************/
+void SMOL_POWER_BOARD_IO::unlockBus()
+{
+  if (_busLockDepth == 0)
+    return;
+  if ((--_busLockDepth == 0) && (_busLock.lock != nullptr))
+    _busLock.unlock(_busLock.context);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Set the retry policy and deadline used by every call.
+            The ATtiny43U (WireS) often NACKs just after it wakes, or while it is updating eeprom.
+            A few short retries ride through this.
+            The deadline limits the total duration of each call, including the retries and the
+            ADC / eeprom waits. It does not limit a hung bus: use the TwoWire (transport) timeout for that.
+    @param  policy
+            The sfe_power_board_retry_policy_t holding the new policy.
+*/
+/**************************************************************************/
+void SMOL_POWER_BOARD_IO::setRetryPolicy(const sfe_power_board_retry_policy_t &policy)
+{
+  _retryPolicy = policy;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Get the retry policy and deadline.
+    @param  policy
+            The sfe_power_board_retry_policy_t which will hold a copy of the policy.
+*/
+/**************************************************************************/
+void SMOL_POWER_BOARD_IO::getRetryPolicy(sfe_power_board_retry_policy_t &policy)
+{
+  policy = _retryPolicy;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Get the class of the error from the most recent call.
+    @return SFE_SMOL_POWER_ERROR_NONE if the call succeeded, otherwise the class of the (last) error.
+*/
+/**************************************************************************/
+sfe_power_board_error_e SMOL_POWER_BOARD_IO::getLastError()
+{
+  return (_lastError);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Record an error found by the caller. Deadline timeouts are counted in the bus statistics.
+    @param  error
+            The class of the error.
+*/
+/**************************************************************************/
+void SMOL_POWER_BOARD_IO::setLastError(sfe_power_board_error_e error)
+{
+  if ((error == SFE_SMOL_POWER_ERROR_TIMEOUT) && (_lastError != SFE_SMOL_POWER_ERROR_TIMEOUT))
+  {
+    SFE_SMOL_POWER_BUS_STAT(timeouts, 1); // Only count each timeout once
+  }
+  _lastError = error;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Mark the start of a call. If this is the outermost call,
+            the deadline is started and the last error is cleared.
+*/
+/**************************************************************************/
+void SMOL_POWER_BOARD_IO::beginCall()
+{
+  if (_callDepth++ == 0) // Is this the outermost call?
+  {
+    _callStartMS = millis();
+    _lastError = SFE_SMOL_POWER_ERROR_NONE;
+  }
+}
+
+/**************************************************************************/
+/*!
+    @brief  Mark the end of a call.
+*/
+/**************************************************************************/
+void SMOL_POWER_BOARD_IO::endCall()
+{
+  if (_callDepth > 0)
+    _callDepth--;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Get the time remaining before the deadline of the current call expires.
+    @return The number of ms remaining. 0xFFFFFFFF if there is no deadline, or no call in progress.
+*/
+/**************************************************************************/
+unsigned long SMOL_POWER_BOARD_IO::getDeadlineRemaining()
+{
+  if ((_retryPolicy.deadlineMS == 0) || (_callDepth == 0))
+    return (0xFFFFFFFF);
+  unsigned long elapsed = millis() - _callStartMS;
+  if (elapsed >= _retryPolicy.deadlineMS)
+    return (0);
+  return (_retryPolicy.deadlineMS - elapsed);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Write the register address. The bus is released afterwards.
+    @param  registerAddress
+            The (software) register address.
+    @return The endTransmission status: 0 for success.
+*/
+/**************************************************************************/
+byte SMOL_POWER_BOARD_IO::writeRegisterPointer(byte registerAddress)
+{
+  byte status = _transport.write(_address, registerAddress, NULL, 0);
+  SFE_SMOL_POWER_BUS_STAT_WRITE(1, status != 0);
+  return (status);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Check that neededMS can elapse before the deadline. If not, record a timeout.
+    @param  neededMS
+            The time needed, in ms.
+    @return True if there is time, false if the deadline would be overrun.
+*/
+/**************************************************************************/
+bool SMOL_POWER_BOARD_IO::checkDeadline(unsigned long neededMS)
+{
+  unsigned long remaining = getDeadlineRemaining();
+  if ((remaining == 0) || (neededMS > remaining))
+  {
+    setLastError(SFE_SMOL_POWER_ERROR_TIMEOUT);
+    return (false);
+  }
+  return (true);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Decide if a failed transaction should be retried. If so, wait for the retry delay.
+    @param  attempt
+            The number of retries made so far.
+    @return True if the transaction should be retried, otherwise false.
+*/
+/**************************************************************************/
+bool SMOL_POWER_BOARD_IO::retryAfterError(byte attempt)
+{
+  if (attempt >= _retryPolicy.retries)
+    return (false);
+  if (!checkDeadline(_retryPolicy.retryDelayMS))
+    return (false);
+  delayMS(_retryPolicy.retryDelayMS);
+  SFE_SMOL_POWER_BUS_STAT(retries, 1);
+  return (true);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Classify the status returned by endTransmission.
+    @param  status
+            The endTransmission status.
+    @return The class of the error.
+*/
+/**************************************************************************/
+sfe_power_board_error_e SMOL_POWER_BOARD_IO::classifyStatus(byte status)
+{
+  if (status == 0)
+    return (SFE_SMOL_POWER_ERROR_NONE);
+  if (status == 2)
+    return (SFE_SMOL_POWER_ERROR_NACK_ADDRESS);
+  if (status == 3)
+    return (SFE_SMOL_POWER_ERROR_NACK_DATA);
+  return (SFE_SMOL_POWER_ERROR_BUS);
+}
+
+#ifdef SFE_SMOL_POWER_ENABLE_BUS_STATISTICS
+/**************************************************************************/
+/*!
+    @brief  Get the bus statistics collected since the last resetBusStatistics.
+    @param  stats
+            The sfe_power_board_bus_stats_t which will hold a copy of the statistics.
+*/
+/**************************************************************************/
+void SMOL_POWER_BOARD_IO::getBusStatistics(sfe_power_board_bus_stats_t &stats)
+{
+  stats = _busStats;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Reset the bus statistics to zero.
+*/
+/**************************************************************************/
+void SMOL_POWER_BOARD_IO::resetBusStatistics()
+{
+  memset(&_busStats, 0, sizeof(_busStats));
 }
+#endif
@@ -22,24 +22,74 @@
 #ifndef __SFE_SMOL_POWER_BOARD_IO__
 #define __SFE_SMOL_POWER_BOARD_IO__
 
-#include <Arduino.h>
-#include <Wire.h> // Needed for I2C communication
+#include "SparkFun_smol_Power_Board_Platform.h"
 
 #include "SparkFun_smol_Power_Board_Constants.h"
+#include "SparkFun_smol_Power_Board_Transport.h"
 
 /** Communication interface for the SparkFun smôl Power Board */
 class SMOL_POWER_BOARD_IO
 {
 private:
-  TwoWire* _i2cPort;
+  sfe_power_board_transport_t _transport; // Selected at compile time: calls are dispatched statically
   byte _address;
 
+  // Split-phase read state
+  bool _readPending = false;
+  unsigned long _readStartMS;
+  byte _readWaitMS; // The fixed (conservative) wait
+  byte _readSettleMS; // The wait before the first attempt to collect the data. Shorter than _readWaitMS if adaptive
+  byte _readRegister;
+  byte _readAttempt; // The number of retries made so far
+  bool _readRestart; // A retry is scheduled: the register address must be written again
+  bool _readFirstAttempt; // No attempt has been made to read the data since the register address was written
+
+  // Adaptive ADC settle time
+  bool _adaptiveSettle = false;
+  sfe_power_board_adc_settle_t _settle[SFE_SMOL_POWER_ADC_ADAPTIVE_REGISTERS] = {};
+
+  bool isAdaptive(byte registerAddress, byte waitMS);
+  byte getSettleWait(byte registerAddress, byte waitMS);
+  bool requestData(byte registerAddress, byte* buffer, byte packetLength, byte waitMS, unsigned long startMS);
+  static bool isDataValid(bool adaptive, const byte* buffer, byte packetLength, byte bytesReturned);
+  void learnSettle(byte registerAddress, unsigned long elapsed, bool firstAttempt);
+  void settleFailed(byte registerAddress);
+  sfe_power_board_read_status_e scheduleRetry(sfe_power_board_error_e error);
+
+  // Retries, deadline and error classification
+  sfe_power_board_retry_policy_t _retryPolicy = {SFE_SMOL_POWER_DEFAULT_RETRIES, SFE_SMOL_POWER_DEFAULT_RETRY_DELAY, SFE_SMOL_POWER_DEFAULT_DEADLINE};
+  sfe_power_board_error_e _lastError = SFE_SMOL_POWER_ERROR_NONE;
+  byte _callDepth = 0;
+  unsigned long _callStartMS;
+
+  byte writeRegisterPointer(byte registerAddress);
+  bool checkDeadline(unsigned long neededMS);
+  bool retryAfterError(byte attempt);
+  static sfe_power_board_error_e classifyStatus(byte status);
+
+  // Shared bus arbitration
+  sfe_power_board_bus_lock_t _busLock = {nullptr, nullptr, nullptr};
+  byte _busLockDepth = 0;
+
+#ifdef SFE_SMOL_POWER_ENABLE_BUS_STATISTICS
+  sfe_power_board_bus_stats_t _busStats = {0, 0, 0, 0, 0, 0, 0, 0};
+#endif
+
 public:
   /** @brief Create an object to communicate with the SparkFun smôl Power Board over I2C. */
   SMOL_POWER_BOARD_IO() {}
 
-  /** Starts two wire interface. */
-  bool begin(byte address, TwoWire& wirePort);
+  /** Starts communication using the port: the TwoWire port, mock board or Linux I2C bus, depending on the transport. */
+  bool begin(byte address, sfe_power_board_port_t &port);
+
+  /** Selects the port without checking the connection. begin calls this, then isConnected. */
+  void setPort(sfe_power_board_port_t &port);
+
+  /** Changes the I2C address used for communication. Does not change the address stored by the Power Board. */
+  void setAddress(byte address);
+
+  /** Returns the I2C address used for communication. */
+  byte getAddress();
 
   /** Returns true if we get a reply from the I2C device. */
   bool isConnected();
@@ -55,6 +105,104 @@ public:
 
   /** Writes multiple bytes to register from buffer byte array. */
   bool writeMultipleBytes(byte registerAddress, const byte* buffer, byte packetLength);
+
+  /** Starts a split-phase read: writes the register address and starts the wait timer. */
+  bool startRead(byte registerAddress, byte waitMS = 0);
+
+  /** Returns true if a split-phase read has been started but not yet collected. */
+  bool isReadPending();
+
+  /** Returns true if the wait for a split-phase read has expired. */
+  bool isReadReady();
+
+  /** Returns the number of ms remaining before a split-phase read can be collected. */
+  byte getReadWaitRemaining();
+
+  /** Makes a single attempt to complete a split-phase read. Never blocks. Failed reads are retried on later calls. */
+  sfe_power_board_read_status_e pollRead(byte* buffer, byte packetLength);
+
+  /** Completes a split-phase read: reads the data bytes into the buffer byte array. Blocks until pollRead completes. */
+  bool collectRead(byte* buffer, byte packetLength);
+
+  /** Sets the hooks used to lock the bus around each transaction. The lock is released during the ADC, eeprom and retry waits. */
+  void setBusLock(const sfe_power_board_bus_lock_t &busLock);
+
+  /** Locks and unlocks the bus. Nested calls only take the lock once. */
+  void lockBus();
+  void unlockBus();
+
+  /** Delay for the ATtiny43U. The time is included in the bus statistics. The delay is limited by the deadline. The bus is unlocked during the delay. */
+  void delayMS(unsigned long ms);
+
+  /** Enables or disables the adaptive ADC settle time. Returns false if the transport cannot signal that the data is not ready. */
+  bool setAdaptiveSettle(bool enable);
+
+  /** Returns the wait (ms) which will be used before the first attempt to read an ADC register. */
+  byte getSettleMS(byte registerAddress);
+
+  /** Forgets the learned settle times. */
+  void resetSettle();
+
+  /** Sets the retry policy and deadline used by every call. */
+  void setRetryPolicy(const sfe_power_board_retry_policy_t &policy);
+
+  /** Returns the retry policy and deadline. */
+  void getRetryPolicy(sfe_power_board_retry_policy_t &policy);
+
+  /** Returns the class of the error from the most recent call. */
+  sfe_power_board_error_e getLastError();
+
+  /** Records an error found by the caller, e.g. an out-of-range value. */
+  void setLastError(sfe_power_board_error_e error);
+
+  /** Marks the start and end of a call. The deadline starts, and the last error is cleared, at the start of the outermost call. */
+  void beginCall();
+  void endCall();
+
+  /** Returns the time remaining before the deadline of the current call expires. 0xFFFFFFFF if there is no deadline. */
+  unsigned long getDeadlineRemaining();
+
+#ifdef SFE_SMOL_POWER_ENABLE_BUS_STATISTICS
+  /** Copies the bus statistics into stats. */
+  void getBusStatistics(sfe_power_board_bus_stats_t &stats);
+
+  /** Resets the bus statistics to zero. */
+  void resetBusStatistics();
+#endif
+};
+
+/** Calls beginCall and endCall for the lifetime of a public method */
+class sfeSmolPowerIOCallScope
+{
+public:
+  sfeSmolPowerIOCallScope(SMOL_POWER_BOARD_IO *io) : _io(io) { _io->beginCall(); }
+  ~sfeSmolPowerIOCallScope() { _io->endCall(); }
+
+private:
+  SMOL_POWER_BOARD_IO *_io;
 };
 
+/** Locks the bus for the lifetime of a transaction. The lock is released while the transaction waits (delayMS) */
+class sfeSmolPowerBusLockScope
+{
+public:
+  sfeSmolPowerBusLockScope(SMOL_POWER_BOARD_IO *io) : _io(io) { _io->lockBus(); }
+  ~sfeSmolPowerBusLockScope() { _io->unlockBus(); }
+
+private:
+  SMOL_POWER_BOARD_IO *_io;
+};
+
+#if defined(ARDUINO_ARCH_ESP32)
+/** A bus lock which takes a FreeRTOS mutex (xSemaphoreCreateMutex). Every task which uses the bus must take the same mutex */
+inline sfe_power_board_bus_lock_t sfeSmolPowerFreeRTOSBusLock(SemaphoreHandle_t mutex)
+{
+  sfe_power_board_bus_lock_t busLock;
+  busLock.lock = [](void *context) { xSemaphoreTake((SemaphoreHandle_t)context, portMAX_DELAY); };
+  busLock.unlock = [](void *context) { xSemaphoreGive((SemaphoreHandle_t)context); };
+  busLock.context = (void *)mutex;
+  return (busLock);
+}
+#endif
+
 #endif // /__SFE_SMOL_POWER_BOARD_IO__
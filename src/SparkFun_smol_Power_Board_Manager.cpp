@@ -0,0 +1,290 @@
+/*!
+ * @file SparkFun_smol_Power_Board_Manager.cpp
+ * 
+ * @mainpage SparkFun smôl Power Board Arduino Library
+ * 
+ * @section intro_sec Introduction
+ * 
+ * This library facilitates communication with the smôl Power Board.
+ * 
+ * Want to support open source hardware? Buy a board from SparkFun!
+ * <br>SparkX smôl Power Board LiPo (SPX-18622): https://www.sparkfun.com/products/18622
+ * <br>SparkX smôl Power Board AAA (SPX-18621): https://www.sparkfun.com/products/18621
+ * <br>SparkX smôl ESP32 (SPX-18619): https://www.sparkfun.com/products/18619
+ * 
+ * @section author Author
+ * 
+ * This library was written by:
+ * Paul Clark
+ * SparkFun Electronics
+ * July 23rd 2021
+ * 
+ * @section license License
+ * 
+ * MIT: please see LICENSE.md for the full license information
+ * 
+ */
+
+#include "SparkFun_smol_Power_Board_Manager.h"
+
+/**************************************************************************/
+/*!
+    @brief  Add a smôl Power Board AAA to the manager.
+            Call the board's begin first. The boards can be on different TwoWire ports.
+    @param  board
+            The board.
+    @return True if the board was added, false if the manager is full.
+*/
+/**************************************************************************/
+bool sfeSmolPowerBoardManager::addBoard(smolPowerAAA &board)
+{
+  return (addBoard(&board, SFE_SMOL_POWER_BOARD_TYPE_AAA));
+}
+
+#ifdef SFE_SMOL_POWER_TRANSPORT_TWOWIRE
+/**************************************************************************/
+/*!
+    @brief  Add a smôl Power Board LiPo to the manager.
+            Call the board's begin first. The boards can be on different TwoWire ports.
+    @param  board
+            The board.
+    @return True if the board was added, false if the manager is full.
+*/
+/**************************************************************************/
+bool sfeSmolPowerBoardManager::addBoard(smolPowerLiPo &board)
+{
+  return (addBoard(&board, SFE_SMOL_POWER_BOARD_TYPE_LIPO));
+}
+#endif
+
+bool sfeSmolPowerBoardManager::addBoard(sfeSmolPowerBoard *board, sfe_power_board_type_e type)
+{
+  if (_numBoards >= SFE_SMOL_POWER_MANAGER_MAX_BOARDS)
+    return (false);
+  _boards[_numBoards] = board;
+  _types[_numBoards] = type;
+  _pending[_numBoards] = false;
+  _results[_numBoards] = 0;
+  _succeeded[_numBoards] = false;
+  memset(&_health[_numBoards], 0, sizeof(sfe_power_board_health_t));
+  _numBoards++;
+  return (true);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Get the number of boards being managed.
+    @return The number of boards.
+*/
+/**************************************************************************/
+byte sfeSmolPowerBoardManager::getNumberOfBoards()
+{
+  return (_numBoards);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Start a split-phase measurement on every board.
+            Each board's register address is written immediately, so all of the
+            ATtiny43Us perform their ADC conversions at the same time.
+            Call pollAll until it returns true, then call getResult.
+    @param  measurement
+            SFE_SMOL_POWER_MEASUREMENT_TEMPERATURE, SFE_SMOL_POWER_MEASUREMENT_VCC
+            or SFE_SMOL_POWER_MEASUREMENT_BATTERY.
+    @return True if the measurement was started on every board, otherwise false.
+*/
+/**************************************************************************/
+bool sfeSmolPowerBoardManager::startAll(sfe_power_board_measurement_e measurement)
+{
+  _measurement = measurement;
+  _allSucceeded = true;
+  bool result = true;
+  for (byte i = 0; i < _numBoards; i++)
+  {
+    bool started = false;
+    if (measurement == SFE_SMOL_POWER_MEASUREMENT_TEMPERATURE)
+      started = _boards[i]->startTemperature();
+    else if (measurement == SFE_SMOL_POWER_MEASUREMENT_VCC)
+      started = _boards[i]->startMeasureVCC();
+    else if (measurement == SFE_SMOL_POWER_MEASUREMENT_BATTERY)
+    {
+      if (_types[i] == SFE_SMOL_POWER_BOARD_TYPE_AAA)
+        started = static_cast<smolPowerAAA *>(_boards[i])->startBatteryVoltage();
+#ifdef SFE_SMOL_POWER_TRANSPORT_TWOWIRE
+      else
+        started = static_cast<smolPowerLiPo *>(_boards[i])->startBatteryVoltage();
+#endif
+    }
+    _pending[i] = true; // pollAll will collect the result - or the failure
+    result &= started;
+  }
+  return (result);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Service the split-phase measurements on every board. This function never blocks.
+    @return True when every board has finished (successfully or not), otherwise false.
+*/
+/**************************************************************************/
+bool sfeSmolPowerBoardManager::pollAll()
+{
+  bool allDone = true;
+  for (byte i = 0; i < _numBoards; i++)
+  {
+    if (!_pending[i])
+      continue;
+    if (!_boards[i]->poll())
+    {
+      allDone = false;
+      continue;
+    }
+    bool success = (_boards[i]->getMeasurementState() == SFE_SMOL_POWER_MEASUREMENT_COMPLETE);
+    _results[i] = _boards[i]->collectFixedPoint();
+    _succeeded[i] = success;
+    _pending[i] = false;
+    if (success)
+    {
+      _health[i].successes++;
+      _health[i].consecutiveFailures = 0;
+      _health[i].lastSuccessMillis = millis();
+    }
+    else
+    {
+      _health[i].failures++;
+      if (_health[i].consecutiveFailures < 0xFF)
+        _health[i].consecutiveFailures++;
+      _allSucceeded = false;
+    }
+  }
+  return (allDone);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Perform a measurement on every board and wait for them all to finish.
+            The ADC waits overlap, so N boards take about one ADC wait, not N.
+            As with the blocking single-board methods, each board's deadline (setRetryPolicy) runs
+            from the start of the call. A board which misses its deadline fails with SFE_SMOL_POWER_ERROR_TIMEOUT.
+    @param  measurement
+            SFE_SMOL_POWER_MEASUREMENT_TEMPERATURE, SFE_SMOL_POWER_MEASUREMENT_VCC
+            or SFE_SMOL_POWER_MEASUREMENT_BATTERY.
+    @return True if the measurement succeeded on every board, otherwise false.
+*/
+/**************************************************************************/
+bool sfeSmolPowerBoardManager::measureAll(sfe_power_board_measurement_e measurement)
+{
+  for (byte i = 0; i < _numBoards; i++)
+    _boards[i]->smolPowerBoard_io.beginCall(); // One call for the whole measurement: the deadlines start now
+
+  startAll(measurement);
+  while (!pollAll())
+  {
+    // Wait until the first pending board is ready. Its delayMS keeps to its deadline,
+    // counts the wait in its bus statistics and releases the bus lock
+    byte first = _numBoards;
+    byte wait = 0xFF;
+    for (byte i = 0; i < _numBoards; i++)
+    {
+      if (_pending[i])
+      {
+        byte remaining = _boards[i]->smolPowerBoard_io.getReadWaitRemaining();
+        if (remaining < wait)
+        {
+          wait = remaining;
+          first = i;
+        }
+      }
+    }
+    if (first < _numBoards)
+      _boards[first]->smolPowerBoard_io.delayMS(wait);
+  }
+
+  for (byte i = 0; i < _numBoards; i++)
+    _boards[i]->smolPowerBoard_io.endCall();
+  return (_allSucceeded);
+}
+
+#ifndef SFE_SMOL_POWER_DISABLE_FLOAT
+/**************************************************************************/
+/*!
+    @brief  Get the latest result for a board.
+    @param  index
+            The board index, in the order the boards were added.
+    @return The temperature in Degrees C or the voltage in Volts.
+            -273.15 (temperature) or -99.0 (voltage) if the measurement failed or index is invalid.
+*/
+/**************************************************************************/
+float sfeSmolPowerBoardManager::getResult(byte index)
+{
+  if (_measurement == SFE_SMOL_POWER_MEASUREMENT_TEMPERATURE)
+  {
+    if ((index >= _numBoards) || (!_succeeded[index]))
+      return (-273.15);
+    return (((float)_results[index]) / 100.0); // Convert centi-°C to °C
+  }
+  if ((index >= _numBoards) || (!_succeeded[index]))
+    return (-99.0);
+  return (((float)_results[index]) / 1000.0); // Convert mV to V
+}
+#endif
+
+/**************************************************************************/
+/*!
+    @brief  Get the latest result for a board, using integer arithmetic only.
+    @param  index
+            The board index, in the order the boards were added.
+    @return The temperature in hundredths of a Degree C (centi-°C) or the voltage in mV.
+            SFE_SMOL_POWER_TEMPERATURE_CENTI_C_ERROR (temperature) or 0 (voltage) if the measurement failed or index is invalid.
+*/
+/**************************************************************************/
+int32_t sfeSmolPowerBoardManager::getFixedPointResult(byte index)
+{
+  if ((index >= _numBoards) || (!_succeeded[index]))
+    return ((_measurement == SFE_SMOL_POWER_MEASUREMENT_TEMPERATURE) ? SFE_SMOL_POWER_TEMPERATURE_CENTI_C_ERROR : 0);
+  return (_results[index]);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Get the health of a board.
+    @param  index
+            The board index, in the order the boards were added.
+    @param  health
+            The sfe_power_board_health_t which will hold a copy of the board's health.
+    @return True if index is valid, otherwise false.
+*/
+/**************************************************************************/
+bool sfeSmolPowerBoardManager::getHealth(byte index, sfe_power_board_health_t &health)
+{
+  if (index >= _numBoards)
+    return (false);
+  health = _health[index];
+  return (true);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Check if a board is healthy.
+    @param  index
+            The board index, in the order the boards were added.
+    @return True if the board has fewer than SFE_SMOL_POWER_MANAGER_UNHEALTHY_FAILURES
+            consecutive failed measurements, otherwise false.
+*/
+/**************************************************************************/
+bool sfeSmolPowerBoardManager::isHealthy(byte index)
+{
+  if (index >= _numBoards)
+    return (false);
+  return (_health[index].consecutiveFailures < SFE_SMOL_POWER_MANAGER_UNHEALTHY_FAILURES);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Reset the health of every board.
+*/
+/**************************************************************************/
+void sfeSmolPowerBoardManager::resetHealth()
+{
+  memset(_health, 0, sizeof(_health));
+}
@@ -0,0 +1,90 @@
+/*!
+ * @file SparkFun_smol_Power_Board_Manager.h
+ *
+ * SparkFun smôl Power Board Arduino Library
+ * 
+ * This library facilitates communication with the smôl Power Boards over I<sup>2</sup>C.
+ * 
+ * Want to support open source hardware? Buy a board from SparkFun!
+ * <br>SparkX smôl Power Board LiPo (SPX-18622): https://www.sparkfun.com/products/18622
+ * <br>SparkX smôl Power Board AAA (SPX-18621): https://www.sparkfun.com/products/18621
+ * <br>SparkX smôl ESP32 (SPX-18619): https://www.sparkfun.com/products/18619
+ * 
+ * This library was written by:
+ * Paul Clark
+ * SparkFun Electronics
+ * July 23rd 2021
+ * 
+ * Please see LICENSE.md for the license information
+ * 
+ */
+
+#ifndef __SFE_SMOL_POWER_BOARD_MANAGER__
+#define __SFE_SMOL_POWER_BOARD_MANAGER__
+
+#include "SparkFun_smol_Power_Board_Platform.h"
+
+#include "SparkFun_smol_Power_Board.h"
+
+#ifndef SFE_SMOL_POWER_MANAGER_MAX_BOARDS
+#define SFE_SMOL_POWER_MANAGER_MAX_BOARDS 16 ///< The maximum number of boards the manager can hold. Define before including to change it
+#endif
+
+#define SFE_SMOL_POWER_MANAGER_UNHEALTHY_FAILURES 3 ///< A board is unhealthy after this many consecutive failed measurements
+
+/** The type of each managed board, so the correct battery voltage method is called */
+typedef enum 
+{
+  SFE_SMOL_POWER_BOARD_TYPE_AAA = 0,
+  SFE_SMOL_POWER_BOARD_TYPE_LIPO
+} sfe_power_board_type_e;
+
+/** The health of each managed board */
+typedef struct
+{
+  unsigned long successes;             //The number of successful measurements
+  unsigned long failures;              //The number of failed measurements
+  byte consecutiveFailures;            //The number of failed measurements since the last success
+  unsigned long lastSuccessMillis;     //millis() when the last successful measurement was collected
+} sfe_power_board_health_t;
+
+/** Manages a set of smôl Power Boards, possibly on several TwoWire ports, and pipelines their measurements */
+class sfeSmolPowerBoardManager
+{
+public:
+  /** @brief Create an object to manage several smôl Power Boards */
+  sfeSmolPowerBoardManager() {}
+
+  bool addBoard(smolPowerAAA &board); // Add a board. Call begin for the board first
+#ifdef SFE_SMOL_POWER_TRANSPORT_TWOWIRE
+  bool addBoard(smolPowerLiPo &board);
+#endif
+  byte getNumberOfBoards();
+
+  bool startAll(sfe_power_board_measurement_e measurement); // Start the measurement on every board
+  bool pollAll(); // Service the measurements. Returns true when every board has finished
+  bool measureAll(sfe_power_board_measurement_e measurement); // Start, then wait for every board to finish. Returns true if every board succeeded
+
+#ifndef SFE_SMOL_POWER_DISABLE_FLOAT
+  float getResult(byte index); // The latest result for a board. -273.15 or -99.0 if its measurement failed
+#endif
+  int32_t getFixedPointResult(byte index); // The latest result for a board in centi-°C or mV. -27315 or 0 if its measurement failed
+  bool getHealth(byte index, sfe_power_board_health_t &health);
+  bool isHealthy(byte index); // True if the board has fewer than SFE_SMOL_POWER_MANAGER_UNHEALTHY_FAILURES consecutive failures
+  void resetHealth();
+
+private:
+  bool addBoard(sfeSmolPowerBoard *board, sfe_power_board_type_e type);
+
+  sfeSmolPowerBoard *_boards[SFE_SMOL_POWER_MANAGER_MAX_BOARDS];
+  sfe_power_board_type_e _types[SFE_SMOL_POWER_MANAGER_MAX_BOARDS];
+  bool _pending[SFE_SMOL_POWER_MANAGER_MAX_BOARDS];
+  int32_t _results[SFE_SMOL_POWER_MANAGER_MAX_BOARDS]; // centi-°C or mV
+  bool _succeeded[SFE_SMOL_POWER_MANAGER_MAX_BOARDS];
+  sfe_power_board_measurement_e _measurement = SFE_SMOL_POWER_MEASUREMENT_NONE;
+  sfe_power_board_health_t _health[SFE_SMOL_POWER_MANAGER_MAX_BOARDS];
+  byte _numBoards = 0;
+  bool _allSucceeded;
+};
+
+#endif // /__SFE_SMOL_POWER_BOARD_MANAGER__
@@ -0,0 +1,113 @@
+/*!
+ * @file SparkFun_smol_Power_Board_Platform.cpp
+ * 
+ * @mainpage SparkFun smôl Power Board Arduino Library
+ * 
+ * @section intro_sec Introduction
+ * 
+ * This library facilitates communication with the smôl Power Board over I<sup>2</sup>C.
+ * 
+ * Want to support open source hardware? Buy a board from SparkFun!
+ * <br>SparkX smôl Power Board LiPo (SPX-18622): https://www.sparkfun.com/products/18622
+ * <br>SparkX smôl Power Board AAA (SPX-18621): https://www.sparkfun.com/products/18621
+ * <br>SparkX smôl ESP32 (SPX-18619): https://www.sparkfun.com/products/18619
+ * 
+ * @section author Author
+ * 
+ * This library was written by:
+ * Paul Clark
+ * SparkFun Electronics
+ * July 23rd 2021
+ * 
+ * @section license License
+ * 
+ * MIT: please see LICENSE.md for the full license information
+ * 
+ */
+
+#include "SparkFun_smol_Power_Board_Platform.h"
+
+#if !defined(ARDUINO) // Arduino provides millis and delay
+
+#ifdef SFE_SMOL_POWER_SIMULATED_CLOCK
+
+static unsigned long simulatedMillis = 0;
+
+/**************************************************************************/
+/*!
+    @brief  The simulated clock.
+    @return The simulated time in ms.
+*/
+/**************************************************************************/
+unsigned long millis()
+{
+  return (simulatedMillis);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Advance the simulated clock instantly.
+    @param  ms
+            The delay in ms.
+*/
+/**************************************************************************/
+void delay(unsigned long ms)
+{
+  simulatedMillis += ms;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Advance the simulated clock, e.g. to model time passing between calls.
+    @param  ms
+            The time in ms.
+*/
+/**************************************************************************/
+void sfeSmolPowerAdvanceClock(unsigned long ms)
+{
+  simulatedMillis += ms;
+}
+
+#else
+
+#include <time.h>
+
+/**************************************************************************/
+/*!
+    @brief  The time since the first call, from the monotonic clock.
+    @return The time in ms.
+*/
+/**************************************************************************/
+unsigned long millis()
+{
+  static struct timespec start;
+  static bool started = false;
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  if (!started)
+  {
+    start = now;
+    started = true;
+  }
+  return ((unsigned long)(((now.tv_sec - start.tv_sec) * 1000) + ((now.tv_nsec - start.tv_nsec) / 1000000)));
+}
+
+/**************************************************************************/
+/*!
+    @brief  Sleep for ms milliseconds.
+    @param  ms
+            The delay in ms.
+*/
+/**************************************************************************/
+void delay(unsigned long ms)
+{
+  struct timespec request;
+  request.tv_sec = ms / 1000;
+  request.tv_nsec = (long)(ms % 1000) * 1000000;
+  while (nanosleep(&request, &request) != 0)
+    ; // Interrupted by a signal. Sleep for the remainder
+}
+
+#endif
+
+#endif
@@ -0,0 +1,53 @@
+/*!
+ * @file SparkFun_smol_Power_Board_Platform.h
+ *
+ * SparkFun smôl Power Board Arduino Library
+ *
+ * This library facilitates communication with the smôl Power Boards over I<sup>2</sup>C.
+ *
+ * Want to support open source hardware? Buy a board from SparkFun!
+ * <br>SparkX smôl Power Board LiPo (SPX-18622): https://www.sparkfun.com/products/18622
+ * <br>SparkX smôl Power Board AAA (SPX-18621): https://www.sparkfun.com/products/18621
+ * <br>SparkX smôl ESP32 (SPX-18619): https://www.sparkfun.com/products/18619
+ *
+ * This library was written by:
+ * Paul Clark
+ * SparkFun Electronics
+ * July 23rd 2021
+ *
+ * Please see LICENSE.md for the license information
+ *
+ */
+
+#ifndef __SFE_SMOL_POWER_BOARD_PLATFORM__
+#define __SFE_SMOL_POWER_BOARD_PLATFORM__
+
+/** The library only needs byte, millis and delay from the platform.
+    On Arduino these come from Arduino.h. Wire.h is included first so its I2C_BUFFER_LENGTH is used. On other hosts (e.g. a Linux gateway, or a test build
+    using the mock transport) they are provided here, and implemented in SparkFun_smol_Power_Board_Platform.cpp */
+
+#if defined(ARDUINO)
+
+#include <Arduino.h>
+#include <Wire.h> // Needed for the TwoWire transport and I2C_BUFFER_LENGTH
+
+#else
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+typedef uint8_t byte;
+
+unsigned long millis();
+void delay(unsigned long ms);
+
+//Define SFE_SMOL_POWER_SIMULATED_CLOCK to make millis a simulated clock: delay advances it instantly.
+//Use sfeSmolPowerAdvanceClock to advance it from a test.
+#ifdef SFE_SMOL_POWER_SIMULATED_CLOCK
+void sfeSmolPowerAdvanceClock(unsigned long ms);
+#endif
+
+#endif
+
+#endif // /__SFE_SMOL_POWER_BOARD_PLATFORM__
@@ -0,0 +1,129 @@
+/*!
+ * @file SparkFun_smol_Power_Board_Registers.h
+ *
+ * SparkFun smôl Power Board Arduino Library
+ *
+ * This library facilitates communication with the smôl Power Board over I<sup>2</sup>C.
+ *
+ * Want to support open source hardware? Buy a board from SparkFun!
+ * <br>SparkX smôl Power Board LiPo (SPX-18622): https://www.sparkfun.com/products/18622
+ * <br>SparkX smôl Power Board AAA (SPX-18621): https://www.sparkfun.com/products/18621
+ * <br>SparkX smôl ESP32 (SPX-18619): https://www.sparkfun.com/products/18619
+ *
+ * This library was written by:
+ * Paul Clark
+ * SparkFun Electronics
+ * July 23rd 2021
+ *
+ * Please see LICENSE.md for the license information
+ *
+ */
+
+#ifndef __SFE_SMOL_POWER_BOARD_REGISTERS__
+#define __SFE_SMOL_POWER_BOARD_REGISTERS__
+
+#include "SparkFun_smol_Power_Board_Platform.h" // Includes Wire.h on Arduino, for I2C_BUFFER_LENGTH
+
+#include "SparkFun_smol_Power_Board_Constants.h"
+
+//-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
+/** Compile-time CRC8: x^8+x^5+x^4+1 = 0x31, initialised with 0xFF, no reflection. Gives the same result as sfeSmolPowerBoard::computeCRC8 */
+constexpr byte sfeSmolPowerCRC8Bits(byte crc, byte bits = 8)
+{
+  return ((bits == 0) ? crc : sfeSmolPowerCRC8Bits(((crc & 0x80) != 0) ? (byte)((crc << 1) ^ 0x31) : (byte)(crc << 1), bits - 1));
+}
+
+/** Compile-time CRC8 of an array of bytes or characters */
+template <typename T>
+constexpr byte sfeSmolPowerCRC8(const T *data, byte len, byte crc = 0xFF)
+{
+  return ((len == 0) ? crc : sfeSmolPowerCRC8(data + 1, len - 1, sfeSmolPowerCRC8Bits(crc ^ (byte)*data)));
+}
+
+/** Compile-time CRC8 of a parameter pack of bytes */
+constexpr byte sfeSmolPowerCRC8Pack(byte crc)
+{
+  return (crc);
+}
+template <typename... T>
+constexpr byte sfeSmolPowerCRC8Pack(byte crc, byte first, T... rest)
+{
+  return (sfeSmolPowerCRC8Pack(sfeSmolPowerCRC8Bits(crc ^ first), rest...));
+}
+
+//-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
+/** Describes one ATtiny43U register at compile time:
+    its address, payload type, whether writes are protected by a CRC,
+    whether writes update eeprom, and whether reads trigger an ADC conversion.
+    The read and write delays are derived from the description. */
+template <sfe_power_board_registers_e Address, typename Payload, bool CRCProtected, bool EEPROMBacked, bool ADCBacked>
+struct sfeSmolPowerRegister
+{
+  typedef Payload payload_t;
+
+  static constexpr byte address = (byte)Address;
+  static constexpr byte payloadSize = sizeof(Payload);
+  static constexpr byte frameSize = payloadSize + (CRCProtected ? 1 : 0); // The number of bytes written after the register address
+  static constexpr bool crcProtected = CRCProtected;
+  static constexpr byte readDelay = ADCBacked ? SFE_SMOL_POWER_ADC_READ_DELAY : 0; // Wait before reading the data
+  static constexpr byte writeDelay = EEPROMBacked ? SFE_SMOL_POWER_EEPROM_UPDATE_DELAY : 0; // Wait after writing the data
+
+  static_assert((frameSize + 1) <= I2C_BUFFER_LENGTH, "Register frame is larger than I2C_BUFFER_LENGTH");
+
+  /** Write the payload into frame (little endian). The CRC (if any) is not included */
+  static void encode(Payload value, byte *frame)
+  {
+    for (byte i = 0; i < payloadSize; i++)
+      frame[i] = (byte)(value >> (8 * i));
+  }
+
+  /** Read the payload from buffer (little endian) */
+  static Payload decode(const byte *buffer)
+  {
+    Payload value = 0;
+    for (byte i = 0; i < payloadSize; i++)
+      value |= ((Payload)buffer[i]) << (8 * i);
+    return (value);
+  }
+};
+
+/** A constant command frame for a register: the payload bytes followed by their CRC.
+    The frame is built entirely at compile time. */
+template <typename Register, byte... Payload>
+struct sfeSmolPowerConstantFrame
+{
+  static_assert(sizeof...(Payload) == Register::payloadSize, "Constant frame payload does not match the register");
+  static_assert(Register::crcProtected, "Constant frames are only needed for CRC-protected registers");
+
+  static const byte frame[Register::frameSize];
+};
+
+template <typename Register, byte... Payload>
+const byte sfeSmolPowerConstantFrame<Register, Payload...>::frame[Register::frameSize] = {Payload..., sfeSmolPowerCRC8Pack(0xFF, Payload...)};
+
+//-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
+/** The power-down command payload: the ASCII characters SLEEP */
+typedef struct
+{
+  byte command[5];
+} sfe_power_board_sleep_command_t;
+
+/** The ATtiny43U register descriptors (register, payload, CRC-protected, eeprom-backed, ADC-backed) */
+typedef sfeSmolPowerRegister<SFE_SMOL_POWER_REGISTER_I2C_ADDRESS,        byte,     true,  true,  false> sfe_power_board_reg_i2c_address_t;
+typedef sfeSmolPowerRegister<SFE_SMOL_POWER_REGISTER_RESET_REASON,       byte,     false, false, false> sfe_power_board_reg_reset_reason_t;
+typedef sfeSmolPowerRegister<SFE_SMOL_POWER_REGISTER_TEMPERATURE,        uint16_t, false, false, true>  sfe_power_board_reg_temperature_t;
+typedef sfeSmolPowerRegister<SFE_SMOL_POWER_REGISTER_VBAT,               uint16_t, false, false, true>  sfe_power_board_reg_vbat_t;
+typedef sfeSmolPowerRegister<SFE_SMOL_POWER_REGISTER_1V1,                uint16_t, false, false, true>  sfe_power_board_reg_1v1_t;
+typedef sfeSmolPowerRegister<SFE_SMOL_POWER_REGISTER_ADC_REFERENCE,      byte,     true,  true,  false> sfe_power_board_reg_adc_reference_t;
+typedef sfeSmolPowerRegister<SFE_SMOL_POWER_REGISTER_WDT_PRESCALER,      byte,     true,  true,  false> sfe_power_board_reg_wdt_prescaler_t;
+typedef sfeSmolPowerRegister<SFE_SMOL_POWER_REGISTER_POWERDOWN_DURATION, uint16_t, true,  true,  false> sfe_power_board_reg_powerdown_duration_t;
+typedef sfeSmolPowerRegister<SFE_SMOL_POWER_REGISTER_POWERDOWN_NOW,      sfe_power_board_sleep_command_t, true, false, false> sfe_power_board_reg_powerdown_now_t;
+typedef sfeSmolPowerRegister<SFE_SMOL_POWER_REGISTER_FIRMWARE_VERSION,   byte,     false, false, false> sfe_power_board_reg_firmware_version_t;
+
+/** The power-down command frame: SLEEP followed by its CRC */
+typedef sfeSmolPowerConstantFrame<sfe_power_board_reg_powerdown_now_t, 'S', 'L', 'E', 'E', 'P'> sfe_power_board_sleep_frame_t;
+
+#endif // /__SFE_SMOL_POWER_BOARD_REGISTERS__
@@ -0,0 +1,308 @@
+/*!
+ * @file SparkFun_smol_Power_Board_Runtime.h
+ *
+ * SparkFun smôl Power Board Arduino Library
+ *
+ * This library facilitates communication with the smôl Power Boards over I<sup>2</sup>C.
+ *
+ * Want to support open source hardware? Buy a board from SparkFun!
+ * <br>SparkX smôl Power Board LiPo (SPX-18622): https://www.sparkfun.com/products/18622
+ * <br>SparkX smôl Power Board AAA (SPX-18621): https://www.sparkfun.com/products/18621
+ * <br>SparkX smôl ESP32 (SPX-18619): https://www.sparkfun.com/products/18619
+ *
+ * This library was written by:
+ * Paul Clark
+ * SparkFun Electronics
+ * July 23rd 2021
+ *
+ * Please see LICENSE.md for the license information
+ *
+ */
+
+#ifndef __SFE_SMOL_POWER_BOARD_RUNTIME__
+#define __SFE_SMOL_POWER_BOARD_RUNTIME__
+
+#include "SparkFun_smol_Power_Board_Platform.h"
+
+#include "SparkFun_smol_Power_Board.h"
+
+/** Online time-to-empty estimator.
+    Each sample is converted to the remaining capacity (0.01%). A least-squares line is fitted
+    to the last Window samples; its slope is the discharge rate. The regression sums are held
+    as exact 64-bit integers and are updated as each sample enters and leaves the window,
+    so each update is O(1) and integer-only.
+
+    AAA: battery voltages are mapped to capacity with a discharge curve (alkaline by default).
+    LiPo: the MAX17048 state of charge is used directly, and its change rate gives the discharge rate.
+    The regression then only provides the confidence.
+
+    Window must be 3 to 64. The window must span less than about 100 days. */
+template <byte Window = 16>
+class sfeSmolPowerRuntime
+{
+  static_assert(Window >= 3, "sfeSmolPowerRuntime needs at least three samples to estimate a slope and a confidence");
+  static_assert(Window <= 64, "sfeSmolPowerRuntime Window must be no more than 64, so the sums cannot overflow");
+
+public:
+  /** @brief Create an empty estimator which uses the alkaline AAA discharge curve */
+  sfeSmolPowerRuntime() { setDischargeCurve(alkalineAAACurve(), alkalineAAAPoints); }
+
+  /** An approximate discharge curve for a single alkaline AAA cell at low current */
+  static const sfe_power_board_discharge_point_t *alkalineAAACurve()
+  {
+    static const sfe_power_board_discharge_point_t curve[alkalineAAAPoints] = {
+        {1580, 10000}, {1450, 8000}, {1350, 6000}, {1270, 4000}, {1200, 2000}, {1100, 1000}, {1000, 300}, {900, 0}};
+    return (curve);
+  }
+  static const byte alkalineAAAPoints = 8;
+
+  /** Change the voltage-to-capacity curve used by addMillivolts. The curve must be sorted by descending voltage
+      and must stay in memory while the estimator is used. The samples are discarded */
+  void setDischargeCurve(const sfe_power_board_discharge_point_t *curve, byte points)
+  {
+    _curve = curve;
+    _curvePoints = points;
+    clear();
+  }
+
+  /** Map a battery voltage to the remaining capacity in 0.01%, interpolating the discharge curve */
+  uint16_t capacityFromMillivolts(uint16_t millivolts)
+  {
+    if ((_curve == nullptr) || (_curvePoints == 0))
+      return (0);
+    if (millivolts >= _curve[0].millivolts)
+      return (_curve[0].capacity);
+    for (byte i = 1; i < _curvePoints; i++)
+    {
+      if (millivolts >= _curve[i].millivolts)
+      {
+        const sfe_power_board_discharge_point_t &upper = _curve[i - 1];
+        const sfe_power_board_discharge_point_t &lower = _curve[i];
+        return ((uint16_t)(lower.capacity + (((uint32_t)(millivolts - lower.millivolts)) * (upper.capacity - lower.capacity))
+                                               / (upper.millivolts - lower.millivolts)));
+      }
+    }
+    return (_curve[_curvePoints - 1].capacity);
+  }
+
+  /** Read the battery voltage from the AAA board and add it. Returns false if the read fails */
+  bool sample(smolPowerAAA &board)
+  {
+    uint16_t millivolts = board.getBatteryMillivolts();
+    if (millivolts == 0)
+      return (false);
+    addMillivolts(millis(), millivolts);
+    return (true);
+  }
+
+#ifdef SFE_SMOL_POWER_TRANSPORT_TWOWIRE
+  /** Read the state of charge and change rate from the LiPo board's fuel gauge and add them. Returns false if the read fails.
+      The MAX1704x library returns 0 when a read fails, and 0% is a valid state of charge, so the battery voltage
+      (never 0 while the board is running) is read first to check that the fuel gauge is responding */
+  bool sample(smolPowerLiPo &board)
+  {
+    if (board.getBatteryMillivolts() == 0)
+      return (false);
+    addChangeRate(millis(), board.getSOCCentiPercent(), board.getChangeRateCentiPercentPerHour());
+    return (true);
+  }
+#endif
+
+  /** Add a battery voltage. The capacity comes from the discharge curve. O(1) */
+  void addMillivolts(unsigned long sampleMillis, uint16_t millivolts)
+  {
+    addCapacity(sampleMillis, capacityFromMillivolts(millivolts));
+  }
+
+  /** Add a fuel gauge state of charge and change rate. The change rate is used for the discharge rate. O(1) */
+  void addChangeRate(unsigned long sampleMillis, uint16_t capacity, int32_t rateCentiPercentPerHour)
+  {
+    addCapacity(sampleMillis, capacity);
+    _gaugeRate = rateCentiPercentPerHour;
+    _useGaugeRate = true;
+  }
+
+  /** Add a remaining capacity in 0.01%. When the window is full, the oldest sample is discarded. O(1) */
+  void addCapacity(unsigned long sampleMillis, uint16_t capacity)
+  {
+    if (capacity > SFE_SMOL_POWER_CAPACITY_FULL)
+      capacity = SFE_SMOL_POWER_CAPACITY_FULL;
+
+    if (_count > 0)
+    {
+      // The times are held relative to the newest sample. Move the origin forward to this sample
+      unsigned long elapsed = sampleMillis - _lastMillis + _remainderMS;
+      int64_t dt = elapsed / 1000;
+      _remainderMS = elapsed % 1000;
+      _sumTT += (dt * dt * _count) - (2 * dt * _sumT);
+      _sumTY -= dt * _sumY;
+      _sumT -= dt * _count;
+      _seconds += (unsigned long)dt;
+    }
+    _lastMillis = sampleMillis;
+
+    if (_count == Window) // Remove the oldest sample
+    {
+      int64_t t = (int32_t)(_sampleSeconds[_next] - _seconds); // Negative
+      int64_t y = _capacity[_next];
+      _sumT -= t;
+      _sumTT -= t * t;
+      _sumY -= y;
+      _sumTY -= t * y;
+      _sumYY -= y * y;
+      _count--;
+    }
+
+    // Add the new sample at t = 0
+    _sampleSeconds[_next] = _seconds;
+    _capacity[_next] = capacity;
+    _newest = capacity;
+    _sumY += capacity;
+    _sumYY += ((int64_t)capacity) * capacity;
+    _count++;
+    _next = (_next == (Window - 1)) ? 0 : (_next + 1);
+  }
+
+  /** Estimate the remaining runtime. O(1). Returns false if there are too few samples to estimate the discharge rate */
+  bool getEstimate(sfe_power_board_runtime_t &estimate)
+  {
+    estimate.secondsRemaining = SFE_SMOL_POWER_RUNTIME_UNKNOWN;
+    estimate.confidence = 0;
+    estimate.capacity = _newest;
+    estimate.rateCentiPercentPerHour = 0;
+
+    int64_t n = _count;
+    int64_t b = (n * _sumTT) - (_sumT * _sumT); // n^2 * the variance of t
+    int64_t a = (n * _sumTY) - (_sumT * _sumY); // n^2 * the covariance of t and capacity
+    int64_t c = (n * _sumYY) - (_sumY * _sumY); // n^2 * the variance of capacity
+    bool fitted = ((_count >= 3) && (b > 0));
+
+    if (fitted)
+      estimate.confidence = (byte)((rSquaredPercent(a, b, c) * _count) / Window);
+
+    if (_useGaugeRate)
+    {
+      if (_count == 0)
+        return (false);
+      estimate.rateCentiPercentPerHour = _gaugeRate;
+      if (_gaugeRate < 0)
+        estimate.secondsRemaining = limitSeconds((((int64_t)estimate.capacity) * 3600) / (-_gaugeRate));
+      return (true);
+    }
+
+    if (!fitted)
+      return (false);
+
+    int64_t capacity = (_sumY - scaledRatio(_sumT, a, b)) / n; // The fitted capacity now
+    if (capacity < 0)
+      capacity = 0;
+    if (capacity > SFE_SMOL_POWER_CAPACITY_FULL)
+      capacity = SFE_SMOL_POWER_CAPACITY_FULL;
+    estimate.capacity = (uint16_t)capacity;
+    estimate.rateCentiPercentPerHour = (int32_t)scaledRatio(3600, a, b);
+    if (a < 0) // Discharging
+      estimate.secondsRemaining = limitSeconds(scaledRatio(capacity, b, -a));
+    return (true);
+  }
+
+  /** Discard all samples */
+  void clear()
+  {
+    _count = 0;
+    _next = 0;
+    _seconds = 0;
+    _remainderMS = 0;
+    _sumT = _sumTT = _sumY = _sumTY = _sumYY = 0;
+    _useGaugeRate = false;
+  }
+
+  /** The number of samples in the window */
+  byte available() { return (_count); }
+
+private:
+  /** x * num / den, without overflowing. num and den are reduced together if needed */
+  static int64_t scaledRatio(int64_t x, int64_t num, int64_t den)
+  {
+    uint64_t absX = (x < 0) ? -x : x;
+    if (absX > 0)
+    {
+      while ((uint64_t)((num < 0) ? -num : num) > (((uint64_t)0x3FFFFFFFFFFFFFFF) / absX))
+      {
+        num /= 2;
+        den /= 2;
+      }
+    }
+    if (den == 0)
+      return (0);
+    return ((x * num) / den);
+  }
+
+  /** R^2 = a^2 / (b * c) as a percentage. b and c are reduced to 15 bits, and a by half as many bits */
+  static byte rSquaredPercent(int64_t a, int64_t b, int64_t c)
+  {
+    if ((b <= 0) || (c <= 0))
+      return (0);
+    uint64_t absA = (a < 0) ? -a : a;
+    uint64_t absB = b;
+    uint64_t absC = c;
+    byte shifts = 0;
+    while (absB > 0x7FFF)
+    {
+      absB >>= 1;
+      shifts++;
+    }
+    while (absC > 0x7FFF)
+    {
+      absC >>= 1;
+      shifts++;
+    }
+    if (shifts & 1) // a needs an even number of shifts in b and c
+    {
+      if (absB > absC)
+        absB >>= 1;
+      else
+        absC >>= 1;
+      shifts++;
+    }
+    absA >>= (shifts >> 1);
+    uint64_t denominator = absB * absC;
+    if (denominator == 0)
+      return (0);
+    uint64_t result = (absA * absA * 100) / denominator;
+    return ((result > 100) ? 100 : (byte)result);
+  }
+
+  static unsigned long limitSeconds(int64_t seconds)
+  {
+    if (seconds >= (int64_t)SFE_SMOL_POWER_RUNTIME_UNKNOWN)
+      return (SFE_SMOL_POWER_RUNTIME_UNKNOWN - 1);
+    return ((seconds < 0) ? 0 : (unsigned long)seconds);
+  }
+
+  const sfe_power_board_discharge_point_t *_curve = nullptr;
+  byte _curvePoints = 0;
+
+  // The window. Times are whole seconds from a running counter
+  unsigned long _sampleSeconds[Window];
+  uint16_t _capacity[Window];
+  byte _count = 0;
+  byte _next = 0; // The index for the next sample
+  uint16_t _newest = 0;
+
+  unsigned long _seconds = 0; // The time of the newest sample
+  unsigned long _lastMillis = 0;
+  unsigned long _remainderMS = 0; // The part-second carried to the next sample
+
+  // The regression sums, with t relative to the newest sample
+  int64_t _sumT = 0;
+  int64_t _sumTT = 0;
+  int64_t _sumY = 0;
+  int64_t _sumTY = 0;
+  int64_t _sumYY = 0;
+
+  // LiPo: the MAX17048 change rate
+  int32_t _gaugeRate = 0;
+  bool _useGaugeRate = false;
+};
+
+#endif // /__SFE_SMOL_POWER_BOARD_RUNTIME__
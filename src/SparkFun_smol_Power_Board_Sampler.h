@@ -0,0 +1,163 @@
+/*!
+ * @file SparkFun_smol_Power_Board_Sampler.h
+ *
+ * SparkFun smôl Power Board Arduino Library
+ *
+ * This library facilitates communication with the smôl Power Boards over I<sup>2</sup>C.
+ *
+ * Want to support open source hardware? Buy a board from SparkFun!
+ * <br>SparkX smôl Power Board LiPo (SPX-18622): https://www.sparkfun.com/products/18622
+ * <br>SparkX smôl Power Board AAA (SPX-18621): https://www.sparkfun.com/products/18621
+ * <br>SparkX smôl ESP32 (SPX-18619): https://www.sparkfun.com/products/18619
+ *
+ * This library was written by:
+ * Paul Clark
+ * SparkFun Electronics
+ * July 23rd 2021
+ *
+ * Please see LICENSE.md for the license information
+ *
+ */
+
+#ifndef __SFE_SMOL_POWER_BOARD_SAMPLER__
+#define __SFE_SMOL_POWER_BOARD_SAMPLER__
+
+#include "SparkFun_smol_Power_Board_Platform.h"
+
+#include "SparkFun_smol_Power_Board.h"
+
+/** Background sampler. One reader samples the board (getTelemetry) at a fixed interval
+    and publishes the latest values. Any number of readers - other tasks, or interrupt handlers - can then
+    call getLatest, which never touches the bus. The bus load does not depend on the number of readers.
+
+    The values are published through a seqlock over two buffers: tick writes the buffer which is not
+    being read, then increments the sequence. getLatest copies the newest buffer and only retries if a
+    new sample was published during the copy. It never waits for the sampler, so it is safe to call
+    from an interrupt handler which has interrupted tick.
+
+    Call tick from loop (it blocks while the sample is taken, ~38ms), or on ESP32 call startTask to
+    sample from a FreeRTOS task. Board is smolPowerAAA or smolPowerLiPo. */
+template <class Board>
+class sfeSmolPowerSampler
+{
+public:
+  /** @brief Create a sampler. Call begin before tick or startTask */
+  sfeSmolPowerSampler() {}
+
+  /** Sample board every intervalMS. The first tick samples immediately */
+  void begin(Board &board, unsigned long intervalMS = 1000)
+  {
+    _board = &board;
+    _intervalMS = intervalMS;
+    _nextMillis = millis();
+    _due = true;
+  }
+
+  /** Change the sampling interval. Takes effect after the next sample */
+  void setInterval(unsigned long intervalMS) { _intervalMS = intervalMS; }
+
+  /** Take and publish a sample if one is due. Returns true if a new sample was published */
+  bool tick()
+  {
+    if ((_board == nullptr) || (!_due && ((long)(millis() - _nextMillis) < 0)))
+      return (false);
+    _due = false;
+    _nextMillis += _intervalMS;
+    if ((long)(millis() - _nextMillis) >= 0) // We have fallen behind. Don't try to catch up
+      _nextMillis = millis() + _intervalMS;
+    return (sampleNow());
+  }
+
+  /** Take and publish a sample now. Returns false if the read failed: the previous sample is kept */
+  bool sampleNow()
+  {
+    sfe_power_board_telemetry_t telemetry;
+    if ((_board == nullptr) || !_board->getTelemetry(telemetry))
+    {
+      _errors++;
+      return (false);
+    }
+    unsigned long next = _sequence + 1;
+    sfe_power_board_sample_t &sample = _samples[next & 1]; // The buffer which readers are not using
+    sample.millis = millis();
+    sample.count = _count + 1;
+    sample.temperatureCentiC = telemetry.temperatureCentiC;
+    sample.batteryMillivolts = telemetry.batteryMillivolts;
+    sample.vccMillivolts = telemetry.vccMillivolts;
+    __atomic_thread_fence(__ATOMIC_SEQ_CST); // The sample must be complete before it is published
+    _sequence = next;
+    _count++;
+    return (true);
+  }
+
+  /** Copy the latest sample. Never touches the bus. Returns false if nothing has been published yet */
+  bool getLatest(sfe_power_board_sample_t &sample) const
+  {
+    while (true)
+    {
+      unsigned long sequence = _sequence;
+      __atomic_thread_fence(__ATOMIC_SEQ_CST);
+      sample = _samples[sequence & 1];
+      __atomic_thread_fence(__ATOMIC_SEQ_CST);
+      if (sequence == _sequence) // Nothing was published during the copy
+        return (sample.count > 0);
+    }
+  }
+
+  /** The time until the next sample is due, in ms */
+  unsigned long getWaitRemaining()
+  {
+    long remaining = (long)(_nextMillis - millis());
+    return ((_due || (remaining < 0)) ? 0 : (unsigned long)remaining);
+  }
+
+  /** The number of samples which could not be read */
+  unsigned long getErrors() { return (_errors); }
+
+#if defined(ARDUINO_ARCH_ESP32)
+  /** Sample from a FreeRTOS task. With a bus lock (setBusLock), other tasks can use the bus during the ADC wait.
+      Returns false if the task could not be created */
+  bool startTask(uint32_t stackSize = 4096, UBaseType_t priority = 1, BaseType_t core = tskNO_AFFINITY)
+  {
+    if (_task != nullptr)
+      return (true);
+    _stopTask = false;
+    return (xTaskCreatePinnedToCore(samplerTask, "smolPowerSampler", stackSize, this, priority, &_task, core) == pdPASS);
+  }
+
+  /** Stop the task after the current sample */
+  void stopTask() { _stopTask = true; }
+#endif
+
+private:
+#if defined(ARDUINO_ARCH_ESP32)
+  static void samplerTask(void *context)
+  {
+    sfeSmolPowerSampler *sampler = (sfeSmolPowerSampler *)context;
+    while (!sampler->_stopTask)
+    {
+      sampler->tick();
+      TickType_t ticks = pdMS_TO_TICKS(sampler->getWaitRemaining());
+      vTaskDelay((ticks > 0) ? ticks : 1);
+    }
+    sampler->_task = nullptr;
+    vTaskDelete(NULL);
+  }
+
+  TaskHandle_t _task = nullptr;
+  volatile bool _stopTask = false;
+#endif
+
+  Board *_board = nullptr;
+  unsigned long _intervalMS = 1000;
+  unsigned long _nextMillis = 0;
+  bool _due = false;
+  unsigned long _count = 0;
+  unsigned long _errors = 0;
+
+  // The seqlock. The newest sample is _samples[_sequence & 1]
+  sfe_power_board_sample_t _samples[2] = {};
+  volatile unsigned long _sequence = 0;
+};
+
+#endif // /__SFE_SMOL_POWER_BOARD_SAMPLER__
@@ -0,0 +1,191 @@
+/*!
+ * @file SparkFun_smol_Power_Board_Scheduler.h
+ *
+ * SparkFun smôl Power Board Arduino Library
+ *
+ * This library facilitates communication with the smôl Power Boards over I<sup>2</sup>C.
+ *
+ * Want to support open source hardware? Buy a board from SparkFun!
+ * <br>SparkX smôl Power Board LiPo (SPX-18622): https://www.sparkfun.com/products/18622
+ * <br>SparkX smôl Power Board AAA (SPX-18621): https://www.sparkfun.com/products/18621
+ * <br>SparkX smôl ESP32 (SPX-18619): https://www.sparkfun.com/products/18619
+ *
+ * This library was written by:
+ * Paul Clark
+ * SparkFun Electronics
+ * July 23rd 2021
+ *
+ * Please see LICENSE.md for the license information
+ *
+ */
+
+#ifndef __SFE_SMOL_POWER_BOARD_SCHEDULER__
+#define __SFE_SMOL_POWER_BOARD_SCHEDULER__
+
+#include "SparkFun_smol_Power_Board_Platform.h"
+
+#include "SparkFun_smol_Power_Board.h"
+
+/** Energy-budget duty-cycle scheduler. Chooses the next sleep interval before each power-down.
+
+    Lifetime mode (setTargetLifetime): the discharge rate is measured each time the capacity drops by
+    SFE_SMOL_POWER_SCHEDULE_MIN_DROP. Most of the energy is used while awake, so the rate scales with
+    1 / (the wake cycle length). The cycle is stretched if the battery would run out before the target,
+    and shortened if there is headroom. Each measurement changes the cycle by no more than 2x.
+
+    Reporting-rate mode (target lifetime 0): the sleep interval stretches from the minimum at high
+    capacity to the maximum (the minimum reporting rate) at low capacity.
+
+    Either way, the sleep interval is limited by setSleepLimits and rounded to what the WDT can achieve.
+    nextSleepMS does not touch the hardware and takes all times as arguments, so it can be run on
+    any host with a simulated clock and discharge model.
+
+    powerDownNow removes the host's power. Save the state (getState) before powering down
+    and restore it (setState) after waking. */
+class sfeSmolPowerScheduler
+{
+public:
+  /** @brief Create a scheduler in reporting-rate mode, sleeping between 1s and 1 hour */
+  sfeSmolPowerScheduler() { reset(); }
+
+  /** The shortest and longest sleep intervals. maxSleepMS sets the minimum reporting rate */
+  void setSleepLimits(unsigned long minSleepMS, unsigned long maxSleepMS)
+  {
+    _minSleepMS = (minSleepMS < maxSleepMS) ? minSleepMS : maxSleepMS;
+    _maxSleepMS = (minSleepMS < maxSleepMS) ? maxSleepMS : minSleepMS;
+  }
+
+  /** Make the battery last this many seconds from the start of the schedule. 0 selects reporting-rate mode */
+  void setTargetLifetime(unsigned long seconds) { _targetSeconds = seconds; }
+
+  /** Reporting-rate mode: sleep for the minimum at or above highCapacity, the maximum at or below lowCapacity (0.01%) */
+  void setCapacityLimits(uint16_t lowCapacity, uint16_t highCapacity)
+  {
+    _lowCapacity = (lowCapacity < highCapacity) ? lowCapacity : highCapacity;
+    _highCapacity = (lowCapacity < highCapacity) ? highCapacity : lowCapacity;
+  }
+
+  /** Choose the next sleep interval. awakeMS is how long the node has been awake since the last sleep.
+      capacity is the measured remaining capacity in 0.01% (e.g. from sfeSmolPowerRuntime or the fuel gauge).
+      Returns the sleep interval in ms, as the WDT will achieve it */
+  unsigned long nextSleepMS(unsigned long awakeMS, uint16_t capacity)
+  {
+    if (capacity > SFE_SMOL_POWER_CAPACITY_FULL)
+      capacity = SFE_SMOL_POWER_CAPACITY_FULL;
+
+    // Account for the last cycle
+    unsigned long cycleMS = _state.elapsedRemainderMS + awakeMS;
+    unsigned long sleepMS = _state.sleepMS;
+    if (sleepMS == 0) // The first cycle
+      sleepMS = _minSleepMS; // Start short: the discharge rate is measured sooner
+    else
+    {
+      _state.elapsedSeconds += _state.sleepMS / 1000;
+      cycleMS += _state.sleepMS % 1000;
+      if (_state.cycles < 0xFFFF)
+        _state.cycles++;
+    }
+    _state.elapsedSeconds += cycleMS / 1000;
+    _state.elapsedRemainderMS = cycleMS % 1000;
+
+    if ((_state.referenceCapacity == SFE_SMOL_POWER_SCHEDULE_NO_CAPACITY) || (capacity > _state.referenceCapacity))
+      startMeasurement(capacity); // The first measurement, or the battery has been charged
+
+    if (_targetSeconds == 0) // Reporting-rate mode
+    {
+      if (capacity >= _highCapacity)
+        sleepMS = _minSleepMS;
+      else if (capacity <= _lowCapacity)
+        sleepMS = _maxSleepMS;
+      else
+        sleepMS = _maxSleepMS - (unsigned long)((((uint64_t)(_maxSleepMS - _minSleepMS)) * (capacity - _lowCapacity)) / (_highCapacity - _lowCapacity));
+    }
+    else if ((_state.referenceCapacity - capacity) >= SFE_SMOL_POWER_SCHEDULE_MIN_DROP)
+    {
+      unsigned long measuredSeconds = _state.elapsedSeconds - _state.referenceSeconds;
+      unsigned long remainingSeconds = (_targetSeconds > _state.elapsedSeconds) ? (_targetSeconds - _state.elapsedSeconds) : 0;
+      if ((remainingSeconds == 0) || (capacity == 0))
+        sleepMS = _maxSleepMS; // Past the target, or empty: last as long as possible
+      else if ((measuredSeconds > 0) && (_state.cycles > 0))
+      {
+        // The cycle length needed = the average cycle * (the measured rate / the required rate)
+        // = the average cycle * (drop / measuredSeconds) / (capacity / remainingSeconds). Held in Q16
+        uint64_t averageCycleMS = (((uint64_t)measuredSeconds) * 1000) / _state.cycles;
+        uint64_t factor = ((((uint64_t)(_state.referenceCapacity - capacity)) * remainingSeconds) << 16) / (((uint64_t)measuredSeconds) * capacity);
+        if (factor > (((uint64_t)1) << 17)) // Change by no more than 2x per measurement
+          factor = ((uint64_t)1) << 17;
+        if (factor < (((uint64_t)1) << 15))
+          factor = ((uint64_t)1) << 15;
+        uint64_t neededCycleMS = (averageCycleMS * factor) >> 16;
+        sleepMS = (neededCycleMS > awakeMS) ? limitMS(neededCycleMS - awakeMS) : 0;
+      }
+      startMeasurement(capacity);
+    }
+
+    if (sleepMS < _minSleepMS)
+      sleepMS = _minSleepMS;
+    if (sleepMS > _maxSleepMS)
+      sleepMS = _maxSleepMS;
+
+    // What the WDT will achieve. powerDownFor plans again from the returned interval, and the tolerance
+    // may then allow a longer prescaler (e.g. 1472ms = 23 x 64ms becomes 3 x 500ms). Repeat until the plan is stable
+    sfe_power_board_powerdown_plan_t plan;
+    for (byte i = 0; (i < 4) && sfeSmolPowerBoard::planPowerDown(sleepMS, plan) && (plan.durationMS != sleepMS); i++)
+      sleepMS = plan.durationMS;
+
+    _state.sleepMS = sleepMS;
+    return (sleepMS);
+  }
+
+  /** Choose the next sleep interval and power down. The node has been awake since boot (or the last call).
+      Use this if the state is held in memory which survives the power-down. Otherwise call nextSleepMS,
+      save the state, then call powerDownFor. Returns false if the power-down failed */
+  bool sleep(sfeSmolPowerBoard &board, uint16_t capacity, sfe_power_board_powerdown_plan_t *plan = NULL)
+  {
+    unsigned long sleepMS = nextSleepMS(millis() - _wakeMillis, capacity);
+    _wakeMillis = millis();
+    return (board.powerDownFor(sleepMS, plan));
+  }
+
+  /** Copy the state, to save it before powering down */
+  void getState(sfe_power_board_schedule_state_t &state) { state = _state; }
+
+  /** Restore the state after waking */
+  void setState(const sfe_power_board_schedule_state_t &state) { _state = state; }
+
+  /** The time since the schedule started, in seconds */
+  unsigned long getElapsedSeconds() { return (_state.elapsedSeconds); }
+
+  /** Restart the schedule and return to the default settings */
+  void reset()
+  {
+    _minSleepMS = 1000;
+    _maxSleepMS = 3600000;
+    _targetSeconds = 0;
+    _lowCapacity = 1000;
+    _highCapacity = 8000;
+    _wakeMillis = 0;
+    memset(&_state, 0, sizeof(_state));
+    _state.referenceCapacity = SFE_SMOL_POWER_SCHEDULE_NO_CAPACITY;
+  }
+
+private:
+  void startMeasurement(uint16_t capacity)
+  {
+    _state.referenceCapacity = capacity;
+    _state.referenceSeconds = _state.elapsedSeconds;
+    _state.cycles = 0;
+  }
+
+  static unsigned long limitMS(uint64_t ms) { return ((ms > 0xFFFFFFFF) ? 0xFFFFFFFF : (unsigned long)ms); }
+
+  sfe_power_board_schedule_state_t _state;
+  unsigned long _minSleepMS;
+  unsigned long _maxSleepMS;
+  unsigned long _targetSeconds;
+  uint16_t _lowCapacity;
+  uint16_t _highCapacity;
+  unsigned long _wakeMillis; // millis() at the end of the last sleep. 0 after power-down: the host restarts
+};
+
+#endif // /__SFE_SMOL_POWER_BOARD_SCHEDULER__
@@ -0,0 +1,570 @@
+/*!
+ * @file SparkFun_smol_Power_Board_Transport.cpp
+ *
+ * @mainpage SparkFun smôl Power Board Arduino Library
+ *
+ * @section intro_sec Introduction
+ *
+ * This library facilitates communication with the smôl Power Board over I<sup>2</sup>C.
+ *
+ * Want to support open source hardware? Buy a board from SparkFun!
+ * <br>SparkX smôl Power Board LiPo (SPX-18622): https://www.sparkfun.com/products/18622
+ * <br>SparkX smôl Power Board AAA (SPX-18621): https://www.sparkfun.com/products/18621
+ * <br>SparkX smôl ESP32 (SPX-18619): https://www.sparkfun.com/products/18619
+ *
+ * @section author Author
+ *
+ * This library was written by:
+ * Paul Clark
+ * SparkFun Electronics
+ * July 23rd 2021
+ *
+ * @section license License
+ *
+ * MIT: please see LICENSE.md for the full license information
+ *
+ */
+
+#include "SparkFun_smol_Power_Board_Transport.h"
+
+//-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
+#ifdef SFE_SMOL_POWER_MOCK_BOARD
+
+/**************************************************************************/
+/*!
+    @brief  Create a simulated board with typical register values:
+            25C, 1.5V on VBAT (1.1V reference), and v1.0 firmware. Burst reads are disabled.
+    @param  address
+            The simulated board's I2C address.
+*/
+/**************************************************************************/
+sfeSmolPowerMockBoard::sfeSmolPowerMockBoard(byte address)
+{
+  memset(_registers, 0, sizeof(_registers));
+  _address = address;
+  _registers[SFE_SMOL_POWER_REGISTER_I2C_ADDRESS] = address;
+  _registers[SFE_SMOL_POWER_REGISTER_RESET_REASON] = SFE_SMOL_POWER_RESET_REASON_PORF;
+  _registers[SFE_SMOL_POWER_REGISTER_TEMPERATURE] = 300; // ~25C
+  _registers[SFE_SMOL_POWER_REGISTER_VBAT] = 698; // 1.5V: VBAT / 2 with the 1.1V reference
+  _registers[SFE_SMOL_POWER_REGISTER_1V1] = 341; // 1.1V with a 3.3V VCC reference
+  _registers[SFE_SMOL_POWER_REGISTER_ADC_REFERENCE] = SFE_SMOL_POWER_USE_ADC_REF_1V1;
+  _registers[SFE_SMOL_POWER_REGISTER_WDT_PRESCALER] = SFE_SMOL_POWER_WDT_TIMEOUT_8s;
+  _registers[SFE_SMOL_POWER_REGISTER_POWERDOWN_DURATION] = 1;
+  _registers[SFE_SMOL_POWER_REGISTER_FIRMWARE_VERSION] = 0x10; // v1.0
+}
+
+/**************************************************************************/
+/*!
+    @brief  The payload size of a register, from its descriptor.
+    @param  reg
+            The register address.
+    @return The payload size in bytes. 0 if the register does not exist.
+*/
+/**************************************************************************/
+byte sfeSmolPowerMockBoard::payloadSize(byte reg)
+{
+  switch (reg)
+  {
+  case SFE_SMOL_POWER_REGISTER_I2C_ADDRESS: return (sfe_power_board_reg_i2c_address_t::payloadSize);
+  case SFE_SMOL_POWER_REGISTER_RESET_REASON: return (sfe_power_board_reg_reset_reason_t::payloadSize);
+  case SFE_SMOL_POWER_REGISTER_TEMPERATURE: return (sfe_power_board_reg_temperature_t::payloadSize);
+  case SFE_SMOL_POWER_REGISTER_VBAT: return (sfe_power_board_reg_vbat_t::payloadSize);
+  case SFE_SMOL_POWER_REGISTER_1V1: return (sfe_power_board_reg_1v1_t::payloadSize);
+  case SFE_SMOL_POWER_REGISTER_ADC_REFERENCE: return (sfe_power_board_reg_adc_reference_t::payloadSize);
+  case SFE_SMOL_POWER_REGISTER_WDT_PRESCALER: return (sfe_power_board_reg_wdt_prescaler_t::payloadSize);
+  case SFE_SMOL_POWER_REGISTER_POWERDOWN_DURATION: return (sfe_power_board_reg_powerdown_duration_t::payloadSize);
+  case SFE_SMOL_POWER_REGISTER_POWERDOWN_NOW: return (sfe_power_board_reg_powerdown_now_t::payloadSize);
+  case SFE_SMOL_POWER_REGISTER_FIRMWARE_VERSION: return (sfe_power_board_reg_firmware_version_t::payloadSize);
+  default: return (0);
+  }
+}
+
+/**************************************************************************/
+/*!
+    @brief  Check if writes to a register must carry a CRC, from its descriptor.
+    @param  reg
+            The register address.
+    @return true if the register is writable and CRC-protected.
+*/
+/**************************************************************************/
+bool sfeSmolPowerMockBoard::crcProtected(byte reg)
+{
+  switch (reg)
+  {
+  case SFE_SMOL_POWER_REGISTER_I2C_ADDRESS: return (sfe_power_board_reg_i2c_address_t::crcProtected);
+  case SFE_SMOL_POWER_REGISTER_ADC_REFERENCE: return (sfe_power_board_reg_adc_reference_t::crcProtected);
+  case SFE_SMOL_POWER_REGISTER_WDT_PRESCALER: return (sfe_power_board_reg_wdt_prescaler_t::crcProtected);
+  case SFE_SMOL_POWER_REGISTER_POWERDOWN_DURATION: return (sfe_power_board_reg_powerdown_duration_t::crcProtected);
+  case SFE_SMOL_POWER_REGISTER_POWERDOWN_NOW: return (sfe_power_board_reg_powerdown_now_t::crcProtected);
+  default: return (false);
+  }
+}
+
+/**************************************************************************/
+/*!
+    @brief  Check if writes to a register update eeprom, from its descriptor.
+    @param  reg
+            The register address.
+    @return true if the register is eeprom-backed.
+*/
+/**************************************************************************/
+bool sfeSmolPowerMockBoard::eepromBacked(byte reg)
+{
+  switch (reg)
+  {
+  case SFE_SMOL_POWER_REGISTER_I2C_ADDRESS: return (sfe_power_board_reg_i2c_address_t::writeDelay != 0);
+  case SFE_SMOL_POWER_REGISTER_ADC_REFERENCE: return (sfe_power_board_reg_adc_reference_t::writeDelay != 0);
+  case SFE_SMOL_POWER_REGISTER_WDT_PRESCALER: return (sfe_power_board_reg_wdt_prescaler_t::writeDelay != 0);
+  case SFE_SMOL_POWER_REGISTER_POWERDOWN_DURATION: return (sfe_power_board_reg_powerdown_duration_t::writeDelay != 0);
+  default: return (false);
+  }
+}
+
+/**************************************************************************/
+/*!
+    @brief  Check if the simulated eeprom update is still in progress. Like the ATtiny43U,
+            the board does not respond until it is complete.
+    @return true if the eeprom is being updated.
+*/
+/**************************************************************************/
+bool sfeSmolPowerMockBoard::isEEPROMBusy()
+{
+  if (_eepromBusy && ((millis() - _eepromBusyMillis) >= _eepromUpdateMS))
+    _eepromBusy = false;
+  return (_eepromBusy);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Simulate a write: set the register pointer, then check and store the data.
+            Like the ATtiny43U, frames with the wrong size or CRC are acknowledged but ignored.
+    @param  address
+            The I2C address.
+    @param  registerAddress
+            The register address.
+    @param  data
+            The data bytes. May be NULL if length is 0.
+    @param  length
+            The number of data bytes.
+    @return 0 on success, 2 if the address is not acknowledged (or the eeprom is being updated), or the injected error status.
+*/
+/**************************************************************************/
+byte sfeSmolPowerMockBoard::write(byte address, byte registerAddress, const byte *data, byte length)
+{
+  if (address != _address)
+    return (2);
+  _transactions++;
+  if (isEEPROMBusy())
+    return (2);
+  if (_errors > 0)
+  {
+    _errors--;
+    return (_errorStatus);
+  }
+
+  _pointer = registerAddress;
+  _pointerMillis = millis();
+  if (length == 0) // Register pointer only
+    return (0);
+
+  if (!crcProtected(registerAddress)) // Read-only: ignored
+    return (0);
+
+  byte size = payloadSize(registerAddress);
+  if ((length != (size + 1)) || (sfeSmolPowerCRC8(data, size) != data[size]))
+  {
+    _crcErrors++;
+    return (0);
+  }
+  _lastWrittenRegister = registerAddress;
+
+  if (registerAddress == SFE_SMOL_POWER_REGISTER_POWERDOWN_NOW)
+  {
+    if (memcmp(data, "SLEEP", 5) == 0)
+      _powerDowns++;
+    return (0);
+  }
+
+  uint16_t value = 0;
+  for (byte i = 0; i < size; i++)
+    value |= ((uint16_t)data[i]) << (8 * i);
+  setRegister((sfe_power_board_registers_e)registerAddress, value);
+  if (eepromBacked(registerAddress) && (_eepromUpdateMS > 0))
+  {
+    _eepromBusy = true;
+    _eepromBusyMillis = millis();
+  }
+  return (0);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Simulate a read from the register pointer. Only the addressed register is returned,
+            unless burst reads are enabled (setBurstReads): then the read runs on into the following registers.
+            ADC registers return no data until the conversion time has passed for each ADC register read.
+    @param  address
+            The I2C address.
+    @param  buffer
+            The buffer for the data.
+    @param  length
+            The number of bytes requested.
+    @return The number of bytes read. 0 while the eeprom is being updated.
+*/
+/**************************************************************************/
+byte sfeSmolPowerMockBoard::read(byte address, byte *buffer, byte length)
+{
+  if (address != _address)
+    return (0);
+  _transactions++;
+  if (isEEPROMBusy())
+    return (0);
+  if (_shortReads > 0)
+  {
+    _shortReads--;
+    return (0);
+  }
+
+  // Serialize the registers from the pointer onwards, little endian
+  byte count = 0;
+  byte conversions = 0;
+  byte last = _burstReads ? SFE_SMOL_POWER_MOCK_REGISTERS : (byte)(_pointer + 1);
+  for (byte reg = _pointer; (reg < last) && (reg < SFE_SMOL_POWER_MOCK_REGISTERS) && (count < length); reg++)
+  {
+    if ((reg >= SFE_SMOL_POWER_REGISTER_TEMPERATURE) && (reg <= SFE_SMOL_POWER_REGISTER_1V1))
+      conversions++;
+    byte size = payloadSize(reg);
+    for (byte i = 0; (i < size) && (count < length); i++)
+      buffer[count++] = (size <= 2) ? (byte)(_registers[reg] >> (8 * i)) : 0;
+  }
+
+  if ((millis() - _pointerMillis) < (_conversionMS * conversions)) // Still converting
+    return (0);
+  return (count);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Simulate addressing the board without any data.
+    @param  address
+            The I2C address.
+    @return 0 if the board is at address, 2 if not (or the eeprom is being updated), or the injected error status.
+*/
+/**************************************************************************/
+byte sfeSmolPowerMockBoard::probe(byte address)
+{
+  if (address != _address)
+    return (2);
+  _transactions++;
+  if (isEEPROMBusy())
+    return (2);
+  if (_errors > 0)
+  {
+    _errors--;
+    return (_errorStatus);
+  }
+  return (0);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Set a register's payload, e.g. to simulate a battery voltage.
+            Setting I2C_ADDRESS also moves the board to the new address.
+    @param  reg
+            The register.
+    @param  value
+            The payload.
+*/
+/**************************************************************************/
+void sfeSmolPowerMockBoard::setRegister(sfe_power_board_registers_e reg, uint16_t value)
+{
+  if ((byte)reg >= SFE_SMOL_POWER_MOCK_REGISTERS)
+    return;
+  _registers[reg] = value;
+  if (reg == SFE_SMOL_POWER_REGISTER_I2C_ADDRESS)
+    _address = (byte)value;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Get a register's payload, e.g. to check what the library wrote.
+    @param  reg
+            The register.
+    @return The payload. 0 if the register does not exist.
+*/
+/**************************************************************************/
+uint16_t sfeSmolPowerMockBoard::getRegister(sfe_power_board_registers_e reg)
+{
+  if ((byte)reg >= SFE_SMOL_POWER_MOCK_REGISTERS)
+    return (0);
+  return (_registers[reg]);
+}
+
+/**************************************************************************/
+/*!
+    @brief  The board's current I2C address.
+    @return The address.
+*/
+/**************************************************************************/
+byte sfeSmolPowerMockBoard::getAddress()
+{
+  return (_address);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Set the time each ADC register takes to convert. Reads of ADC registers
+            return no data until this time has passed since the register pointer was written.
+    @param  ms
+            The conversion time per ADC register in ms. 0 for instant conversions.
+*/
+/**************************************************************************/
+void sfeSmolPowerMockBoard::setConversionTime(unsigned long ms)
+{
+  _conversionMS = ms;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Set the time the ATtiny43U takes to update its eeprom. After a valid write to an
+            eeprom-backed register, the board does not acknowledge its address until this time has passed.
+    @param  ms
+            The eeprom update time in ms. 0 (default) for instant updates.
+*/
+/**************************************************************************/
+void sfeSmolPowerMockBoard::setEEPROMUpdateTime(unsigned long ms)
+{
+  _eepromUpdateMS = ms;
+  if (ms == 0)
+    _eepromBusy = false;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Make the next writes / probes fail.
+    @param  count
+            The number of writes / probes to fail.
+    @param  status
+            The status to return: 2 address NACK, 3 data NACK, 4 other error.
+*/
+/**************************************************************************/
+void sfeSmolPowerMockBoard::injectErrors(byte count, byte status)
+{
+  _errors = count;
+  _errorStatus = status;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Make the next reads return no data.
+    @param  count
+            The number of reads to fail.
+*/
+/**************************************************************************/
+void sfeSmolPowerMockBoard::injectShortReads(byte count)
+{
+  _shortReads = count;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Simulate firmware which supports burst reads.
+    @param  enable
+            True: reads run on into the following registers. False (default): only the addressed register is returned.
+*/
+/**************************************************************************/
+void sfeSmolPowerMockBoard::setBurstReads(bool enable)
+{
+  _burstReads = enable;
+}
+
+/**************************************************************************/
+/*!
+    @brief  The number of valid SLEEP commands received.
+    @return The count.
+*/
+/**************************************************************************/
+unsigned long sfeSmolPowerMockBoard::getPowerDownCount()
+{
+  return (_powerDowns);
+}
+
+/**************************************************************************/
+/*!
+    @brief  The number of writes ignored because of a bad frame size or CRC.
+    @return The count.
+*/
+/**************************************************************************/
+unsigned long sfeSmolPowerMockBoard::getCRCErrorCount()
+{
+  return (_crcErrors);
+}
+
+/**************************************************************************/
+/*!
+    @brief  The number of writes, reads and probes addressed to this board.
+    @return The count.
+*/
+/**************************************************************************/
+unsigned long sfeSmolPowerMockBoard::getTransactionCount()
+{
+  return (_transactions);
+}
+
+/**************************************************************************/
+/*!
+    @brief  The register of the last accepted write with a payload (a valid frame and CRC).
+            Register pointer writes are not included. Use this to check the order of writes.
+    @return The register address, or 0xFF if no payload has been written.
+*/
+/**************************************************************************/
+byte sfeSmolPowerMockBoard::getLastWrittenRegister()
+{
+  return (_lastWrittenRegister);
+}
+
+#endif // SFE_SMOL_POWER_MOCK_BOARD
+
+//-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
+#ifdef SFE_SMOL_POWER_TRANSPORT_LINUX
+
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <linux/i2c.h>
+#include <linux/i2c-dev.h>
+
+/**************************************************************************/
+/*!
+    @brief  Open the I2C bus.
+    @param  device
+            The bus device, e.g. /dev/i2c-1.
+    @return true if the bus was opened.
+*/
+/**************************************************************************/
+bool sfeSmolPowerLinuxI2C::begin(const char *device)
+{
+  end();
+  _fd = open(device, O_RDWR);
+  return (_fd >= 0);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Close the I2C bus.
+*/
+/**************************************************************************/
+void sfeSmolPowerLinuxI2C::end()
+{
+  if (_fd >= 0)
+    close(_fd);
+  _fd = -1;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Perform one I2C_RDWR transaction.
+    @param  messages
+            The struct i2c_msg array.
+    @param  count
+            The number of messages.
+    @return 0 on success, 2 if the address was not acknowledged, 4 for any other error.
+*/
+/**************************************************************************/
+byte sfeSmolPowerLinuxI2C::transfer(void *messages, int count)
+{
+  if (_fd < 0)
+    return (4);
+  struct i2c_rdwr_ioctl_data transaction;
+  transaction.msgs = (struct i2c_msg *)messages;
+  transaction.nmsgs = count;
+  if (ioctl(_fd, I2C_RDWR, &transaction) >= 0)
+    return (0);
+  if ((errno == ENXIO) || (errno == EREMOTEIO)) // No acknowledge
+    return (2);
+  return (4);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Write the register address and the data in a single transaction.
+    @param  address
+            The I2C address.
+    @param  registerAddress
+            The register address.
+    @param  data
+            The data bytes. May be NULL if length is 0.
+    @param  length
+            The number of data bytes.
+    @return 0 on success, 2 if the address was not acknowledged, 4 for any other error.
+*/
+/**************************************************************************/
+byte sfeSmolPowerLinuxI2C::write(byte address, byte registerAddress, const byte *data, byte length)
+{
+  byte frame[I2C_BUFFER_LENGTH];
+  if (length >= I2C_BUFFER_LENGTH)
+    return (4);
+  frame[0] = registerAddress;
+  if (length > 0)
+    memcpy(&frame[1], data, length);
+
+  struct i2c_msg message;
+  message.addr = address;
+  message.flags = 0;
+  message.len = length + 1;
+  message.buf = frame;
+  return (transfer(&message, 1));
+}
+
+/**************************************************************************/
+/*!
+    @brief  Read from the device in a single transaction.
+    @param  address
+            The I2C address.
+    @param  buffer
+            The buffer for the data.
+    @param  length
+            The number of bytes to read.
+    @return The number of bytes read: length on success, 0 on failure.
+*/
+/**************************************************************************/
+byte sfeSmolPowerLinuxI2C::read(byte address, byte *buffer, byte length)
+{
+  struct i2c_msg message;
+  message.addr = address;
+  message.flags = I2C_M_RD;
+  message.len = length;
+  message.buf = buffer;
+  return ((transfer(&message, 1) == 0) ? length : 0);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Address the device without any data. Adapters which do not support
+            zero-length writes are probed with a one-byte read instead.
+    @param  address
+            The I2C address.
+    @return 0 if the device acknowledged, 2 if not, 4 for any other error.
+*/
+/**************************************************************************/
+byte sfeSmolPowerLinuxI2C::probe(byte address)
+{
+  struct i2c_msg message;
+  message.addr = address;
+  message.flags = 0;
+  message.len = 0;
+  message.buf = NULL;
+  byte result = transfer(&message, 1);
+  if (result != 4)
+    return (result);
+
+  byte discard;
+  message.flags = I2C_M_RD;
+  message.len = 1;
+  message.buf = &discard;
+  return (transfer(&message, 1));
+}
+
+#endif // SFE_SMOL_POWER_TRANSPORT_LINUX
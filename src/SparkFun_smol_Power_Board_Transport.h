@@ -0,0 +1,218 @@
+/*!
+ * @file SparkFun_smol_Power_Board_Transport.h
+ *
+ * SparkFun smôl Power Board Arduino Library
+ *
+ * This library facilitates communication with the smôl Power Boards over I<sup>2</sup>C.
+ *
+ * Want to support open source hardware? Buy a board from SparkFun!
+ * <br>SparkX smôl Power Board LiPo (SPX-18622): https://www.sparkfun.com/products/18622
+ * <br>SparkX smôl Power Board AAA (SPX-18621): https://www.sparkfun.com/products/18621
+ * <br>SparkX smôl ESP32 (SPX-18619): https://www.sparkfun.com/products/18619
+ *
+ * This library was written by:
+ * Paul Clark
+ * SparkFun Electronics
+ * July 23rd 2021
+ *
+ * Please see LICENSE.md for the license information
+ *
+ */
+
+#ifndef __SFE_SMOL_POWER_BOARD_TRANSPORT__
+#define __SFE_SMOL_POWER_BOARD_TRANSPORT__
+
+#include "SparkFun_smol_Power_Board_Platform.h"
+
+#include "SparkFun_smol_Power_Board_Constants.h"
+#include "SparkFun_smol_Power_Board_Registers.h"
+
+/** The transports. SMOL_POWER_BOARD_IO holds one sfe_power_board_transport_t, selected at compile time
+    (see SparkFun_smol_Power_Board_Constants.h), so there are no virtual calls. Each transport provides:
+
+    typedef ... port_t;                       The port passed to begin: TwoWire, sfeSmolPowerMockBoard or sfeSmolPowerLinuxI2C
+    void begin(port_t &port);
+    byte write(byte address, byte registerAddress, const byte *data, byte length);
+                                              Write the register address, then length data bytes. Returns 0 on success,
+                                              or the TwoWire endTransmission status: 2 address NACK, 3 data NACK, 4 other error
+    byte read(byte address, byte *buffer, byte length);
+                                              Read up to length bytes. Returns the number of bytes read
+    byte probe(byte address);                 Address the device without any data. Returns the status as for write
+    static const bool signalsNotReady;        True if read can return fewer bytes than requested, e.g. when the ATtiny43U
+                                              has no data ready. The adaptive ADC settle time needs this */
+
+//-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
+#ifdef SFE_SMOL_POWER_TRANSPORT_TWOWIRE
+
+/** The Arduino TwoWire transport */
+class sfeSmolPowerTransportTwoWire
+{
+public:
+  typedef TwoWire port_t;
+  static const bool signalsNotReady = true; // requestFrom returns the number of bytes received. 0xFF padding is caught by the 10-bit check
+
+  void begin(TwoWire &port) { _i2cPort = &port; }
+
+  byte write(byte address, byte registerAddress, const byte *data, byte length)
+  {
+    _i2cPort->beginTransmission(address);
+    _i2cPort->write(registerAddress);
+    for (byte i = 0; i < length; i++)
+      _i2cPort->write(data[i]);
+    return (_i2cPort->endTransmission()); // Send data and release the bus (the 43 (WireS) doesn't like it if the Controller holds the bus!)
+  }
+
+  byte read(byte address, byte *buffer, byte length)
+  {
+    byte bytesReturned = _i2cPort->requestFrom(address, length);
+    for (byte i = 0; i < bytesReturned; i++)
+      buffer[i] = _i2cPort->read();
+    return (bytesReturned);
+  }
+
+  byte probe(byte address)
+  {
+    _i2cPort->beginTransmission(address);
+    return (_i2cPort->endTransmission());
+  }
+
+private:
+  TwoWire *_i2cPort = nullptr;
+};
+
+typedef sfeSmolPowerTransportTwoWire sfe_power_board_transport_t;
+#define SFE_SMOL_POWER_DEFAULT_PORT Wire ///< The default port for begin
+
+#endif
+
+//-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
+/** A transport for ports which implement write, read and probe themselves: the mock board and the Linux I2C bus */
+template <class Port>
+class sfeSmolPowerPortTransport
+{
+public:
+  typedef Port port_t;
+  static const bool signalsNotReady = Port::signalsNotReady;
+
+  void begin(Port &port) { _port = &port; }
+  byte write(byte address, byte registerAddress, const byte *data, byte length) { return (_port->write(address, registerAddress, data, length)); }
+  byte read(byte address, byte *buffer, byte length) { return (_port->read(address, buffer, length)); }
+  byte probe(byte address) { return (_port->probe(address)); }
+
+private:
+  Port *_port = nullptr;
+};
+
+//-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
+#ifdef SFE_SMOL_POWER_MOCK_BOARD
+
+#define SFE_SMOL_POWER_MOCK_REGISTERS 10 ///< The number of ATtiny43U registers simulated by sfeSmolPowerMockBoard
+
+/** An in-memory simulation of the smôl Power Board's ATtiny43U, for testing the library on any host.
+    Register writes are checked against the register descriptors: the frame size and the CRC.
+    Reads return the register at the register pointer. Firmware with burst reads, which run on into
+    the following registers, can be simulated with setBurstReads.
+    Errors, short reads, the ADC conversion time and the eeprom update time can be injected. */
+class sfeSmolPowerMockBoard
+{
+public:
+  /** @brief Create a simulated board at address, with typical register values */
+  sfeSmolPowerMockBoard(byte address = SFE_SMOL_POWER_DEFAULT_I2C_ADDRESS);
+
+  static const bool signalsNotReady = true; // ADC registers return no data while converting
+
+  // The transport interface
+  byte write(byte address, byte registerAddress, const byte *data, byte length);
+  byte read(byte address, byte *buffer, byte length);
+  byte probe(byte address);
+
+  // The simulation
+  void setRegister(sfe_power_board_registers_e reg, uint16_t value); // Set a register's payload. I2C_ADDRESS also changes the board's address
+  uint16_t getRegister(sfe_power_board_registers_e reg);
+  byte getAddress(); // The board's current I2C address
+  void setConversionTime(unsigned long ms); // ADC registers return no data until ms after the register pointer was written
+  void setEEPROMUpdateTime(unsigned long ms); // The board NACKs for ms after a write to an eeprom-backed register
+  void injectErrors(byte count, byte status = 2); // The next count writes / probes fail with status (2 = address NACK)
+  void injectShortReads(byte count); // The next count reads return no data
+  void setBurstReads(bool enable); // Reads run on into the following registers. Off by default
+  unsigned long getPowerDownCount(); // The number of valid SLEEP commands received
+  unsigned long getCRCErrorCount(); // The number of writes ignored because of a bad frame size or CRC
+  unsigned long getTransactionCount(); // The number of writes, reads and probes addressed to this board
+  byte getLastWrittenRegister(); // The register of the last accepted write with a payload. 0xFF if none
+
+private:
+  static byte payloadSize(byte reg);
+  static bool crcProtected(byte reg);
+  static bool eepromBacked(byte reg);
+  bool isEEPROMBusy();
+
+  byte _address;
+  byte _pointer = 0;
+  unsigned long _pointerMillis = 0;
+  uint16_t _registers[SFE_SMOL_POWER_MOCK_REGISTERS];
+  unsigned long _conversionMS = 0;
+  byte _errors = 0;
+  byte _errorStatus = 2;
+  byte _shortReads = 0;
+  bool _burstReads = false;
+  unsigned long _powerDowns = 0;
+  unsigned long _crcErrors = 0;
+  unsigned long _transactions = 0;
+  byte _lastWrittenRegister = 0xFF;
+  unsigned long _eepromUpdateMS = 0;
+  unsigned long _eepromBusyMillis = 0;
+  bool _eepromBusy = false;
+};
+
+#endif
+
+#ifdef SFE_SMOL_POWER_TRANSPORT_MOCK
+
+typedef sfeSmolPowerPortTransport<sfeSmolPowerMockBoard> sfe_power_board_transport_t;
+
+#endif
+
+//-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
+
+#ifdef SFE_SMOL_POWER_TRANSPORT_LINUX
+
+/** A Linux I2C bus (/dev/i2c-*). Each write and read is a single I2C_RDWR transaction.
+    A read returns all of the requested bytes or none, so the ATtiny43U cannot signal that its data is not ready:
+    the adaptive ADC settle time is not available */
+class sfeSmolPowerLinuxI2C
+{
+public:
+  /** @brief Create a closed bus. Call begin to open it */
+  sfeSmolPowerLinuxI2C() {}
+  ~sfeSmolPowerLinuxI2C() { end(); }
+
+  static const bool signalsNotReady = false;
+
+  bool begin(const char *device = "/dev/i2c-1"); // Open the bus. Returns false if the device could not be opened
+  void end();
+
+  // The transport interface
+  byte write(byte address, byte registerAddress, const byte *data, byte length);
+  byte read(byte address, byte *buffer, byte length);
+  byte probe(byte address);
+
+private:
+  sfeSmolPowerLinuxI2C(const sfeSmolPowerLinuxI2C &) = delete; // The bus owns its file descriptor
+  sfeSmolPowerLinuxI2C &operator=(const sfeSmolPowerLinuxI2C &) = delete;
+
+  byte transfer(void *messages, int count);
+
+  int _fd = -1;
+};
+
+typedef sfeSmolPowerPortTransport<sfeSmolPowerLinuxI2C> sfe_power_board_transport_t;
+
+#endif
+
+/** The port type passed to begin */
+typedef sfe_power_board_transport_t::port_t sfe_power_board_port_t;
+
+#endif // /__SFE_SMOL_POWER_BOARD_TRANSPORT__